@@ -253,23 +253,25 @@ void AgApp::StartMulticast()
   // Schedule multicast flow
   //
 
-  for(pkt_id_t i{0}; i < m_config->GetPerBlockPacketCount(); i++) {
-    RdmaTxQueuePair::SendRequest sr;
+  const pkt_id_t pkt_count{m_config->GetPerBlockPacketCount()};
+  if(pkt_count == 0) {
+    return;
+  }
+  std::vector<RdmaTxQueuePair::SendRequest> srs(pkt_count);
+
+  for(pkt_id_t i{0}; i < pkt_count; i++) {
+    RdmaTxQueuePair::SendRequest& sr{srs[i]};
     sr.payload_size = m_mcast.sq->GetMTU();
     sr.dip = Ipv4Address(m_config->GetMulticastGroup());
     sr.dport = m_config->GetPort(AgPort::Multicast);
     sr.multicast = true;
     sr.imm = m_config->GetMcastImmData(m_runtime->GetBlock(), i);
-
-    const bool last{i == m_config->GetPerBlockPacketCount() - 1};
-    if(last) {
-      sr.on_send = [this]() {
-        OnMulticastTransmissionEnd();
-      };
-    }
-
-    m_mcast.sq->PostSend(sr);
   }
+
+  // One post for the whole block, notified once the last packet is sent
+  m_mcast.sq->PostSendBatch(srs, [this]() {
+    OnMulticastTransmissionEnd();
+  });
 }
 
 void AgApp::OnMulticastTransmissionEnd()
@@ -278,8 +280,7 @@ void AgApp::OnMulticastTransmissionEnd()
 
   NS_LOG_LOGIC(m_runtime->GetBlock() << " hands over next multicast source");
 
-  RdmaTxQueuePair::SendRequest sr;
-  m_chain.right.sq->PostSend(sr);
+  m_chain.right.sq->PostSend({});
 }
 
 void AgApp::StartRecoveryPhase()
@@ -301,7 +302,7 @@ void AgApp::StartRecoveryPhase()
     };
   }
 
-  m_recovery.left.sq->PostSend(recover_request);
+  m_recovery.left.sq->PostSend(std::move(recover_request));
 }
 
 void AgApp::StopApplication()
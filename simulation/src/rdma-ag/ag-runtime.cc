@@ -290,7 +290,7 @@ void AgRuntime::TryUpdateState()
           TryUpdateState();
         };
 
-        recovery_sq->PostSend(sr);
+        recovery_sq->PostSend(std::move(sr));
       }
       else {
         NS_LOG_LOGIC(m_block << " cannot send block " << block);
@@ -2,6 +2,7 @@
 #include "ns3/rdma-network.h"
 #include "ns3/rdma-hw.h"
 #include "ns3/qbb-net-device.h"
+#include <memory>
 
 namespace ns3 {
 
@@ -54,9 +55,10 @@ void RdmaFlowBisection::StartFlow(RdmaNetwork& network, OnComplete on_complete)
     const size_t n_servers_per_half = n_servers / 2;
 
     // Stops when all bisection RDMA Write have completed.
-    auto on_single_write_complete = [on_complete, n_servers_per_half, n_write_complete=0]() mutable {
-        n_write_complete++;
-        if(n_write_complete == n_servers_per_half) {
+    // The count is shared, because each write gets its own copy of the callback.
+    auto on_single_write_complete = [on_complete, n_servers_per_half, n_write_complete=std::make_shared<size_t>(0)]() {
+        (*n_write_complete)++;
+        if(*n_write_complete == n_servers_per_half) {
             on_complete();
         }
     };
@@ -83,50 +85,58 @@ void RdmaFlowBisection::StartWrite(Ptr<Node> initiator, Ptr<Node> target, OnComp
     const Ptr<RdmaHw> src_rdma{initiator->GetObject<RdmaHw>()};
     const Ptr<RdmaHw> dst_rdma{target->GetObject<RdmaHw>()};
 
-    // Create the RDMA Write request.
-    RdmaTxQueuePair::SendRequest sr;
-    sr.payload_size = m_bytes_to_write;
-    sr.multicast = false;
-    sr.dip = dst_ip;          // Only useful for UD QP.
-    sr.dport = dst_port;      // Only useful for UD QP.
-    sr.on_send = on_complete; // Notify completion.
+    Ptr<RdmaTxQueuePair> src_tx_queue;
+    Ptr<RdmaRxQueuePair> src_rx_queue;
+    Ptr<RdmaTxQueuePair> dst_tx_queue;
+    Ptr<RdmaRxQueuePair> dst_rx_queue;
 
     // Create the queues on the source.
-    {
-        Ptr<RdmaTxQueuePair> src_tx_queue;
-        Ptr<RdmaRxQueuePair> src_rx_queue;
-
-        if(m_reliable) {
-            src_tx_queue = CreateObject<RdmaReliableSQ>(initiator, m_priority, src_ip, src_port, dst_ip, dst_port);
-            src_rx_queue = CreateObject<RdmaReliableRQ>(DynamicCast<RdmaReliableSQ>(src_tx_queue));
-        }
-        else {
-            src_tx_queue = CreateObject<RdmaUnreliableSQ>(initiator, m_priority, src_ip, src_port);
-            src_rx_queue = CreateObject<RdmaUnreliableRQ>(DynamicCast<RdmaUnreliableSQ>(src_tx_queue));
-        }
-        
-        src_rdma->RegisterQP(src_tx_queue, src_rx_queue);
-
-        // Post the send request on the source.
-        src_tx_queue->PostSend(sr);
+    if(m_reliable) {
+        src_tx_queue = CreateObject<RdmaReliableSQ>(initiator, m_priority, src_ip, src_port, dst_ip, dst_port);
+        src_rx_queue = CreateObject<RdmaReliableRQ>(DynamicCast<RdmaReliableSQ>(src_tx_queue));
+    }
+    else {
+        src_tx_queue = CreateObject<RdmaUnreliableSQ>(initiator, m_priority, src_ip, src_port);
+        src_rx_queue = CreateObject<RdmaUnreliableRQ>(DynamicCast<RdmaUnreliableSQ>(src_tx_queue));
     }
+    
+    src_rdma->RegisterQP(src_tx_queue, src_rx_queue);
 
     // Create the queues on the destination.
-    {
-        Ptr<RdmaTxQueuePair> dst_tx_queue;
-        Ptr<RdmaRxQueuePair> dst_rx_queue;
-        
-        if(m_reliable) {
-            dst_tx_queue = CreateObject<RdmaReliableSQ>(target, m_priority, dst_ip, dst_port, src_ip, src_port);
-            dst_rx_queue = CreateObject<RdmaReliableRQ>(DynamicCast<RdmaReliableSQ>(dst_tx_queue));
-        }
-        else {
-            dst_tx_queue = CreateObject<RdmaUnreliableSQ>(target, m_priority, dst_ip, dst_port);
-            dst_rx_queue = CreateObject<RdmaUnreliableRQ>(DynamicCast<RdmaUnreliableSQ>(dst_tx_queue));
-        }
+    if(m_reliable) {
+        dst_tx_queue = CreateObject<RdmaReliableSQ>(target, m_priority, dst_ip, dst_port, src_ip, src_port);
+        dst_rx_queue = CreateObject<RdmaReliableRQ>(DynamicCast<RdmaReliableSQ>(dst_tx_queue));
+    }
+    else {
+        dst_tx_queue = CreateObject<RdmaUnreliableSQ>(target, m_priority, dst_ip, dst_port);
+        dst_rx_queue = CreateObject<RdmaUnreliableRQ>(DynamicCast<RdmaUnreliableSQ>(dst_tx_queue));
+    }
 
-        dst_rdma->RegisterQP(dst_tx_queue, dst_rx_queue);
+    dst_rdma->RegisterQP(dst_tx_queue, dst_rx_queue);
+
+    // Connect the QPs, now that the QPNs are known.
+    if(m_reliable) {
+        DynamicCast<RdmaReliableSQ>(src_tx_queue)->SetDestQpn(dst_tx_queue->GetQpn());
+        DynamicCast<RdmaReliableSQ>(dst_tx_queue)->SetDestQpn(src_tx_queue->GetQpn());
     }
+
+    // Create the RDMA Write request.
+    RdmaTxQueuePair::SendRequest sr;
+    sr.payload_size = m_bytes_to_write;
+    sr.multicast = false;
+    sr.dip = dst_ip;                     // Only useful for UD QP.
+    sr.dport = dst_port;                 // Only useful for UD QP.
+    sr.dqpn = dst_tx_queue->GetQpn();    // Only useful for UD QP.
+    sr.on_send = on_complete;            // Notify completion.
+
+    // In a distributed simulation, the write completes on the process of the initiator (see `RdmaConfig::partitioner`).
+    if(!IsLocalNode(initiator)) {
+        Simulator::ScheduleNow(on_complete);
+        return;
+    }
+
+    // Post the send request on the source.
+    src_tx_queue->PostSend(std::move(sr));
 }
 
 } // namespace ns3
\ No newline at end of file
@@ -78,7 +78,12 @@ void RdmaFlowMulticast::StartFlow(RdmaNetwork& network, OnComplete on_complete)
         src_rdma->RegisterQP(src_tx_queue, src_rx_queue);
 
         // Post the send request on the source.
-        src_tx_queue->PostSend(sr);
+        src_tx_queue->PostSend(std::move(sr));
+    }
+
+    // In a distributed simulation, the flow completes on the process of the source (see `RdmaConfig::partitioner`).
+    if(!IsLocalNode(snode) && on_complete) {
+        Simulator::ScheduleNow(on_complete);
     }
 
     // For each node in the destination multicast group.
@@ -97,6 +102,9 @@ void RdmaFlowMulticast::StartFlow(RdmaNetwork& network, OnComplete on_complete)
         }
 
         dst_rdma->RegisterQP(dst_tx_queue, dst_rx_queue);
+
+        // The source does not know the QPN of the receivers, they are reached by the port.
+        dst_rdma->BindPort(dst_tx_queue);
     }
 }
 
@@ -41,6 +41,11 @@ TypeId RdmaFlowUnicast::GetTypeId()
       "If true, uses RC QP. If false, uses UD QP",
       &RdmaFlowUnicast::m_reliable);
 
+    AddUintegerAttribute(tid,
+      "CcMode",
+      "Congestion control of the source QP (see `RdmaHw::CcMode`). Zero to use the one of the NIC.",
+      &RdmaFlowUnicast::m_cc_mode);
+
     return tid;
   }();
   
@@ -59,50 +64,78 @@ void RdmaFlowUnicast::StartFlow(RdmaNetwork& network, OnComplete on_complete)
     const Ptr<RdmaHw> dst_rdma{dnode->GetObject<RdmaHw>()};
     
 
-    // Create the RDMA Write request.
-    RdmaTxQueuePair::SendRequest sr;
-    sr.payload_size = m_bytes_to_write;
-    sr.multicast = false;
-    sr.dip = dst_ip;          // Only useful for UD QP.
-    sr.dport = dst_port;      // Only useful for UD QP.
-    sr.on_send = on_complete; // Notify completion.
+    Ptr<RdmaTxQueuePair> src_tx_queue;
+    Ptr<RdmaRxQueuePair> src_rx_queue;
+    Ptr<RdmaTxQueuePair> dst_tx_queue;
+    Ptr<RdmaRxQueuePair> dst_rx_queue;
 
     // Create the queues on the source.
-    {
-        Ptr<RdmaTxQueuePair> src_tx_queue;
-        Ptr<RdmaRxQueuePair> src_rx_queue;
+    if(m_reliable) {
+        src_tx_queue = CreateObject<RdmaReliableSQ>(snode, m_priority, src_ip, src_port, dst_ip, dst_port);
+        src_rx_queue = CreateObject<RdmaReliableRQ>(DynamicCast<RdmaReliableSQ>(src_tx_queue));
+    }
+    else {
+        src_tx_queue = CreateObject<RdmaUnreliableSQ>(snode, m_priority, src_ip, src_port);
+        src_rx_queue = CreateObject<RdmaUnreliableRQ>(DynamicCast<RdmaUnreliableSQ>(src_tx_queue));
+    }
+    
+    src_rdma->RegisterQP(src_tx_queue, src_rx_queue);
+    if(m_cc_mode != 0) {
+        src_rdma->SetCcMode(src_tx_queue, m_cc_mode);
+    }
 
-        if(m_reliable) {
-            src_tx_queue = CreateObject<RdmaReliableSQ>(snode, m_priority, src_ip, src_port, dst_ip, dst_port);
-            src_rx_queue = CreateObject<RdmaReliableRQ>(DynamicCast<RdmaReliableSQ>(src_tx_queue));
-        }
-        else {
-            src_tx_queue = CreateObject<RdmaUnreliableSQ>(snode, m_priority, src_ip, src_port);
-            src_rx_queue = CreateObject<RdmaUnreliableRQ>(DynamicCast<RdmaUnreliableSQ>(src_tx_queue));
-        }
-        
-        src_rdma->RegisterQP(src_tx_queue, src_rx_queue);
+    // Create the queues on the destination.
+    if(m_reliable) {
+        dst_tx_queue = CreateObject<RdmaReliableSQ>(dnode, m_priority, dst_ip, dst_port, src_ip, src_port);
+        dst_rx_queue = CreateObject<RdmaReliableRQ>(DynamicCast<RdmaReliableSQ>(dst_tx_queue));
+    }
+    else {
+        dst_tx_queue = CreateObject<RdmaUnreliableSQ>(dnode, m_priority, dst_ip, dst_port);
+        dst_rx_queue = CreateObject<RdmaUnreliableRQ>(DynamicCast<RdmaUnreliableSQ>(dst_tx_queue));
+    }
+
+    dst_rdma->RegisterQP(dst_tx_queue, dst_rx_queue);
 
-        // Post the send request on the source.
-        src_tx_queue->PostSend(sr);
+    // Connect the QPs, now that the QPNs are known.
+    if(m_reliable) {
+        DynamicCast<RdmaReliableSQ>(src_tx_queue)->SetDestQpn(dst_tx_queue->GetQpn());
+        DynamicCast<RdmaReliableSQ>(dst_tx_queue)->SetDestQpn(src_tx_queue->GetQpn());
     }
 
-    // Create the queues on the destination.
-    {
-        Ptr<RdmaTxQueuePair> dst_tx_queue;
-        Ptr<RdmaRxQueuePair> dst_rx_queue;
-        
-        if(m_reliable) {
-            dst_tx_queue = CreateObject<RdmaReliableSQ>(dnode, m_priority, dst_ip, dst_port, src_ip, src_port);
-            dst_rx_queue = CreateObject<RdmaReliableRQ>(DynamicCast<RdmaReliableSQ>(dst_tx_queue));
-        }
-        else {
-            dst_tx_queue = CreateObject<RdmaUnreliableSQ>(dnode, m_priority, dst_ip, dst_port);
-            dst_rx_queue = CreateObject<RdmaUnreliableRQ>(DynamicCast<RdmaUnreliableSQ>(dst_tx_queue));
-        }
+    // In a distributed simulation, the flow completes on the process of the source,
+    // the other processes only need the QPs (see `RdmaConfig::partitioner`).
+    if(!IsLocalNode(snode)) {
+        Simulator::ScheduleNow(on_complete);
+        return;
+    }
 
-        dst_rdma->RegisterQP(dst_tx_queue, dst_rx_queue);
+    // Create the RDMA Write request.
+    RdmaTxQueuePair::SendRequest sr;
+    sr.payload_size = m_bytes_to_write;
+    sr.multicast = false;
+    sr.dip = dst_ip;                     // Only useful for UD QP.
+    sr.dport = dst_port;                 // Only useful for UD QP.
+    sr.dqpn = dst_tx_queue->GetQpn();    // Only useful for UD QP.
+
+    // Notify completion, and free the QPNs.
+    // For UD QP, the completion is when the data is sent, so the destination QP is freed
+    // when the data is received.
+    const bool reliable = m_reliable;
+    sr.on_send = [=]() {
+        Simulator::ScheduleNow(&RdmaHw::DestroyQP, src_rdma, src_tx_queue);
+        if(reliable) {
+            Simulator::ScheduleNow(&RdmaHw::DestroyQP, dst_rdma, dst_tx_queue);
+        }
+        on_complete();
+    };
+    if(!m_reliable) {
+        dst_rx_queue->SetOnRecv([=](RdmaRxQueuePair::RecvNotif) {
+            Simulator::ScheduleNow(&RdmaHw::DestroyQP, dst_rdma, dst_tx_queue);
+        });
     }
+
+    // Post the send request on the source.
+    src_tx_queue->PostSend(std::move(sr));
 }
 
 } // namespace ns3
\ No newline at end of file
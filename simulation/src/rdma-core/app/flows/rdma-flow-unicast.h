@@ -26,6 +26,8 @@ private:
     uint16_t m_priority{};
     //! If true, uses RC QP. If false, uses UD QP.
     bool m_reliable{};
+    //! Congestion control of the source QP (see `RdmaCcMode`), or zero for the one of the NIC.
+    uint32_t m_cc_mode{};
 };
 
 } // namespace ns3
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include "ns3/rdma-network.h"
 #include "ns3/rdma-reliable-qp.h"
 #include "ns3/rdma-hw.h"
+#include "ns3/switch-node.h"
 
 namespace ns3 {
 
@@ -32,12 +33,88 @@ RdmaModStats::~RdmaModStats()
     struct Stats
     {
         Time stop_time;
+        std::string scheduler; //!< See `RdmaConfig::scheduler`, to compare the run times.
+        uint64_t events{}; //!< Events executed by the simulator.
+        double run_wall_seconds{};
+        double events_per_second{};
+        uint64_t posted_wrs{}; //!< Send requests posted by all the servers.
+        uint64_t transmit_triggers{}; //!< Transmit requests of the SQs, before coalescing.
+        uint64_t transmit_events{}; //!< Transmit events scheduled by the NICs.
+        double transmit_events_per_wr{};
+        uint64_t tx_payload_bytes{}; //!< Payload sent by the RC QPs, including retransmissions.
+        uint64_t retx_payload_bytes{}; //!< Payload retransmitted by the RC QPs.
+        uint64_t goodput_bytes{}; //!< Payload of the RC QPs ACKed by the receivers.
+        double goodput_gbps{};
+        uint64_t qpc_hits{}; //!< Zero unless the QPC cache is modelled (see `RdmaHw::QpcCacheEntries`).
+        uint64_t qpc_misses{};
+        uint64_t mtt_hits{};
+        uint64_t mtt_misses{};
+        uint64_t timer_arms{}; //!< QP timers armed or re-armed (see `RdmaTimerWheel`).
+        uint64_t timer_cancels{};
+        uint64_t timer_events{}; //!< Simulator events scheduled by the timer wheels, for the QP timers or the ticks.
+        uint64_t timer_events_pending_max{}; //!< Peak of the QP timer events in the scheduler, cancelled or not.
+        std::string partitioner; //!< See `RdmaConfig::partitioner`.
+        uint32_t system_id{}; //!< MPI process of these statistics, which only count its nodes.
+        uint32_t systems{};
+        uint32_t cut_links{}; //!< Links between two processes.
+        double cut_gbps{};
+        Time lookahead; //!< Smallest latency of the links between two processes.
     };
 
     Stats stats;
     stats.stop_time = Simulator::Now();
+    stats.scheduler = RdmaNetwork::GetInstance().GetConfig().scheduler;
+    stats.events = Simulator::GetEventCount();
+    stats.run_wall_seconds = RdmaNetwork::GetInstance().GetRunWallSeconds();
+    if(stats.run_wall_seconds > 0) {
+        stats.events_per_second = stats.events / stats.run_wall_seconds;
+    }
 
-    const fs::path out_json_path{RdmaNetwork::GetInstance().GetConfig().FindFile(m_json_out)};
+    for(Ptr<Node> server : RdmaNetwork::GetInstance().GetAllServers()) {
+        ForEachDevice(server, [&](Ptr<QbbNetDevice> dev) {
+            const QbbNetDevice::TxTriggerStats& tx{dev->GetTxTriggerStats()};
+            stats.posted_wrs += tx.posted_wrs;
+            stats.transmit_triggers += tx.triggers;
+            stats.transmit_events += tx.events;
+        });
+
+        const RdmaHw::RcStats rc{server->GetObject<RdmaHw>()->GetRcStats()};
+        stats.tx_payload_bytes += rc.tx_bytes;
+        stats.retx_payload_bytes += rc.retx_bytes;
+        stats.goodput_bytes += rc.acked_bytes;
+
+        const RdmaNicCaches& caches{server->GetObject<RdmaHw>()->GetNicCaches()};
+        stats.qpc_hits += caches.qpc.GetStats().hits;
+        stats.qpc_misses += caches.qpc.GetStats().misses;
+        stats.mtt_hits += caches.mtt.GetStats().hits;
+        stats.mtt_misses += caches.mtt.GetStats().misses;
+
+        const RdmaTimerWheel::Stats& timers{server->GetObject<RdmaHw>()->GetTimerWheel().GetStats()};
+        stats.timer_arms += timers.arms;
+        stats.timer_cancels += timers.cancels;
+        stats.timer_events += timers.events;
+    }
+    stats.timer_events_pending_max = RdmaTimerWheel::GetSchedulerStats().maxPending;
+    if(stats.posted_wrs > 0) {
+        stats.transmit_events_per_wr = double(stats.transmit_events) / stats.posted_wrs;
+    }
+    if(stats.stop_time.IsStrictlyPositive()) {
+        stats.goodput_gbps = stats.goodput_bytes * 8.0 / stats.stop_time.GetNanoSeconds();
+    }
+
+    const RdmaPartition& partition{RdmaNetwork::GetInstance().GetPartition()};
+    stats.partitioner = RdmaNetwork::GetInstance().GetConfig().partitioner;
+    stats.system_id = RdmaNetwork::GetInstance().GetSystemId();
+    stats.systems = partition.loads.size();
+    stats.cut_links = partition.cut_links;
+    stats.cut_gbps = partition.cut_bandwidth / 1e9;
+    stats.lookahead = partition.lookahead;
+
+    fs::path out_json_path{RdmaNetwork::GetInstance().GetConfig().FindFile(m_json_out)};
+    if(stats.systems > 1) {
+        // One file per process, `stats.json` becomes `stats.1.json`
+        out_json_path.replace_filename(out_json_path.stem().string() + "." + std::to_string(stats.system_id) + out_json_path.extension().string());
+    }
     std::ofstream ofs{out_json_path};
     ofs << rfl::json::write(stats);
 }
@@ -19,7 +19,7 @@ class RdmaReliableSQ;
  * 
  * The available columns in the records are:
  * - node: Source node.
- * - lkey: Source QP key.
+ * - lkey: Source QPN.
  * - time: Time data is gather.
  * - lowest_unacked_psn: Lowest unacked PSN.
  * - lowest_unsent_psn: Lowest unsent PSN.
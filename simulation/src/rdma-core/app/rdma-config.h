@@ -6,6 +6,7 @@
 #include "ns3/filesystem.h"
 #include <vector>
 #include <memory>
+#include <string>
 
 namespace ns3 {
 
@@ -130,6 +131,20 @@ public:
     //! Use the same seed to have the same simulation.
 	uint32_t rng_seed{50};
 
+    //! TypeId of the event scheduler of the simulator, for example `ns3::MapScheduler` (the default of ns3),
+    //! `ns3::HeapScheduler`, `ns3::CalendarScheduler` or `ns3::RdmaLadderScheduler`.
+    std::string scheduler{"ns3::MapScheduler"};
+
+    //! Partitioning of the nodes among the MPI processes, when run with `mpirun -np N`:
+    //!  - `none`: MPI is not used, each process runs the whole simulation.
+    //!  - `min-cut`: see `PartitionTopology()`. Needs ns3 built with MPI.
+    //!
+    //! The completion of a flow is only known by the process of its source, so the processes reduce
+    //! their completions every few lookaheads, and all stop once all the foreground flows have completed
+    //! (see `RdmaNetwork::PollCompletion()`), up to two polls after the last one.
+    //! Each process runs the modules, on the events of its nodes.
+    std::string partitioner{"none"};
+
     //! ECN various thresholds configuration.
 	std::vector<EcnConfigEntry> ecn;
 
@@ -7,14 +7,88 @@
 #include "ns3/internet-stack-helper.h"
 #include "ns3/ipv4-global-routing-helper.h"
 #include "ns3/rdma-flow-scheduler.h"
+#include "ns3/object-factory.h"
 #include <array>
+#include <chrono>
 #include <type_traits>
 #include <cmath>
 
+#ifdef NS3_MPI
+# include "ns3/mpi-interface.h"
+#endif
+
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE("RdmaNetwork");
 
+namespace {
+
+//! Period of `RdmaNetwork::PollCompletion()`, in lookaheads of the partition.
+constexpr int64_t completion_poll_lookaheads{10};
+
+#ifdef NS3_MPI
+/**
+ * Non-blocking reductions of the completions of the processes, for `RdmaNetwork::PollCompletion()`.
+ *
+ * Each process computes its own lookahead, so the processes do not poll within the same window
+ * of the distributed simulator: a blocking reduction could wait for a process that waits for
+ * the next window. So the reductions are on their own communicator, each poll starts one,
+ * and the next poll completes it: all the processes started it by then (see `RdmaNetwork::PollCompletion()`).
+ */
+class CompletionReduction
+{
+public:
+  void Init()
+  {
+    MPI_Comm_dup(MpiInterface::GetCommunicator(), &m_comm);
+  }
+
+  //! Starts a reduction of {running, completion time} with the other processes.
+  void Start(bool running, Time completion)
+  {
+    m_local[0] = running;
+    m_local[1] = running ? 0 : completion.GetTimeStep();
+    MPI_Iallreduce(m_local, m_global, 2, MPI_INT64_T, MPI_MAX, m_comm, &m_request);
+  }
+
+  /**
+   * Completes the last reduction started, if any.
+   * @return Whether it found that all the processes completed.
+   */
+  bool Wait()
+  {
+    if(m_request == MPI_REQUEST_NULL) {
+      return false;
+    }
+    MPI_Wait(&m_request, MPI_STATUS_IGNORE);
+    return m_global[0] == 0;
+  }
+
+  //! Completion time of the last process, once `Wait()` returned true.
+  Time GetGlobalCompletion() const
+  {
+    return TimeStep(m_global[1]);
+  }
+
+  //! Completes the last reduction, all the processes stopped after the same poll.
+  void Finish()
+  {
+    Wait();
+    MPI_Comm_free(&m_comm);
+  }
+
+private:
+  MPI_Comm m_comm{MPI_COMM_NULL};
+  MPI_Request m_request{MPI_REQUEST_NULL};
+  int64_t m_local[2]{};
+  int64_t m_global[2]{}; //!< Maximum over the processes.
+};
+
+CompletionReduction completion_reduction;
+#endif
+
+} // namespace
+
 bool RdmaNetwork::m_initialized = false;
 
 void RdmaNetwork::Initialize(const fs::path& config_path)
@@ -26,6 +100,17 @@ void RdmaNetwork::Initialize(const fs::path& config_path)
 	const auto config = RdmaConfig::from_file(config_path);
 	NS_LOG_INFO("Config: " << rfl::json::write(*config));
 	config->ApplyDefaultAttributes();
+
+  // Enabling MPI selects the distributed simulator, so it is done before the simulator is created.
+  const bool distributed{config->partitioner != "none"};
+  if(distributed) {
+#ifdef NS3_MPI
+    MpiInterface::Enable(nullptr, nullptr);
+#else
+    NS_ABORT_MSG("Partitioner '" << config->partitioner << "' needs ns3 built with MPI");
+#endif
+  }
+	Simulator::SetScheduler(ObjectFactory{config->scheduler});
   
   if(!config->simulator_stop_time.IsZero()) {
 	  Simulator::Stop(config->simulator_stop_time);
@@ -43,20 +128,69 @@ void RdmaNetwork::Initialize(const fs::path& config_path)
 
   // Load flows.
 	FlowScheduler flow_scheduler{instance, config->FindFile(config->flows_file)};
-	flow_scheduler.SetOnAllFlowsCompleted([]() {
+	flow_scheduler.SetOnAllFlowsCompleted([&instance, distributed]() {
+		// The other processes may still have flows to complete, see `PollCompletion()`
+		if(distributed) {
+			NS_LOG_INFO("Local foreground flows completed at " << Simulator::Now().GetSeconds() << "s.");
+			instance.m_localCompletion = Simulator::Now();
+			return;
+		}
 		NS_LOG_INFO("Simulation stopped at " << Simulator::Now().GetSeconds() << "s.");
 		Simulator::Stop();
 	});
 
+#ifdef NS3_MPI
+  if(distributed) {
+    completion_reduction.Init();
+
+    // The processes already synchronize at each lookahead, so poll less often.
+    // At least the largest lookahead of the processes, see `PollCompletion()`.
+    const Time lookahead{instance.m_partition.lookahead};
+    Time period{lookahead.IsStrictlyPositive() && lookahead != Time::Max() ? lookahead * completion_poll_lookaheads : MicroSeconds(10)};
+    period = Max(period, instance.m_partition.max_cut_latency);
+    Simulator::Schedule(period, &RdmaNetwork::PollCompletion, &instance, period);
+  }
+#endif
+
   // Run the simulation.
 	NS_LOG_INFO("Running Simulation.");
+	const auto run_start = std::chrono::steady_clock::now();
 	Simulator::Run();
+	instance.m_runWallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - run_start).count();
   NS_LOG_INFO("Exit stopped at " << Simulator::Now().GetSeconds() << "s.");
 
+#ifdef NS3_MPI
+  if(distributed) {
+    completion_reduction.Finish();
+  }
+#endif
+
   // Permits to modules to get the time of the simulator, before it is destroyed.
   instance.m_modules.clear();
 
 	Simulator::Destroy();
+
+#ifdef NS3_MPI
+  if(MpiInterface::IsEnabled()) {
+    MpiInterface::Disable();
+  }
+#endif
+}
+
+void RdmaNetwork::PollCompletion(Time period)
+{
+#ifdef NS3_MPI
+  // Started by the previous poll, at a time all the processes already reached
+  if(completion_reduction.Wait()) {
+    NS_LOG_INFO("All foreground flows completed at " << completion_reduction.GetGlobalCompletion().GetSeconds() << "s.");
+    NS_LOG_INFO("Simulation stopped at " << Simulator::Now().GetSeconds() << "s.");
+    Simulator::Stop();
+    return;
+  }
+
+  completion_reduction.Start(m_localCompletion == Time::Max(), m_localCompletion);
+  Simulator::Schedule(period, &RdmaNetwork::PollCompletion, this, period);
+#endif
 }
 
 RdmaNetwork& RdmaNetwork::GetInstance()
@@ -71,15 +205,26 @@ void RdmaNetwork::CreateNodes()
 {
   NS_ABORT_MSG_IF(!m_nodes.empty(), "Nodes already created");
 
+  // Assign each node to an MPI process.
+  // All the processes create all the nodes, and compute the same partition.
+  uint32_t systems{1};
+#ifdef NS3_MPI
+  if(MpiInterface::IsEnabled()) {
+    systems = MpiInterface::GetSize();
+  }
+#endif
+  m_partition = PartitionTopology(*m_topology, systems, m_config->partitioner);
+
   NodeContainer n;
 
-	for (const RdmaTopology::Node& node_config : m_topology->nodes) {
-		if (node_config.is_switch) {
-			Ptr<SwitchNode> sw = CreateObject<SwitchNode>();
+	for (size_t i = 0; i < m_topology->nodes.size(); i++) {
+		const uint32_t system_id{m_partition.system_ids[i]};
+		if (m_topology->nodes[i].is_switch) {
+			Ptr<SwitchNode> sw = CreateObject<SwitchNode>(system_id);
 			n.Add(sw);
 		}
 		else {
-			n.Add(CreateObject<Node>());
+			n.Add(CreateObject<Node>(system_id));
 		}
 	}
 
@@ -101,6 +246,16 @@ void RdmaNetwork::AddNode(Ptr<Node> node)
   }
 }
 
+uint32_t RdmaNetwork::GetSystemId() const
+{
+#ifdef NS3_MPI
+  if(MpiInterface::IsEnabled()) {
+    return MpiInterface::GetSystemId();
+  }
+#endif
+  return 0;
+}
+
 Ptr<Node> RdmaNetwork::FindNode(node_id_t id) const
 {
   return m_nodes.at(id);
@@ -167,6 +322,15 @@ void RdmaNetwork::InitConfig(std::shared_ptr<RdmaConfig> config)
 		RdmaEgressQueue::ack_q_idx = 3;
   }
 
+  // The INT header format is the same in the whole network: the one of the default CC of the NICs.
+  // QPs can only select another CC using the same format (see `RdmaHw::SetCcMode()`).
+  TypeId::AttributeInformation cc;
+  NS_ABORT_IF(!RdmaHw::GetTypeId().LookupAttributeByName("CcMode", &cc));
+  IntHeader::mode = GetRdmaCcIntMode(DynamicCast<const UintegerValue>(cc.initialValue)->Get());
+  if (IntHeader::mode == IntHeader::PINT) {
+    IntHeader::pint_bytes = Pint::get_n_bytes();
+  }
+
   // Todo set AckHighPrio
 }
 
@@ -463,6 +627,8 @@ void RdmaNetwork::ConfigureSwitches()
     // By default 1/8 (original project: why?).
     const uint32_t shift{3};
 
+    mmu.ConfigNPort(sw->GetNDevices() - 1);
+
     for (uint32_t j = 1; j < sw->GetNDevices(); j++) {
       Ptr<QbbNetDevice> dev = DynamicCast<QbbNetDevice>(sw->GetDevice(j));
       
@@ -477,14 +643,14 @@ void RdmaNetwork::ConfigureSwitches()
       mmu.ConfigHdrm(j, headroom);
       
       // Init PFC alpha, proportional to link bandwidth.
-      mmu.pfc_a_shift[j] = shift;
-      while(rate > nic_rate && mmu.pfc_a_shift[j] > 0) {
-        mmu.pfc_a_shift[j]--;
+      uint32_t pfc_a_shift{shift};
+      while(rate > nic_rate && pfc_a_shift > 0) {
+        pfc_a_shift--;
         rate /= 2;
       }
+      mmu.ConfigPfcAlphaShift(j, pfc_a_shift);
     }
 
-    mmu.ConfigNPort(sw->GetNDevices() - 1);
     mmu.node_id = sw->GetId();
   }
 }
@@ -511,7 +677,7 @@ void RdmaNetwork::InstallInternet()
 
 Ipv4Address RdmaNetwork::GetNodeIp(node_id_t id)
 {
-	return Ipv4Address(0x0b000001 + ((id / 256) * 0x00010000) + ((id % 256) * 0x00000100));
+	return Ipv4Address(NodeIdToIp(id));
 }
 
 void RdmaNetwork::BuildRoutes()
@@ -608,6 +774,10 @@ void RdmaNetwork::BuildRoutingTables()
 			}
 		}
 	}
+
+  for (const auto& [_, sw] : m_switches) {
+    sw->CompileFib();
+  }
 }
 
 uint64_t RdmaNetwork::GetMtuBytes() const
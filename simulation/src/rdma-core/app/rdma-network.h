@@ -10,6 +10,7 @@
 #include "ns3/rdma-reflection-helper.h"
 #include "ns3/filesystem.h"
 #include "ns3/rdma-config.h"
+#include "ns3/rdma-partitioner.h"
 #include "ns3/data-rate.h"
 #include <map>
 #include <vector>
@@ -112,6 +113,21 @@ public:
   {
     return *m_topology;
   }
+
+  //! Get the wall-clock duration of `Simulator::Run()`, once returned.
+  double GetRunWallSeconds() const
+  {
+    return m_runWallSeconds;
+  }
+
+  //! Get the assignment of the nodes to the MPI processes (see `RdmaConfig::partitioner`).
+  const RdmaPartition& GetPartition() const
+  {
+    return m_partition;
+  }
+
+  //! Get the MPI system ID of this process, zero if MPI is not enabled.
+  uint32_t GetSystemId() const;
   
 private:
   bool HaveAllServersSameBandwidth() const;
@@ -138,6 +154,16 @@ private:
   void BuildP2pInfo();
   void BuildGroups();
 
+  /**
+   * In a distributed simulation, checks each `period` whether the foreground flows of all the processes
+   * have completed, and then stops this process (see `RdmaConfig::partitioner`).
+   * Each poll starts a non-blocking reduction of the completions, and the next poll waits for it.
+   * The `period` is at least the lookahead of each process, so when a process waits at a poll,
+   * its last window already lets all the processes reach the previous poll, without another synchronization.
+   * All the processes then see the same result at the same poll, and all stop at the same time.
+   */
+  void PollCompletion(Time period);
+
 private:
   //! If the singleton is initialized.
   static bool m_initialized;
@@ -167,6 +193,15 @@ private:
   //! Stores which servers belong to which multicast groups.
 	std::map<uint32_t, std::set<node_id_t>> m_mcast_groups;
 
+  //! Wall-clock duration of `Simulator::Run()`.
+  double m_runWallSeconds{};
+
+  //! System ID of each node, and cost of the partition.
+  RdmaPartition m_partition;
+
+  //! In a distributed simulation, when the foreground flows of this process completed, `Time::Max()` until then.
+  Time m_localCompletion{Time::Max()};
+
   //! Aggregate any object.
   //! Useful for extensibility.
   std::vector<Ptr<RdmaConfigModule>> m_modules;
@@ -0,0 +1,354 @@
+#include "ns3/rdma-partitioner.h"
+#include "ns3/abort.h"
+#include "ns3/log.h"
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <numeric>
+#include <queue>
+#include <utility>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("RdmaPartitioner");
+
+namespace {
+
+//! Maximum load of a part, relatively to the mean load.
+constexpr double max_imbalance{1.1};
+
+//! Maximum count of refinement passes over all nodes.
+constexpr uint32_t max_passes{16};
+
+//! Groups of nodes, to merge the endpoints of the links that should not be cut.
+class DisjointSets
+{
+public:
+  explicit DisjointSets(size_t n)
+    : m_parent(n)
+  {
+    std::iota(m_parent.begin(), m_parent.end(), 0);
+  }
+
+  uint32_t Find(uint32_t i)
+  {
+    while(m_parent[i] != i) {
+      m_parent[i] = m_parent[m_parent[i]];
+      i = m_parent[i];
+    }
+    return i;
+  }
+
+  //! The root is the smallest node, so that the groups do not depend on the order of the links.
+  void Merge(uint32_t a, uint32_t b)
+  {
+    a = Find(a);
+    b = Find(b);
+    if(a != b) {
+      m_parent[std::max(a, b)] = std::min(a, b);
+    }
+  }
+
+private:
+  std::vector<uint32_t> m_parent;
+};
+
+//! Graph of the groups of nodes that are partitioned.
+struct GroupGraph
+{
+  std::vector<uint32_t> group_of;                //!< Group of each node.
+  std::vector<double> weight;                    //!< Load of each group.
+  std::vector<std::map<uint32_t, double>> adj;   //!< Bandwidth between two groups.
+};
+
+//! Load of each node: sum of the bandwidth of its ports.
+std::vector<double> NodeLoads(const RdmaTopology& topology)
+{
+  std::vector<double> loads(topology.nodes.size());
+  for(const RdmaTopology::Link& link : topology.links) {
+    loads.at(link.src) += link.bandwidth;
+    loads.at(link.dst) += link.bandwidth;
+  }
+  return loads;
+}
+
+//! Merges the endpoints of the links with a latency below `lookahead`.
+GroupGraph BuildGroups(const RdmaTopology& topology, const std::vector<double>& node_loads, double lookahead)
+{
+  const size_t n{topology.nodes.size()};
+
+  DisjointSets sets{n};
+  for(const RdmaTopology::Link& link : topology.links) {
+    if(link.latency < lookahead) {
+      sets.Merge(link.src, link.dst);
+    }
+  }
+
+  GroupGraph g;
+  g.group_of.resize(n);
+  std::vector<uint32_t> group_of_root(n, UINT32_MAX);
+  for(uint32_t i = 0; i < n; i++) {
+    uint32_t& group{group_of_root[sets.Find(i)]};
+    if(group == UINT32_MAX) {
+      group = g.weight.size();
+      g.weight.push_back(0.0);
+    }
+    g.group_of[i] = group;
+    g.weight[group] += node_loads[i];
+  }
+
+  g.adj.resize(g.weight.size());
+  for(const RdmaTopology::Link& link : topology.links) {
+    const uint32_t a{g.group_of[link.src]};
+    const uint32_t b{g.group_of[link.dst]};
+    if(a != b) {
+      g.adj[a][b] += link.bandwidth;
+      g.adj[b][a] += link.bandwidth;
+    }
+  }
+
+  return g;
+}
+
+//! Maximum load of a part, when packing the heaviest groups first into the lightest part.
+double PackedMaxLoad(std::vector<double> weights, uint32_t parts)
+{
+  std::sort(weights.begin(), weights.end(), std::greater<double>{});
+  std::priority_queue<double, std::vector<double>, std::greater<double>> loads;
+  for(uint32_t p = 0; p < parts; p++) {
+    loads.push(0.0);
+  }
+  double max_load{0.0};
+  for(double w : weights) {
+    const double load{loads.top() + w};
+    loads.pop();
+    loads.push(load);
+    max_load = std::max(max_load, load);
+  }
+  return max_load;
+}
+
+/**
+ * Grows the parts one after the other, from the first group not assigned,
+ * by adding the group the most connected to the part, until the part reaches the mean load.
+ */
+std::vector<uint32_t> GrowParts(const GroupGraph& g, uint32_t parts)
+{
+  const uint32_t n = g.weight.size();
+  const double total{std::accumulate(g.weight.begin(), g.weight.end(), 0.0)};
+
+  std::vector<uint32_t> part_of(n, UINT32_MAX);
+  uint32_t assigned{0};
+  double assigned_weight{0.0};
+
+  for(uint32_t p = 0; p < parts; p++) {
+    // The mean load of the remaining parts
+    const double target{(total - assigned_weight) / (parts - p)};
+    const bool last{p + 1 == parts};
+    double weight{0.0};
+    uint32_t size{0};
+
+    // Connection of the unassigned groups to the part, the stale entries are skipped
+    std::vector<double> conn(n, 0.0);
+    std::priority_queue<std::pair<double, int64_t>> frontier; // (connection, -group)
+    uint32_t next_seed{0};
+
+    while(assigned < n) {
+      uint32_t v{UINT32_MAX};
+      while(!frontier.empty()) {
+        const auto [c, neg_v] = frontier.top();
+        frontier.pop();
+        if(part_of[-neg_v] == UINT32_MAX && c == conn[-neg_v]) {
+          v = -neg_v;
+          break;
+        }
+      }
+      if(v == UINT32_MAX) {
+        // Start, or the part is disconnected from the remaining groups
+        while(part_of[next_seed] != UINT32_MAX) {
+          next_seed++;
+        }
+        v = next_seed;
+      }
+
+      const uint32_t remaining_parts{parts - p - 1};
+      if(!last && size > 0) {
+        // Each remaining part needs a group, and stop at the closest load to the target
+        if(n - assigned <= remaining_parts || weight + g.weight[v] - target > target - weight) {
+          break;
+        }
+      }
+
+      part_of[v] = p;
+      assigned++;
+      size++;
+      weight += g.weight[v];
+      for(const auto& [u, bw] : g.adj[v]) {
+        if(part_of[u] == UINT32_MAX) {
+          conn[u] += bw;
+          frontier.emplace(conn[u], -int64_t{u});
+        }
+      }
+
+      if(!last && weight >= target) {
+        break;
+      }
+    }
+
+    assigned_weight += weight;
+  }
+
+  return part_of;
+}
+
+/**
+ * Moves the groups to the part they are the most connected to, while it decreases the cut bandwidth
+ * and keeps the parts balanced and non-empty.
+ */
+void RefineParts(const GroupGraph& g, uint32_t parts, std::vector<uint32_t>& part_of)
+{
+  const uint32_t n = g.weight.size();
+  const double total{std::accumulate(g.weight.begin(), g.weight.end(), 0.0)};
+  const double max_load{max_imbalance * total / parts};
+
+  std::vector<double> loads(parts, 0.0);
+  std::vector<uint32_t> sizes(parts, 0);
+  for(uint32_t v = 0; v < n; v++) {
+    loads[part_of[v]] += g.weight[v];
+    sizes[part_of[v]]++;
+  }
+
+  std::map<uint32_t, double> conn;
+  for(uint32_t pass = 0; pass < max_passes; pass++) {
+    bool moved{false};
+
+    for(uint32_t v = 0; v < n; v++) {
+      const uint32_t from{part_of[v]};
+      if(sizes[from] == 1) {
+        continue;
+      }
+
+      conn.clear();
+      for(const auto& [u, bw] : g.adj[v]) {
+        conn[part_of[u]] += bw;
+      }
+      const double internal{conn.count(from) ? conn[from] : 0.0};
+
+      uint32_t best{from};
+      double best_gain{0.0};
+      for(const auto& [to, bw] : conn) {
+        const double gain{bw - internal};
+        if(to != from && gain > best_gain && loads[to] + g.weight[v] <= max_load) {
+          best = to;
+          best_gain = gain;
+        }
+      }
+
+      if(best != from) {
+        part_of[v] = best;
+        loads[from] -= g.weight[v];
+        loads[best] += g.weight[v];
+        sizes[from]--;
+        sizes[best]++;
+        moved = true;
+      }
+    }
+
+    if(!moved) {
+      break;
+    }
+  }
+}
+
+//! Fills the statistics of the partition from the system IDs.
+void Evaluate(const RdmaTopology& topology, const std::vector<double>& node_loads, uint32_t parts, RdmaPartition& partition)
+{
+  partition.loads.assign(parts, 0.0);
+  for(size_t i = 0; i < node_loads.size(); i++) {
+    partition.loads[partition.system_ids[i]] += node_loads[i];
+  }
+
+  partition.cut_bandwidth = 0.0;
+  partition.cut_links = 0;
+  partition.lookahead = Time::Max();
+  partition.max_cut_latency = Time{};
+  for(const RdmaTopology::Link& link : topology.links) {
+    if(partition.system_ids[link.src] != partition.system_ids[link.dst]) {
+      partition.cut_bandwidth += link.bandwidth;
+      partition.cut_links++;
+      partition.lookahead = Min(partition.lookahead, Seconds(link.latency));
+      partition.max_cut_latency = Max(partition.max_cut_latency, Seconds(link.latency));
+    }
+  }
+}
+
+} // namespace
+
+RdmaPartition PartitionTopology(const RdmaTopology& topology, uint32_t parts)
+{
+  const size_t n{topology.nodes.size()};
+  NS_ABORT_MSG_IF(parts == 0 || parts > n, "Cannot partition " << n << " nodes into " << parts << " systems");
+
+  const std::vector<double> node_loads{NodeLoads(topology)};
+  RdmaPartition partition;
+  partition.system_ids.assign(n, 0);
+
+  if(parts > 1) {
+    // The largest lookahead whose groups can still be balanced: every link below it is kept in a part
+    std::vector<double> latencies;
+    for(const RdmaTopology::Link& link : topology.links) {
+      latencies.push_back(link.latency);
+    }
+    std::sort(latencies.begin(), latencies.end(), std::greater<double>{});
+    latencies.erase(std::unique(latencies.begin(), latencies.end()), latencies.end());
+
+    const double total{std::accumulate(node_loads.begin(), node_loads.end(), 0.0)};
+    GroupGraph g{BuildGroups(topology, node_loads, 0.0)};
+    for(double lookahead : latencies) {
+      GroupGraph candidate{BuildGroups(topology, node_loads, lookahead)};
+      if(candidate.weight.size() >= parts && PackedMaxLoad(candidate.weight, parts) <= max_imbalance * total / parts) {
+        g = std::move(candidate);
+        break;
+      }
+    }
+
+    std::vector<uint32_t> part_of{GrowParts(g, parts)};
+    RefineParts(g, parts, part_of);
+
+    for(size_t i = 0; i < n; i++) {
+      partition.system_ids[i] = part_of[g.group_of[i]];
+    }
+  }
+
+  Evaluate(topology, node_loads, parts, partition);
+
+  NS_LOG_INFO("Partitioned " << n << " nodes into " << parts << " systems: "
+    << partition.cut_links << " cut links, "
+    << partition.cut_bandwidth / 1e9 << " Gbps cut, "
+    << "lookahead " << partition.lookahead.As(Time::NS));
+  for(uint32_t p = 0; p < parts; p++) {
+    NS_LOG_INFO("System " << p << " load: " << partition.loads[p] / 1e9 << " Gbps");
+  }
+  if(partition.cut_links > 0 && partition.lookahead.IsZero()) {
+    NS_LOG_WARN("Links without latency are cut: the systems synchronize at each event");
+  }
+
+  return partition;
+}
+
+RdmaPartition PartitionTopology(const RdmaTopology& topology, uint32_t parts, const std::string& method)
+{
+  if(method == "min-cut") {
+    return PartitionTopology(topology, parts);
+  }
+
+  NS_ABORT_MSG_IF(method != "none", "Unknown partitioner '" << method << "'");
+
+  // All the nodes on the first system
+  RdmaPartition partition;
+  partition.system_ids.assign(topology.nodes.size(), 0);
+  Evaluate(topology, NodeLoads(topology), parts, partition);
+  return partition;
+}
+
+} // namespace ns3
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "ns3/rdma-config.h"
+#include "ns3/nstime.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * Assignment of the nodes of a topology to the MPI processes (system IDs) of a distributed simulation.
+ */
+struct RdmaPartition
+{
+  //! System ID of each node, indexed by node ID.
+  std::vector<uint32_t> system_ids;
+
+  //! Load of each system: sum of the bandwidth of the ports of its nodes, in bits per second.
+  std::vector<double> loads;
+
+  //! Sum of the bandwidth of the links between two systems, in bits per second.
+  double cut_bandwidth{};
+
+  //! Count of the links between two systems.
+  uint32_t cut_links{};
+
+  //! Smallest latency of the links between two systems.
+  //! The systems simulate in parallel the events within this window (lookahead).
+  //! Infinite if no link is cut.
+  Time lookahead;
+
+  //! Largest latency of the links between two systems.
+  //! Bounds the lookahead that the distributed simulator computes for each system.
+  Time max_cut_latency;
+};
+
+/**
+ * Partitions the topology to simulate it with `parts` MPI processes.
+ *
+ * In a conservative distributed simulation, the processes synchronize each time the simulated time
+ * advances by the lookahead, which is the smallest latency of the links between two processes.
+ * A link cut between two processes also makes each of its packets an MPI message.
+ * So, in this order:
+ *  - The links whose latency is below the largest achievable lookahead are never cut:
+ *    their endpoints are merged before partitioning.
+ *  - The parts are balanced by load, estimated by the bandwidth of the ports of the nodes
+ *    (the packets, so the events, are proportional to the bandwidth).
+ *  - The bandwidth of the cut links is minimized: a server stays with its ToR switch, a pod with its aggregation switches...
+ *
+ * The parts are grown from a seed by adding the node the most connected to the part (by bandwidth),
+ * then refined by moving the nodes of the boundary to the neighbour part they are the most connected to (Fiduccia-Mattheyses).
+ * The partition only depends on the topology, so all the processes compute the same one.
+ *
+ * @param parts Count of processes. Crashes if the topology has less nodes.
+ */
+RdmaPartition PartitionTopology(const RdmaTopology& topology, uint32_t parts);
+
+/**
+ * Partitions the topology with the method `method` of `RdmaConfig::partitioner`.
+ * Crashes if the method is unknown.
+ */
+RdmaPartition PartitionTopology(const RdmaTopology& topology, uint32_t parts, const std::string& method);
+
+} // namespace ns3
@@ -89,19 +89,19 @@ void QpMonitor::OnInterval()
       continue;
     }
 
-    for(const auto& [key, sq_base] : hw->GetAllSQs()) {
+    hw->GetQpTable().ForEach([this](const RdmaQpTable::Entry& qp) {
       
       // Monitor only RC QPs
 
-      Ptr<RdmaReliableSQ> sq = DynamicCast<RdmaReliableSQ>(sq_base);
+      Ptr<RdmaReliableSQ> sq = DynamicCast<RdmaReliableSQ>(qp.sq);
       
       if(!sq) {
-        continue;
+        return;
       }
 
       QpRecord record;
       record.node = sq->GetNode()->GetId();
-      record.lkey = key;
+      record.lkey = qp.qpn;
       record.time = Simulator::Now().GetSeconds();
       record.lowest_unacked_psn = sq->GetFirstUnaPSN();
       record.lowest_unsent_psn = sq->GetNextToSendPSN();
@@ -125,7 +125,7 @@ void QpMonitor::OnInterval()
       if(save_record) {
         m_record_writer.write(record);
       }
-    }
+    });
   }
 }
 
@@ -97,8 +97,8 @@ void SwitchBufferMonitor::OnInterval()
       record.iface = if_i;
 
       for (priority_t prio_i{0}; prio_i < SwitchMmu::qCnt; prio_i++) {
-        record.egress_bytes += sw->m_mmu->egress_bytes[if_i][prio_i];
-        record.ingress_bytes += sw->m_mmu->ingress_bytes[if_i][prio_i];
+        record.egress_bytes += sw->m_mmu->GetEgressBytes(if_i, prio_i);
+        record.ingress_bytes += sw->m_mmu->GetIngressBytes(if_i, prio_i);
       }
 
       m_record_writer.write(record);
@@ -0,0 +1,192 @@
+#!/usr/bin/env python3
+"""
+Benchmark of the event schedulers of the simulator (`RdmaConfig::scheduler`).
+
+Runs the same simulation once per scheduler and repetition: a bisection traffic
+(`ns3::RdmaFlowBisection`) over a 3-levels k-ary fat tree. Only the `scheduler` key
+of the configuration changes between the runs.
+The events per second are read from the statistics of `ns3::RdmaModStats`.
+
+The simulations are deterministic, so all the schedulers should execute the same count of events:
+a different count means that two schedulers do not pop the events in the same order.
+
+Usage, from the `simulation` directory, after `./ns3 configure -d optimized`:
+
+    python3 src/rdma-core/bench/scheduler-bench.py --k 8 --repeat 3
+
+The configuration files and the outputs are in `--out` (one directory per run),
+and the summary is printed and written to `--out/summary.json`.
+"""
+
+import argparse
+import json
+import pathlib
+import statistics
+import subprocess as sp
+import sys
+
+SCHEDULERS = [
+    "ns3::MapScheduler",
+    "ns3::HeapScheduler",
+    "ns3::CalendarScheduler",
+    "ns3::RdmaLadderScheduler",
+]
+
+SIMULATION_DIR = pathlib.Path(__file__).resolve().parents[3]
+DEFAULT_CONFIG = SIMULATION_DIR.parent / "rdma-config" / "default-config.json"
+
+
+def make_link(src: int, dst: int, args) -> dict:
+    return {
+        "src": src,
+        "dst": dst,
+        "bandwidth": args.bandwidth,
+        "latency": args.latency,
+        "error_rate": 0.0
+    }
+
+
+def make_fat_tree(args) -> dict:
+    """
+    k-ary fat tree: (k/2)^2 core switches, k pods of k/2 aggregation and k/2 edge switches,
+    and k/2 servers per edge switch.
+    The servers are last, ordered by pod, so that the bisection crosses the core.
+    """
+    k = args.k
+    half = k // 2
+    n_core = half * half
+    first_agg = n_core
+    first_edge = first_agg + k * half
+    first_server = first_edge + k * half
+    n_servers = k * half * half
+
+    nodes = []
+    links = []
+
+    for core in range(n_core):
+        nodes.append({"id": core, "is_switch": True, "pos": {"x": core * 4.0, "y": 12.0}})
+
+    for pod in range(k):
+        for i in range(half):
+            agg = first_agg + pod * half + i
+            nodes.append({"id": agg, "is_switch": True, "pos": {"x": (pod * half + i) * 2.0, "y": 8.0}})
+            # Each aggregation switch connects to its own group of k/2 core switches
+            for j in range(half):
+                links.append(make_link(agg, i * half + j, args))
+
+    for pod in range(k):
+        for i in range(half):
+            edge = first_edge + pod * half + i
+            nodes.append({"id": edge, "is_switch": True, "pos": {"x": (pod * half + i) * 2.0, "y": 4.0}})
+            for j in range(half):
+                links.append(make_link(edge, first_agg + pod * half + j, args))
+
+    for s in range(n_servers):
+        server = first_server + s
+        nodes.append({"id": server, "is_switch": False, "pos": {"x": float(s), "y": 0.0}})
+        links.append(make_link(first_edge + s // half, server, args))
+
+    return {"nodes": nodes, "links": links, "groups": []}
+
+
+def make_flows(args) -> dict:
+    return {
+        "flows": [
+            {
+                "path": "ns3::RdmaFlowBisection",
+                "enable": True,
+                "start_time": 0.0,
+                "in_background": False,
+                "attributes": {
+                    "WriteByteAmount": args.bytes,
+                    "PfcPriority": 3,
+                    "IsReliable": True
+                }
+            }
+        ]
+    }
+
+
+def make_config(args, scheduler: str) -> dict:
+    config = json.loads(args.config.read_text())
+    config["topology_file"] = "topology.json"
+    config["flows_file"] = "flows.json"
+    config["simulator_stop_time"] = 0
+    config["scheduler"] = scheduler
+    # Only the statistics, the other modules would measure their outputs
+    config["modules"] = [
+        {
+            "path": "ns3::RdmaModStats",
+            "enable": True,
+            "attributes": {
+                "JsonOutputFile": "stats.json"
+            }
+        }
+    ]
+    return config
+
+
+def write_json(path: pathlib.Path, data) -> None:
+    path.write_text(json.dumps(data, indent=4))
+
+
+def run(args, run_dir: pathlib.Path, scheduler: str) -> dict:
+    run_dir.mkdir(parents=True, exist_ok=True)
+    write_json(run_dir / "topology.json", make_fat_tree(args))
+    write_json(run_dir / "flows.json", make_flows(args))
+    write_json(run_dir / "config.json", make_config(args, scheduler))
+
+    argv = ["./ns3", "run", "--no-build", f"rdma-ag {(run_dir / 'config.json').as_posix()}"]
+    with open(run_dir / "stdout.txt", "w") as stdout:
+        sp.run(argv, cwd=SIMULATION_DIR, stdout=stdout, stderr=sp.STDOUT, check=True)
+
+    return json.loads((run_dir / "stats.json").read_text())
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="Compare the events per second of the event schedulers.")
+    parser.add_argument("--k", type=int, default=4, help="Arity of the fat tree, even")
+    parser.add_argument("--bytes", type=float, default=10e6, help="Bytes written by each server of the bisection")
+    parser.add_argument("--bandwidth", type=float, default=100e9, help="Bandwidth of the links, in bits per second")
+    parser.add_argument("--latency", type=float, default=1e-6, help="Latency of the links, in seconds")
+    parser.add_argument("--repeat", type=int, default=3, help="Runs per scheduler, the median is reported")
+    parser.add_argument("--schedulers", nargs="+", default=SCHEDULERS)
+    parser.add_argument("--config", type=pathlib.Path, default=DEFAULT_CONFIG, help="Base configuration")
+    parser.add_argument("--out", type=pathlib.Path, default=pathlib.Path("scheduler-bench"))
+    args = parser.parse_args()
+
+    if args.k < 2 or args.k % 2 != 0:
+        parser.error("--k should be even")
+    args.out = args.out.resolve()
+
+    sp.run(["./ns3", "build", "rdma-ag"], cwd=SIMULATION_DIR, check=True)
+
+    summary = []
+    for scheduler in args.schedulers:
+        runs = []
+        for r in range(args.repeat):
+            stats = run(args, args.out / scheduler.split("::")[-1] / str(r), scheduler)
+            runs.append(stats)
+        summary.append({
+            "scheduler": scheduler,
+            "events": runs[0]["events"],
+            "events_per_second": statistics.median(s["events_per_second"] for s in runs),
+            "run_wall_seconds": statistics.median(s["run_wall_seconds"] for s in runs),
+        })
+
+    base = summary[0]["events_per_second"]
+    print(f"Fat tree k={args.k}, bisection of {args.bytes:g} bytes per server, median of {args.repeat} runs")
+    print(f"{'scheduler':<28}{'events':>14}{'events/s':>14}{'wall (s)':>10}{'speedup':>9}")
+    for s in summary:
+        print(f"{s['scheduler']:<28}{s['events']:>14}{s['events_per_second']:>14.0f}"
+              f"{s['run_wall_seconds']:>10.2f}{s['events_per_second'] / base:>9.2f}")
+    write_json(args.out / "summary.json", summary)
+
+    if len({s["events"] for s in summary}) != 1:
+        print("Error: the schedulers did not execute the same count of events", file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
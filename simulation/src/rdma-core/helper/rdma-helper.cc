@@ -1,6 +1,10 @@
 #include "ns3/rdma-helper.h"
 #include <stdexcept>
 
+#ifdef NS3_MPI
+# include "ns3/mpi-interface.h"
+#endif
+
 namespace ns3 {
 
 PeriodicEvent::~PeriodicEvent()
@@ -161,6 +165,16 @@ uint16_t GetNextUniquePort(Ptr<Node> node)
   return tag->GetNextPort();
 }
 
+bool IsLocalNode(Ptr<const Node> node)
+{
+#ifdef NS3_MPI
+  if(MpiInterface::IsEnabled()) {
+    return node->GetSystemId() == MpiInterface::GetSystemId();
+  }
+#endif
+  return true;
+}
+
 uint16_t GetNextMulticastUniquePort()
 {
   // Assumes it doesn't conflict with `GetNextUniquePort()`.
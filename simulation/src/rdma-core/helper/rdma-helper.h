@@ -106,6 +106,31 @@ using byte_t = uint64_t;
 //! PFC priority type.
 using priority_t = uint32_t;
 
+/**
+ * IP address of a node, as an integer.
+ * Node IPs are a function of their global node ID.
+ */
+inline uint32_t NodeIdToIp(node_id_t id)
+{
+  return 0x0b000001 + ((id / 256) * 0x00010000) + ((id % 256) * 0x00000100);
+}
+
+/**
+ * Inverse of `NodeIdToIp()`.
+ * 
+ * @param id Written with the node ID when the function succeeds.
+ * @return false if `ip` is not a node IP (e.g. a multicast group).
+ */
+inline bool IpToNodeId(uint32_t ip, node_id_t& id)
+{
+  if (ip < 0x0b000001) {
+    return false;
+  }
+  const uint32_t x{ip - 0x0b000001};
+  id = (x >> 16) * 256 + ((x >> 8) & 0xff);
+  return NodeIdToIp(id) == ip;
+}
+
 /**
  * Stores nodes mapped by their global node ID.
  * Same as `NodeContainer`, but nodes are indexed by their global node ID and not by their index in the container.
@@ -312,9 +337,19 @@ private:
 
 /*
  * Provides a way to pick a unique port per node.
+ * Wraps around after 65536 ports: the QPs are addressed by QPN, the port is only used
+ * by the QPs bound to it (see `RdmaHw::BindPort()`) and as ECMP entropy.
  */
 uint16_t GetNextUniquePort(Ptr<Node> node);
 
+/**
+ * Whether the node is simulated by this process.
+ * In a distributed simulation (see `RdmaConfig::partitioner`), all the processes create all the nodes,
+ * but each process only simulates the nodes of its system ID.
+ * Always true if MPI is not enabled.
+ */
+bool IsLocalNode(Ptr<const Node> node);
+
 /**
  * Provides a way to pick a globally unique port among all nodes.
  * Multicast port should be the same on each receiver,
@@ -21,8 +21,11 @@
 #include "ns3/enum.h"
 #include "ns3/uinteger.h"
 #include "ns3/double.h"
+#include "ns3/string.h"
 #include "ns3/simulator.h"
-#include "ns3/drop-tail-queue.h"
+#include "ns3/abort.h"
+#include <sstream>
+#include <algorithm>
 #include "broadcom-egress-queue.h"
 
 namespace ns3 {
@@ -36,6 +39,17 @@ NS_OBJECT_ENSURE_REGISTERED(BEgressQueue);
 		static TypeId tid = TypeId("ns3::BEgressQueue")
 			.SetParent<Queue>()
 			.AddConstructor<BEgressQueue>()
+			.AddAttribute("StrictPriority",
+					"Bitmask of the classes with strict priority over the others.",
+					UintegerValue(1),
+					MakeUintegerAccessor(&BEgressQueue::SetStrictPriority),
+					MakeUintegerChecker<uint32_t>(0, (1u << qCnt) - 1))
+			.AddAttribute("DwrrQuantum",
+					"Comma-separated DWRR quantum in bytes of each class. "
+					"Empty for a round-robin of one packet per class.",
+					StringValue(""),
+					MakeStringAccessor(&BEgressQueue::SetDwrrQuantum, &BEgressQueue::GetDwrrQuantum),
+					MakeStringChecker())
 			.AddTraceSource ("BeqEnqueue", "Enqueue a packet in the BEgressQueue. Multiple queue",
 					MakeTraceSourceAccessor (&BEgressQueue::m_traceBeqEnqueue),
 					"ns3::BEgressQueue::TraceBeqEnqueueCallback")
@@ -54,16 +68,15 @@ NS_OBJECT_ENSURE_REGISTERED(BEgressQueue);
 		NS_LOG_FUNCTION(this);
 		m_bytesInQueueTotal = 0;
 		m_rrlast = 0;
+		m_qlast = 0;
+		m_nonEmpty = 0;
+		m_strict = 1;
+		m_dwrr = false;
 		for (uint32_t i = 0; i < qCnt; i++)
 		{
 			m_bytesInQueue[i] = 0;
-
-			auto queue = CreateObject<DropTailQueue<Packet>>();
-			m_queues.push_back(queue);
-
-			// Override DropTailQueue default value of 100 packets
-			// Infinite queue
-			queue->SetMaxSize(QueueSize(QueueSizeUnit::PACKETS, std::numeric_limits<uint32_t>::max()));
+			m_quantum[i] = 0;
+			m_deficit[i] = 0;
 		}
 	}
 
@@ -72,6 +85,47 @@ NS_OBJECT_ENSURE_REGISTERED(BEgressQueue);
 		NS_LOG_FUNCTION(this);
 	}
 
+	void
+		BEgressQueue::SetStrictPriority(uint32_t mask)
+	{
+		m_strict = mask;
+	}
+
+	void
+		BEgressQueue::SetDwrrQuantum(std::string quantum)
+	{
+		m_dwrr = !quantum.empty();
+		std::fill(m_quantum, m_quantum + qCnt, 0);
+		std::fill(m_deficit, m_deficit + qCnt, 0);
+		if (!m_dwrr)
+		{
+			return;
+		}
+
+		std::istringstream ss(quantum);
+		std::string token;
+		uint32_t i = 0;
+		while (std::getline(ss, token, ','))
+		{
+			NS_ABORT_MSG_IF(i >= qCnt, "Too many DWRR quantums: " << quantum);
+			m_quantum[i] = std::stoul(token);
+			NS_ABORT_MSG_IF(m_quantum[i] == 0, "DWRR quantum should be positive: " << quantum);
+			i++;
+		}
+		NS_ABORT_MSG_IF(i != qCnt, "Expected " << qCnt << " DWRR quantums: " << quantum);
+	}
+
+	std::string
+		BEgressQueue::GetDwrrQuantum() const
+	{
+		std::ostringstream ss;
+		for (uint32_t i = 0; m_dwrr && i < qCnt; i++)
+		{
+			ss << (i == 0 ? "" : ",") << m_quantum[i];
+		}
+		return ss.str();
+	}
+
 	bool
 		BEgressQueue::DoEnqueue(Ptr<Packet> p, uint32_t qIndex)
 	{
@@ -80,8 +134,8 @@ NS_OBJECT_ENSURE_REGISTERED(BEgressQueue);
 
 		if (m_bytesInQueueTotal + p->GetSize() < m_maxSize.GetValue())  //infinite queue
 		{
-			// Admission should never fail here
-			NS_ABORT_IF(!m_queues[qIndex]->Enqueue(p));
+			m_queues[qIndex].push_back(p);
+			m_nonEmpty |= 1u << qIndex;
 
 			m_bytesInQueueTotal += p->GetSize();
 			m_bytesInQueue[qIndex] += p->GetSize();
@@ -93,6 +147,42 @@ NS_OBJECT_ENSURE_REGISTERED(BEgressQueue);
 		return true;
 	}
 
+	uint32_t
+		BEgressQueue::NextInMask(uint32_t mask, uint32_t qIndex)
+	{
+		if (mask == 0)
+		{
+			return qCnt;
+		}
+		// Rotate so that bit zero is the class following `qIndex`
+		const uint32_t shift = (qIndex + 1) % qCnt;
+		const uint32_t rotated = ((mask >> shift) | (mask << (qCnt - shift))) & ((1u << qCnt) - 1);
+		return (__builtin_ctz(rotated) + shift) % qCnt;
+	}
+
+	uint32_t
+		BEgressQueue::SelectDwrr(uint32_t eligible)
+	{
+		const uint32_t rr = eligible & ~m_strict;
+		uint32_t qIndex = m_rrlast;
+
+		// Keep serving the current class while its deficit covers its head packet
+		if (((rr >> qIndex) & 1) && m_deficit[qIndex] >= m_queues[qIndex].front()->GetSize())
+		{
+			return qIndex;
+		}
+
+		while (true)
+		{
+			qIndex = NextInMask(rr, qIndex);
+			m_deficit[qIndex] += m_quantum[qIndex];
+			if (m_deficit[qIndex] >= m_queues[qIndex].front()->GetSize())
+			{
+				return qIndex;
+			}
+		}
+	}
+
 	Ptr<Packet>
 		BEgressQueue::DoDequeueRR(bool paused[]) //this is for switch only
 	{
@@ -103,46 +193,57 @@ NS_OBJECT_ENSURE_REGISTERED(BEgressQueue);
 			NS_LOG_LOGIC("Queue empty");
 			return 0;
 		}
-		bool found = false;
-		uint32_t qIndex;
 
-		if (m_queues[0]->GetNPackets() > 0) //0 is the highest priority
+		uint32_t pausedMask = 0;
+		for (uint32_t i = 1; i < qCnt; i++) // the queue zero is never paused
+		{
+			pausedMask |= uint32_t(paused[i]) << i;
+		}
+		const uint32_t eligible = m_nonEmpty & ~pausedMask;
+		if (eligible == 0)
+		{
+			NS_LOG_LOGIC("Nothing can be sent");
+			return 0;
+		}
+
+		uint32_t qIndex;
+		if (eligible & m_strict) //strict priority, lowest index first
+		{
+			qIndex = __builtin_ctz(eligible & m_strict);
+		}
+		else if (m_dwrr)
 		{
-			found = true;
-			qIndex = 0;
+			qIndex = SelectDwrr(eligible);
 		}
 		else
 		{
-			if (!found)
-			{
-				for (qIndex = 1; qIndex <= qCnt; qIndex++)
-				{
-					if (!paused[(qIndex + m_rrlast) % qCnt] && m_queues[(qIndex + m_rrlast) % qCnt]->GetNPackets() > 0)  //round robin
-					{
-						found = true;
-						break;
-					}
-				}
-				qIndex = (qIndex + m_rrlast) % qCnt;
-			}
+			qIndex = NextInMask(eligible, m_rrlast);  //round robin
+		}
+
+		Ptr<Packet> p = m_queues[qIndex].front();
+		m_queues[qIndex].pop_front();
+		m_traceBeqDequeue(p, qIndex);
+		m_bytesInQueueTotal -= p->GetSize();
+		m_bytesInQueue[qIndex] -= p->GetSize();
+
+		const bool strict = (m_strict >> qIndex) & 1;
+		if (m_dwrr && !strict)
+		{
+			m_deficit[qIndex] -= p->GetSize();
 		}
-		if (found)
+		if (m_queues[qIndex].empty())
 		{
-			Ptr<Packet> p = m_queues[qIndex]->Dequeue();
-			m_traceBeqDequeue(p, qIndex);
-			m_bytesInQueueTotal -= p->GetSize();
-			m_bytesInQueue[qIndex] -= p->GetSize();
-			if (qIndex != 0)
-			{
-				m_rrlast = qIndex;
-			}
-			m_qlast = qIndex;
-			NS_LOG_LOGIC("Popped " << p);
-			NS_LOG_LOGIC("Number bytes " << m_bytesInQueueTotal);
-			return p;
+			m_nonEmpty &= ~(1u << qIndex);
+			m_deficit[qIndex] = 0;
 		}
-		NS_LOG_LOGIC("Nothing can be sent");
-		return 0;
+		if (!strict)
+		{
+			m_rrlast = qIndex;
+		}
+		m_qlast = qIndex;
+		NS_LOG_LOGIC("Popped " << p);
+		NS_LOG_LOGIC("Number bytes " << m_bytesInQueueTotal);
+		return p;
 	}
 
 	bool
@@ -220,8 +321,8 @@ NS_OBJECT_ENSURE_REGISTERED(BEgressQueue);
 			NS_LOG_LOGIC("Queue empty");
 			return 0;
 		}
-		NS_LOG_LOGIC("Number bytes " << m_bytesInQueue);
-		return m_queues[0]->Peek();
+		NS_LOG_LOGIC("Number bytes " << m_bytesInQueueTotal);
+		return m_queues[0].empty() ? nullptr : m_queues[0].front();
 	}
 
 	uint32_t
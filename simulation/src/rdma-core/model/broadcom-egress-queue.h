@@ -20,6 +20,8 @@
 #define BROADCOM_EGRESS_H
 
 #include <queue>
+#include <deque>
+#include <string>
 #include <ns3/packet.h>
 #include <ns3/queue.h>
 #include <ns3/drop-tail-queue.h>
@@ -32,6 +34,13 @@ namespace ns3 {
 
 	/**
 	 * @brief Merge multiple queues into one (multi-queue).
+	 * 
+	 * Each priority class is a FIFO of packets. A bitmap of the non-empty classes
+	 * permits to select the next class without visiting every class:
+	 * 
+	 * - Strict priority classes (`StrictPriority` bitmask, by default class zero) are served first, lowest index first.
+	 * - The other classes are served in round-robin. By default, one packet per class.
+	 *   When `DwrrQuantum` is set, they are served in deficit weighted round-robin with the given quantum (in bytes) per class.
 	 */
 	class BEgressQueue : public Queue<Packet> {
 	public:
@@ -45,6 +54,18 @@ namespace ns3 {
 		uint32_t GetNBytesTotal() const;
 		uint32_t GetLastQueue();
 
+		/**
+		 * @param mask Bit `i` is set when class `i` has strict priority.
+		 */
+		void SetStrictPriority(uint32_t mask);
+
+		/**
+		 * @brief Set the DWRR quantum of each class.
+		 * @param quantum Comma-separated quantum in bytes of each class, or empty for a round-robin of one packet per class.
+		 */
+		void SetDwrrQuantum(std::string quantum);
+		std::string GetDwrrQuantum() const;
+
 		using TraceBeqEnqueueCallback = void(*)(Ptr<const Packet> p, uint32_t priority);
 		using TraceBeqDequeueCallback = void(*)(Ptr<const Packet> p, uint32_t priority);
 
@@ -63,6 +84,17 @@ namespace ns3 {
 		 * The exception is the queue zero, which has highest priority over all the other queues.
 		 */
 		Ptr<Packet> DoDequeueRR(bool paused[]);
+
+		/**
+		 * @return The first class set in `mask` after `qIndex` (circularly), or `qCnt` if `mask` is empty.
+		 */
+		static uint32_t NextInMask(uint32_t mask, uint32_t qIndex);
+
+		/**
+		 * @return The class to serve among the non-strict classes of `eligible`, in DWRR.
+		 */
+		uint32_t SelectDwrr(uint32_t eligible);
+
 		//for compatibility
 		bool Enqueue(Ptr<Packet> p) override;
 		Ptr<Packet> Dequeue(void) override;
@@ -72,7 +104,12 @@ namespace ns3 {
 		uint32_t m_bytesInQueueTotal;
 		uint32_t m_rrlast; //!< Like `m_qlast`, but is not updated when the popped index is zero.
 		uint32_t m_qlast;  //!< Last popped queue index.
-		std::vector<Ptr<Queue> > m_queues; // uc queues
+		std::deque<Ptr<Packet>> m_queues[qCnt]; //!< FIFO of each class.
+		uint32_t m_nonEmpty; //!< Bit `i` is set when `m_queues[i]` is not empty.
+		uint32_t m_strict; //!< Bit `i` is set when class `i` has strict priority.
+		uint32_t m_quantum[qCnt]; //!< DWRR quantum in bytes, all zero for a round-robin of one packet per class.
+		uint32_t m_deficit[qCnt]; //!< DWRR deficit counter in bytes.
+		bool m_dwrr; //!< Whether `m_quantum` is set.
 
 		NS_LOG_TEMPLATE_DECLARE;
 	};
@@ -0,0 +1,62 @@
+#ifndef ECMP_HASH_H
+#define ECMP_HASH_H
+
+#include <cstdint>
+
+namespace ns3 {
+
+/**
+ * @brief Seed-independent part of the ECMP hash of a flow.
+ * 
+ * The ECMP hash is a murmur3 of the 12-byte key `{sip, dip, sport | dport << 16}`, seeded per switch.
+ * The scrambling of the key words does not depend on the seed, so it can be computed once by the sender
+ * and carried with the packet. Each switch then only mixes in its own seed with `EcmpHashFinish()`.
+ * The result is identical to hashing the 12-byte key at once with murmur3.
+ */
+struct EcmpFlowKey
+{
+	uint32_t k[3]{};
+};
+
+inline uint32_t EcmpRotl(uint32_t x, int r)
+{
+	return (x << r) | (x >> (32 - r));
+}
+
+inline uint32_t EcmpScramble(uint32_t k)
+{
+	k *= 0xcc9e2d51;
+	k = EcmpRotl(k, 15);
+	k *= 0x1b873593;
+	return k;
+}
+
+inline EcmpFlowKey MakeEcmpFlowKey(uint32_t sip, uint32_t dip, uint16_t sport, uint16_t dport)
+{
+	EcmpFlowKey key;
+	key.k[0] = EcmpScramble(sip);
+	key.k[1] = EcmpScramble(dip);
+	key.k[2] = EcmpScramble(sport | ((uint32_t)dport << 16));
+	return key;
+}
+
+inline uint32_t EcmpHashFinish(const EcmpFlowKey& key, uint32_t seed)
+{
+	uint32_t h = seed;
+	for (uint32_t k : key.k) {
+		h ^= k;
+		h = EcmpRotl(h, 13);
+		h += (h << 2) + 0xe6546b64;
+	}
+	h ^= sizeof(key.k);
+	h ^= h >> 16;
+	h *= 0x85ebca6b;
+	h ^= h >> 13;
+	h *= 0xc2b2ae35;
+	h ^= h >> 16;
+	return h;
+}
+
+} // namespace ns3
+
+#endif /* ECMP_HASH_H */
@@ -0,0 +1,77 @@
+#include "int-tag.h"
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED(IntTag);
+
+TypeId IntTag::GetTypeId()
+{
+	static TypeId tid = TypeId("ns3::IntTag")
+		.SetParent<Tag>()
+		.AddConstructor<IntTag>()
+		;
+	return tid;
+}
+
+TypeId IntTag::GetInstanceTypeId() const
+{
+	return GetTypeId();
+}
+
+void IntTag::Print(std::ostream &os) const
+{
+	if (IntHeader::mode == IntHeader::NORMAL){
+		os << "nhop=" << m_ih.nhop;
+	}else if (IntHeader::mode == IntHeader::PINT){
+		os << "power=" << m_ih.pint.power;
+	}
+}
+
+uint32_t IntTag::GetSerializedSize() const
+{
+	if (IntHeader::mode == IntHeader::NORMAL){
+		return sizeof(m_ih.hop) + sizeof(m_ih.nhop);
+	}else if (IntHeader::mode == IntHeader::PINT){
+		return sizeof(m_ih.pint);
+	}
+	return 0;
+}
+
+void IntTag::Serialize(TagBuffer start) const
+{
+	if (IntHeader::mode == IntHeader::NORMAL){
+		for (uint32_t j = 0; j < IntHeader::maxHop; j++){
+			start.WriteU32(m_ih.hop[j].buf[0]);
+			start.WriteU32(m_ih.hop[j].buf[1]);
+		}
+		start.WriteU16(m_ih.nhop);
+	}else if (IntHeader::mode == IntHeader::PINT){
+		start.WriteU16(m_ih.pint.power);
+	}
+}
+
+void IntTag::Deserialize(TagBuffer start)
+{
+	if (IntHeader::mode == IntHeader::NORMAL){
+		for (uint32_t j = 0; j < IntHeader::maxHop; j++){
+			m_ih.hop[j].buf[0] = start.ReadU32();
+			m_ih.hop[j].buf[1] = start.ReadU32();
+		}
+		m_ih.nhop = start.ReadU16();
+	}else if (IntHeader::mode == IntHeader::PINT){
+		m_ih.pint.power = start.ReadU16();
+	}
+}
+
+void IntTag::ApplyInt(Ptr<const Packet> p, CustomHeader& ch)
+{
+	if (ch.l3Prot != 0x11){
+		return;
+	}
+	IntTag tag;
+	if (p->PeekPacketTag(tag)){
+		ch.udp.ih = tag.m_ih;
+	}
+}
+
+}
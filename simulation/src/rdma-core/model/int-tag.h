@@ -0,0 +1,46 @@
+#ifndef INT_TAG_H
+#define INT_TAG_H
+
+#include <ns3/tag.h>
+#include <ns3/packet.h>
+#include <ns3/int-header.h>
+#include <ns3/custom-header.h>
+
+namespace ns3 {
+
+/**
+ * @brief INT written by the switches on the path of a data packet (HPCC and HPCC-PINT).
+ * 
+ * The switches do not rewrite the `IntHeader` in the buffer of the packet, which would need to remove
+ * and add back the PPP, IPv4, UDP and RDMA headers at every hop.
+ * They update this tag instead, which then replaces the `IntHeader` of the packet.
+ * The receiving NIC merges it in the parsed headers with `ApplyInt()`.
+ * 
+ * The tag has the format of `IntHeader::mode`, and is absent as long as no switch has written in it.
+ */
+class IntTag : public Tag
+{
+public:
+	IntTag() = default;
+
+	static TypeId GetTypeId();
+	TypeId GetInstanceTypeId() const override;
+	void Print(std::ostream &os) const override;
+	uint32_t GetSerializedSize() const override;
+	void Serialize(TagBuffer start) const override;
+	void Deserialize(TagBuffer start) override;
+
+	IntHeader& GetInt() { return m_ih; }
+
+	/**
+	 * @brief Replace the INT of the data packet in `ch`, parsed from the buffer of `p`, by the one of the tag.
+	 */
+	static void ApplyInt(Ptr<const Packet> p, CustomHeader& ch);
+
+private:
+	IntHeader m_ih;
+};
+
+}
+
+#endif /* INT_TAG_H */
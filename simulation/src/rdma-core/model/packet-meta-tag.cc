@@ -0,0 +1,193 @@
+#include "packet-meta-tag.h"
+#include <ns3/header.h>
+#include <ns3/buffer.h>
+
+namespace ns3 {
+
+namespace {
+
+/**
+ * @brief The bytes of the PPP and IPv4 headers up to the IPv4 checksum, to patch the TOS.
+ */
+class EcnPatchHeader : public Header
+{
+public:
+	static TypeId GetTypeId()
+	{
+		static TypeId tid = TypeId("ns3::EcnPatchHeader")
+			.SetParent<Header>()
+			.AddConstructor<EcnPatchHeader>()
+			;
+		return tid;
+	}
+
+	TypeId GetInstanceTypeId() const override
+	{
+		return GetTypeId();
+	}
+
+	void Print(std::ostream& os) const override
+	{
+		os << "tos=" << +GetTos();
+	}
+
+	uint32_t GetSerializedSize() const override
+	{
+		return size;
+	}
+
+	void Serialize(Buffer::Iterator start) const override
+	{
+		start.Write(m_bytes, size);
+	}
+
+	uint32_t Deserialize(Buffer::Iterator start) override
+	{
+		start.Read(m_bytes, size);
+		return size;
+	}
+
+	uint8_t GetTos() const
+	{
+		return m_bytes[tosOffset];
+	}
+
+	/**
+	 * @brief Set the TOS and update the checksum, unless zero (not computed).
+	 * @return false if the TOS is unchanged.
+	 */
+	bool SetTos(uint8_t value)
+	{
+		if (value == m_bytes[tosOffset]) {
+			return false;
+		}
+		const uint16_t checksum = (m_bytes[checksumOffset] << 8) | m_bytes[checksumOffset + 1];
+		if (checksum != 0) {
+			// HC' = ~(~HC + ~m + m'), on the 16 bits word of the version, IHL and TOS
+			const uint16_t m = (m_bytes[tosOffset - 1] << 8) | m_bytes[tosOffset];
+			const uint16_t m2 = (m_bytes[tosOffset - 1] << 8) | value;
+			uint32_t sum = uint16_t(~checksum) + uint16_t(~m) + m2;
+			sum = (sum & 0xFFFF) + (sum >> 16);
+			sum = (sum & 0xFFFF) + (sum >> 16);
+			const uint16_t updated = ~sum;
+			m_bytes[checksumOffset] = updated >> 8;
+			m_bytes[checksumOffset + 1] = updated & 0xFF;
+		}
+		m_bytes[tosOffset] = value;
+		return true;
+	}
+
+private:
+	static constexpr uint32_t tosOffset = 3; //!< After the PPP protocol, and the IPv4 version and IHL.
+	static constexpr uint32_t checksumOffset = 12;
+	static constexpr uint32_t size = checksumOffset + 2;
+
+	uint8_t m_bytes[size]{};
+};
+
+NS_OBJECT_ENSURE_REGISTERED(EcnPatchHeader);
+
+} // namespace
+
+NS_OBJECT_ENSURE_REGISTERED(PacketMetaTag);
+
+PacketMetaTag::PacketMetaTag(uint8_t l3Prot, uint32_t sip, uint32_t dip, uint16_t sport, uint16_t dport, uint16_t pg)
+	: m_l3Prot{l3Prot}, m_sip{sip}, m_dip{dip}, m_sport{sport}, m_dport{dport}, m_pg{pg}
+{
+}
+
+TypeId PacketMetaTag::GetTypeId()
+{
+	static TypeId tid = TypeId("ns3::PacketMetaTag")
+		.SetParent<Tag>()
+		.AddConstructor<PacketMetaTag>()
+		;
+	return tid;
+}
+
+TypeId PacketMetaTag::GetInstanceTypeId() const
+{
+	return GetTypeId();
+}
+
+void PacketMetaTag::Print(std::ostream &os) const
+{
+	os << "l3Prot=" << +m_l3Prot << " tos=" << +m_tos
+		<< " sip=" << m_sip << " dip=" << m_dip
+		<< " sport=" << m_sport << " dport=" << m_dport << " pg=" << m_pg;
+}
+
+uint32_t PacketMetaTag::GetSerializedSize() const
+{
+	return 16;
+}
+
+void PacketMetaTag::Serialize(TagBuffer start) const
+{
+	start.WriteU8(m_l3Prot);
+	start.WriteU8(m_tos);
+	start.WriteU32(m_sip);
+	start.WriteU32(m_dip);
+	start.WriteU16(m_sport);
+	start.WriteU16(m_dport);
+	start.WriteU16(m_pg);
+}
+
+void PacketMetaTag::Deserialize(TagBuffer start)
+{
+	m_l3Prot = start.ReadU8();
+	m_tos = start.ReadU8();
+	m_sip = start.ReadU32();
+	m_dip = start.ReadU32();
+	m_sport = start.ReadU16();
+	m_dport = start.ReadU16();
+	m_pg = start.ReadU16();
+}
+
+void PacketMetaTag::MarkCe(Ptr<Packet> p)
+{
+	EcnPatchHeader h;
+	p->PeekHeader(h);
+	if (h.SetTos(h.GetTos() | CustomHeader::ECN_CE)) {
+		// Nothing is moved: the bytes are written back where they were read
+		p->RemoveAtStart(h.GetSerializedSize());
+		p->AddHeader(h);
+	}
+
+	PacketMetaTag meta;
+	if (p->PeekPacketTag(meta)) {
+		meta.m_tos |= CustomHeader::ECN_CE;
+		p->ReplacePacketTag(meta);
+	}
+}
+
+void PacketMetaTag::FillCustomHeader(CustomHeader& ch) const
+{
+	ch.pppProto = 0x0021;
+	ch.l3Prot = m_l3Prot;
+	ch.m_tos = m_tos;
+	ch.sip = m_sip;
+	ch.dip = m_dip;
+
+	switch (m_l3Prot) {
+		case 0x6:
+			ch.tcp.sport = m_sport;
+			ch.tcp.dport = m_dport;
+			break;
+		case 0x11:
+			ch.udp.sport = m_sport;
+			ch.udp.dport = m_dport;
+			ch.udp.pg = m_pg;
+			break;
+		case 0xFC:
+		case 0xFD:
+			ch.ack.sport = m_sport;
+			ch.ack.dport = m_dport;
+			ch.ack.pg = m_pg;
+			break;
+		default:
+			break;
+	}
+}
+
+}
@@ -0,0 +1,63 @@
+#ifndef PACKET_META_TAG_H
+#define PACKET_META_TAG_H
+
+#include <ns3/object.h>
+#include <ns3/tag.h>
+#include <ns3/custom-header.h>
+#include <ns3/packet.h>
+
+namespace ns3 {
+
+/**
+ * @brief Header fields needed to forward a packet, parsed once by the sender.
+ * 
+ * Added by the NIC when it creates the packet.
+ * Transit switches read it instead of deserializing the PPP/IPv4/L4 headers at every hop,
+ * the receiving NIC still parses the whole header.
+ * 
+ * The ECN bits of the TOS are the only field changed on the path, by `MarkCe()`.
+ */
+class PacketMetaTag : public Tag
+{
+public:
+	PacketMetaTag() = default;
+	PacketMetaTag(uint8_t l3Prot, uint32_t sip, uint32_t dip, uint16_t sport, uint16_t dport, uint16_t pg);
+
+	static TypeId GetTypeId();
+	TypeId GetInstanceTypeId() const override;
+	void Print(std::ostream &os) const override;
+	uint32_t GetSerializedSize() const override;
+	void Serialize(TagBuffer start) const override;
+	void Deserialize(TagBuffer start) override;
+
+	/**
+	 * @brief Write the cached fields in `ch`, as `CustomHeader::Deserialize()` would do.
+	 */
+	void FillCustomHeader(CustomHeader& ch) const;
+
+	uint8_t GetL3Prot() const { return m_l3Prot; }
+	uint8_t GetTos() const { return m_tos; }
+	void SetTos(uint8_t tos) { m_tos = tos; }
+
+	/**
+	 * @brief Mark Congestion Experienced in the IPv4 header of `p`, which starts with the PPP header, and in its tag if any.
+	 *
+	 * Only the first bytes of the headers are rewritten, up to the IPv4 checksum, which is updated incrementally
+	 * (RFC 1624) instead of deserializing and serializing the whole PPP and IPv4 headers.
+	 * The buffer of `p` should not be shared with another packet, else it is copied.
+	 */
+	static void MarkCe(Ptr<Packet> p);
+
+private:
+	uint8_t m_l3Prot{0};
+	uint8_t m_tos{0};
+	uint32_t m_sip{0};
+	uint32_t m_dip{0};
+	uint16_t m_sport{0};
+	uint16_t m_dport{0};
+	uint16_t m_pg{0};
+};
+
+}
+
+#endif /* PACKET_META_TAG_H */
@@ -6,6 +6,27 @@
 
 namespace ns3{
 
+namespace {
+
+// The lookup tables have one entry for each `lut_bits` bits of mantissa (or fraction)
+const int lut_bits = 10;
+
+struct PintLut {
+	int32_t log2_mant[1 << lut_bits]; // log2(1 + i / 2^lut_bits) << lut_shift
+	double exp2_frac[1 << lut_bits]; // 2^(i / 2^lut_bits)
+
+	PintLut(){
+		for (int i = 0; i < (1 << lut_bits); i++){
+			log2_mant[i] = (int32_t)round(log2(1 + double(i) / (1 << lut_bits)) * (1 << Pint::lut_shift));
+			exp2_frac[i] = exp2(double(i) / (1 << lut_bits));
+		}
+	}
+};
+
+const PintLut lut;
+
+}
+
 double Pint::log_base = 1.05;
 double Pint::log_factor = 1 / log(log_base);
 
@@ -41,4 +62,17 @@ double Pint::decode_u(uint16_t p){
 	return pow(log_base, p) / max_concurrent;
 }
 
+int32_t Pint::log2_lut(uint64_t x){
+	const int msb = 63 - __builtin_clzll(x);
+	// the `lut_bits` bits following the MSB, truncated
+	const uint64_t mant = (msb > lut_bits) ? (x >> (msb - lut_bits)) : (x << (lut_bits - msb));
+	return (msb << lut_shift) + lut.log2_mant[mant - (1 << lut_bits)];
+}
+
+double Pint::exp2_lut(int64_t y){
+	const int64_t ip = y >> lut_shift; // floor, also for negative values
+	const int64_t frac = (y - (ip << lut_shift)) >> (lut_shift - lut_bits);
+	return ldexp(lut.exp2_frac[frac], ip);
+}
+
 } /* namespace ns3 */
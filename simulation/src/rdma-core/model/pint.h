@@ -13,6 +13,14 @@ public:
 	static int get_n_bytes();
 	static uint16_t encode_u(double u);
 	static double decode_u(uint16_t p);
+
+	/**
+	 * Fixed-point log2 and exp2 with lookup tables, for the per-packet PINT computation of the switches.
+	 * The fixed-point values are scaled by `1 << lut_shift`.
+	 */
+	static const int lut_shift = 15;
+	static int32_t log2_lut(uint64_t x); // ~log2(x) << lut_shift, for x > 0
+	static double exp2_lut(int64_t y); // ~2^(y / (1 << lut_shift))
 };
 } /* namespace ns3 */
 
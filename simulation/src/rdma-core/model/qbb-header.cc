@@ -49,6 +49,10 @@ namespace ns3 {
 	void qbbHeader::SetIntHeader(const IntHeader &_ih){
 		ih = _ih;
 	}
+	void qbbHeader::SetSack(uint32_t begin, uint32_t end){
+		m_sackBegin = begin;
+		m_sackEnd = end;
+	}
 
 	uint16_t qbbHeader::GetPG() const
 	{
@@ -74,6 +78,12 @@ namespace ns3 {
 	uint8_t qbbHeader::GetCnp() const{
 		return (flags >> FLAG_CNP) & 1;
 	}
+	uint32_t qbbHeader::GetSackBegin() const{
+		return m_sackBegin;
+	}
+	uint32_t qbbHeader::GetSackEnd() const{
+		return m_sackEnd;
+	}
 
 	TypeId
 		qbbHeader::GetTypeId(void)
@@ -99,7 +109,7 @@ namespace ns3 {
 	}
 	uint32_t qbbHeader::GetBaseSize() {
 		qbbHeader tmp;
-		return sizeof(tmp.sport) + sizeof(tmp.dport) + sizeof(tmp.flags) + sizeof(tmp.m_pg) + sizeof(tmp.m_seq);
+		return sizeof(tmp.sport) + sizeof(tmp.dport) + sizeof(tmp.flags) + sizeof(tmp.m_pg) + sizeof(tmp.m_seq) + sizeof(tmp.m_sackBegin) + sizeof(tmp.m_sackEnd);
 	}
 	void qbbHeader::Serialize(Buffer::Iterator start)  const
 	{
@@ -109,6 +119,8 @@ namespace ns3 {
 		i.WriteU16(flags);
 		i.WriteU16(m_pg);
 		i.WriteU32(m_seq);
+		i.WriteU32(m_sackBegin);
+		i.WriteU32(m_sackEnd);
 
 		// write IntHeader
 		ih.Serialize(i);
@@ -122,6 +134,8 @@ namespace ns3 {
 		flags = i.ReadU16();
 		m_pg = i.ReadU16();
 		m_seq = i.ReadU32();
+		m_sackBegin = i.ReadU32();
+		m_sackEnd = i.ReadU32();
 
 		// read IntHeader
 		ih.Deserialize(i);
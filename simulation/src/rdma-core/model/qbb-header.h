@@ -41,6 +41,10 @@ public:
   void SetTs(uint64_t ts);
   void SetCnp();
   void SetIntHeader(const IntHeader &_ih);
+  /**
+   * \brief Selective ACK of a NACK: the receiver has the PSN range [begin, end) out of order.
+   */
+  void SetSack(uint32_t begin, uint32_t end);
 
 //Getters
   /**
@@ -53,6 +57,8 @@ public:
   uint16_t GetDport() const;
   uint64_t GetTs() const;
   uint8_t GetCnp() const;
+  uint32_t GetSackBegin() const;
+  uint32_t GetSackEnd() const;
 
   static TypeId GetTypeId (void);
   TypeId GetInstanceTypeId (void) const override;
@@ -67,6 +73,7 @@ private:
   uint16_t flags{};
   uint16_t m_pg{};
   uint32_t m_seq{}; // the qbb sequence number.
+  uint32_t m_sackBegin{}, m_sackEnd{}; // empty if no SACK
   IntHeader ih;
   
 };
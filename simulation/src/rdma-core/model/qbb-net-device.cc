@@ -38,7 +38,9 @@
 #include "ns3/simulator.h"
 #include "ns3/point-to-point-channel.h"
 #include "ns3/qbb-channel.h"
-#include "ns3/flow-id-tag.h"
+#include "ns3/switch-ingress-tag.h"
+#include "ns3/packet-meta-tag.h"
+#include "ns3/int-tag.h"
 #include "ns3/qbb-header.h"
 #include "ns3/error-model.h"
 #include "ns3/cn-header.h"
@@ -88,46 +90,161 @@ NS_LOG_COMPONENT_DEFINE("QbbNetDevice");
 			return p;
 		}
 		if (qIndex >= 0){ // qp
-			Ptr<Packet> p = m_rdmaGetNxtPkt(m_qpGrp->Get(qIndex));
-			m_rrlast = qIndex;
+			Ptr<RdmaTxQueuePair> qp = m_qpGrp->Get(qIndex);
+			Ptr<Packet> p = m_rdmaHw->GetNxtPacket(qp);
+			m_rrlast = qp->m_sched.order;
 			m_qlast = qIndex;
-			m_traceRdmaDequeue(p, m_qpGrp->Get(qIndex)->GetPG());
+			m_traceRdmaDequeue(p, qp->GetPG());
 			return p;
 		}
 		return 0;
 	}
+
 	int RdmaEgressQueue::GetNextQindex(bool paused[])
 	{
 		NS_LOG_FUNCTION(this);
 
-		bool found = false;
-		uint32_t qIndex;
 		if (!paused[ack_q_idx] && m_ackQ->GetNPackets() > 0) {
 			NS_LOG_LOGIC("Next packet is an ACK");
 			return -1;
 		}
 
 		// no pkt in highest priority queue, do rr for each qp
-		int res = -1024;
-		uint32_t fcount = m_qpGrp->GetN();
-		uint32_t min_finish_id = 0xffffffff;
-		for (qIndex = 1; qIndex <= fcount; qIndex++){
-			uint32_t idx = (qIndex + m_rrlast) % fcount;
-			Ptr<RdmaTxQueuePair> qp = m_qpGrp->Get(idx);
-			if (!paused[qp->GetPG()] && qp->IsReadyToSend()){
-				res = idx;
-				break;
-			}else if (qp->IsFinished()){
-				min_finish_id = idx < min_finish_id ? idx : min_finish_id;
+		WakeExpired();
+		while (true) {
+			// Among the priorities not paused, the first ready SQ after the last one served
+			Ptr<RdmaTxQueuePair> next;
+			for (uint32_t pg = 0; pg < qCnt; pg++) {
+				if (paused[pg] || m_ready[pg].empty()) {
+					continue;
+				}
+				auto it = m_ready[pg].upper_bound(m_rrlast);
+				Ptr<RdmaTxQueuePair> qp = (it != m_ready[pg].end() ? it : m_ready[pg].begin())->second;
+				if (!next || qp->m_sched.order - m_rrlast - 1 < next->m_sched.order - m_rrlast - 1) {
+					next = qp;
+				}
+			}
+
+			if (!next) {
+				return -1024;
+			}
+			if (next->IsReadyToSend()) {
+				if (FetchContexts(next)) {
+					return next->m_sched.index;
+				}
+				continue;
+			}
+
+			// The state changed since the SQ was made ready
+			m_ready[next->GetPG()].erase(next->m_sched.order);
+			Classify(next);
+			NS_ASSERT(next->m_sched.state != SQ_READY);
+		}
+	}
+
+	void RdmaEgressQueue::Classify(Ptr<RdmaTxQueuePair> qp)
+	{
+		NS_LOG_FUNCTION(this << qp);
+		NS_ASSERT(qp->GetPG() < qCnt);
+
+		if (qp->IsFinished()) {
+			qp->m_sched.state = SQ_FINISHED;
+			// Amortize the removal of the finished SQs from the group
+			if (++m_nFinished * 2 > m_qpGrp->GetN()) {
+				int res = -1;
+				m_qpGrp->RemoveFinished(0, m_qpGrp->GetN(), res);
+				m_nFinished = 0;
+			}
+		}else if (!qp->HasDataToSend() || qp->IsWinBound()) {
+			qp->m_sched.state = SQ_IDLE;
+		}else if (qp->GetNextAvailTime() > Simulator::Now()) {
+			qp->m_sched.state = SQ_WAITING;
+			qp->m_sched.wake = qp->GetNextAvailTime();
+			m_timers.push(TimerEntry{qp->m_sched.wake, qp->m_sched.order, qp});
+		}else {
+			qp->m_sched.state = SQ_READY;
+			m_ready[qp->GetPG()].emplace(qp->m_sched.order, qp);
+		}
+	}
+
+	bool RdmaEgressQueue::FetchContexts(Ptr<RdmaTxQueuePair> qp)
+	{
+		if (!m_caches) {
+			return true;
+		}
+		const Time ready = m_caches->AccessTx(qp);
+		if (ready <= Simulator::Now()) {
+			return true;
+		}
+
+		// Only this SQ is stalled, the others can send in the meantime
+		NS_LOG_LOGIC("Context miss for QP " << qp->GetQpn() << ", ready at " << ready);
+		qp->m_nextAvail = Max(qp->m_nextAvail, ready);
+		m_ready[qp->GetPG()].erase(qp->m_sched.order);
+		Classify(qp);
+		return false;
+	}
+
+	bool RdmaEgressQueue::IsValid(const TimerEntry& e) const
+	{
+		return e.qp->m_sched.state == SQ_WAITING && e.qp->m_sched.wake == e.t;
+	}
+
+	void RdmaEgressQueue::WakeExpired()
+	{
+		const Time now = Simulator::Now();
+		while (!m_timers.empty() && m_timers.top().t <= now) {
+			const TimerEntry e = m_timers.top();
+			m_timers.pop();
+			if (IsValid(e)) {
+				Classify(e.qp);
 			}
 		}
+	}
 
-		// clear the finished qp
-		if (min_finish_id < 0xffffffff) {
-			m_qpGrp->RemoveFinished(min_finish_id, fcount, res);
+	void RdmaEgressQueue::UpdateQp(Ptr<RdmaTxQueuePair> qp)
+	{
+		NS_LOG_FUNCTION(this << qp);
+
+		switch (qp->m_sched.state) {
+			case SQ_READY: // validated when selected
+			case SQ_FINISHED:
+				return;
+			case SQ_WAITING:
+				if (qp->GetNextAvailTime() == qp->m_sched.wake) {
+					return;
+				}
+				break;
+			default:
+				break;
 		}
+		Classify(qp);
+	}
 
-		return res;
+	void RdmaEgressQueue::ClearSchedule()
+	{
+		for (uint32_t pg = 0; pg < qCnt; pg++) {
+			for (auto& it : m_ready[pg]) {
+				it.second->m_sched.state = SQ_IDLE;
+			}
+			m_ready[pg].clear();
+		}
+		while (!m_timers.empty()) {
+			m_timers.top().qp->m_sched.state = SQ_IDLE;
+			m_timers.pop();
+		}
+		m_nFinished = 0;
+	}
+
+	Time RdmaEgressQueue::GetNextAvailTime()
+	{
+		while (!m_timers.empty()) {
+			if (IsValid(m_timers.top())) {
+				return m_timers.top().t;
+			}
+			m_timers.pop();
+		}
+		return Simulator::GetMaximumSimulationTime();
 	}
 
 	int RdmaEgressQueue::GetLastQueue(){
@@ -235,6 +352,12 @@ NS_LOG_COMPONENT_DEFINE("QbbNetDevice");
 		NS_LOG_FUNCTION(this);
 	}
 
+	void QbbNetDevice::SetNode(Ptr<Node> node)
+	{
+		PointToPointNetDevice::SetNode(node);
+		m_switch = PeekPointer(DynamicCast<SwitchNode>(node));
+	}
+
 	DataRate QbbNetDevice::GetDataRate() const
 	{
 		return m_bps;
@@ -275,87 +398,80 @@ NS_LOG_COMPONENT_DEFINE("QbbNetDevice");
 		NS_LOG_FUNCTION(this);
 		if (!m_linkUp) return; // if link is down, return
 		if (m_txMachineState == BUSY) return;	// Quit if channel busy
-		Ptr<Packet> p;
-		if (!IsSwitchNode(m_node)) {
-			int qIndex = m_rdmaEQ->GetNextQindex(m_paused);
-			if (qIndex != -1024) {
-				if (qIndex == -1){ // high prio
-					p = m_rdmaEQ->DequeueQindex(qIndex);
-					m_traceDequeue(p, 0);
-					TransmitStart(p);
-					return;
-				}
+		if (m_switch) {
+			DequeueAndTransmitSwitch();
+		}else {
+			DequeueAndTransmitNic();
+		}
+	}
 
-				// a qp dequeue a packet
-				Ptr<RdmaTxQueuePair> lastQp = m_rdmaEQ->GetQp(qIndex);
+	void
+		QbbNetDevice::DequeueAndTransmitNic(void)
+	{
+		Ptr<Packet> p;
+		int qIndex = m_rdmaEQ->GetNextQindex(m_paused);
+		if (qIndex != -1024) {
+			if (qIndex == -1){ // high prio
 				p = m_rdmaEQ->DequeueQindex(qIndex);
+				m_traceDequeue(p, 0);
+				TransmitStart(p);
+				return;
+			}
 
-				// transmit
-				m_traceQpDequeue(p, lastQp);
+			// a qp dequeue a packet
+			Ptr<RdmaTxQueuePair> lastQp = m_rdmaEQ->GetQp(qIndex);
+			p = m_rdmaEQ->DequeueQindex(qIndex);
 
-				TransmitStart(p);
+			// transmit
+			m_traceQpDequeue(p, lastQp);
 
-				// update for the next avail time
-				m_rdmaPktSent(lastQp, p, m_tInterframeGap);
-			}
-			else { // no packet to send
+			TransmitStart(p);
 
-				if(IsAnyTrue(m_paused, 8)) {			
-					NS_LOG_INFO("PAUSE " << BoolsToStr(m_paused, 8) << " prohibits send at node " << m_node->GetId() << " (or no data to send)");
-				}
+			// update for the next avail time
+			m_rdmaHw->PktSent(lastQp, p, m_tInterframeGap);
+		}
+		else { // no packet to send
 
-				Time t = Simulator::GetMaximumSimulationTime();
-				for (uint32_t i = 0; i < m_rdmaEQ->GetFlowCount(); i++){
-					Ptr<RdmaTxQueuePair> qp = m_rdmaEQ->GetQp(i);
-					if(qp->HasDataToSend() && !m_paused[qp->GetPG()]) {
-						t = Min(qp->GetNextAvailTime(), t);
-					}
-				}
+			if(IsAnyTrue(m_paused, 8)) {			
+				NS_LOG_INFO("PAUSE " << BoolsToStr(m_paused, 8) << " prohibits send at node " << m_node->GetId() << " (or no data to send)");
+			}
 
-				if(t < Simulator::Now()) { t = Simulator::Now(); }
-				// if(t < Simulator::GetMaximumSimulationTime()) { t += MicroSeconds(1); }
-				
-				// Multiple QPs with different rate share the same RdmaHW.
-				// Thus, we wan to make sure that a low rate QP will not
-				// limit the rate of a high rate QP.
-				
-				if (t < Simulator::GetMaximumSimulationTime()){
-					UpdateNextAvail(t);
-				}
+			Time t = m_rdmaEQ->GetNextAvailTime();
+
+			if(t < Simulator::Now()) { t = Simulator::Now(); }
+			// if(t < Simulator::GetMaximumSimulationTime()) { t += MicroSeconds(1); }
+			
+			// Multiple QPs with different rate share the same RdmaHW.
+			// Thus, we wan to make sure that a low rate QP will not
+			// limit the rate of a high rate QP.
+			
+			if (t < Simulator::GetMaximumSimulationTime()){
+				UpdateNextAvail(t);
 			}
-			return;
 		}
-		else {   //switch, doesn't care about qcn, just send
-			p = GetQueue()->DequeueRR(m_paused);		//this is round-robin
-			if (p != 0){
-				m_snifferTrace(p);
-				m_promiscSnifferTrace(p);
-				Ipv4Header h;
-				Ptr<Packet> packet = p->Copy();
-				uint16_t protocol = 0;
-				ProcessHeader(packet, protocol);
-				packet->RemoveHeader(h);
-				FlowIdTag t;
-				uint32_t qIndex = GetQueue()->GetLastQueue();
-				if (qIndex == 0){//this is a pause or cnp, send it immediately!
-					SwitchNotifyDequeue(m_node, m_ifIndex, qIndex, p);
-					p->RemovePacketTag(t);
-				}else{
-					SwitchNotifyDequeue(m_node, m_ifIndex, qIndex, p);
-					p->RemovePacketTag(t);
-				}
-				m_traceDequeue(p, qIndex);
-				TransmitStart(p);
-				return;
-			}
-			else { //No queue can deliver any packet
+	}
 
-				if(IsAnyTrue(m_paused, 8)) {		
-					NS_LOG_INFO("PAUSE " << BoolsToStr(m_paused, 8) << " prohibits switch send at node " << m_node->GetId() << " (or no data to send)");
-				}
+	void
+		QbbNetDevice::DequeueAndTransmitSwitch(void)
+	{
+		// switch, doesn't care about qcn, just send
+		Ptr<Packet> p = m_switchQueue->DequeueRR(m_paused);		//this is round-robin
+		if (p != 0){
+			m_snifferTrace(p);
+			m_promiscSnifferTrace(p);
+			uint32_t qIndex = m_switchQueue->GetLastQueue();
+			// The packet may be shared by the egress queues of a multicast,
+			// so the `SwitchIngressTag` is not removed here but replaced by the next switch.
+			m_switch->SwitchNotifyDequeue(m_ifIndex, qIndex, p);
+			m_traceDequeue(p, qIndex);
+			TransmitStart(p);
+		}
+		else { //No queue can deliver any packet
+
+			if(IsAnyTrue(m_paused, 8)) {		
+				NS_LOG_INFO("PAUSE " << BoolsToStr(m_paused, 8) << " prohibits switch send at node " << m_node->GetId() << " (or no data to send)");
 			}
 		}
-		return;
 	}
 
 	void
@@ -393,7 +509,14 @@ NS_LOG_COMPONENT_DEFINE("QbbNetDevice");
 		m_macRxTrace(packet);
 		CustomHeader ch(CustomHeader::L2_Header | CustomHeader::L3_Header | CustomHeader::L4_Header);
 		ch.getInt = 1; // parse INT header
-		packet->PeekHeader(ch);
+		PacketMetaTag meta;
+		if (m_switch && packet->PeekPacketTag(meta)) {
+			// Transit switch: use the headers parsed by the sender
+			meta.FillCustomHeader(ch);
+		}else {
+			packet->PeekHeader(ch);
+			IntTag::ApplyInt(packet, ch);
+		}
 		
 		if (ch.l3Prot == 0xFE){ // PFC
 			if (!m_qbbEnabled) {
@@ -412,13 +535,13 @@ NS_LOG_COMPONENT_DEFINE("QbbNetDevice");
 				Resume(qIndex);
 			}
 		}else { // non-PFC packets (data, ACK, NACK, CNP...)
-			if (IsSwitchNode(m_node)){ // switch
-				packet->AddPacketTag(FlowIdTag(m_ifIndex));
-				SwitchReceiveFromDevice(m_node, this, packet, ch);
+			if (m_switch){ // switch
+				SwitchIngressTag tag(m_ifIndex);
+				packet->ReplacePacketTag(tag); // The previous switch does not remove its tag
+				m_switch->SwitchReceiveFromDevice(this, packet, ch);
 			}else { // NIC
 				// send to RdmaHw
-				int ret = m_rdmaReceiveCb(packet, ch);
-				// TODO we may based on the ret do something
+				m_rdmaHw->Receive(packet, ch);
 			}
 		}
 		return;
@@ -434,7 +557,7 @@ NS_LOG_COMPONENT_DEFINE("QbbNetDevice");
 		m_macTxTrace(packet);
 		m_traceEnqueue(packet, qIndex);
 		
-		if(!GetQueue()->Enqueue(packet, qIndex)) {
+		if(!m_switchQueue->Enqueue(packet, qIndex)) {
 			NS_LOG_LOGIC("Drop: recv queue cannot enqueue");
 		}
 
@@ -509,22 +632,32 @@ NS_LOG_COMPONENT_DEFINE("QbbNetDevice");
 	}
 
    void QbbNetDevice::NewQp(Ptr<RdmaTxQueuePair> qp){
+	   m_rdmaEQ->UpdateQp(qp);
 	   DequeueAndTransmit();
    }
    void QbbNetDevice::ReassignedQp(Ptr<RdmaTxQueuePair> qp){
+	   m_rdmaEQ->UpdateQp(qp);
 	   DequeueAndTransmit();
    }
    void QbbNetDevice::TriggerTransmit(void){
 	   DequeueAndTransmit();
    }
+   void QbbNetDevice::TriggerTransmit(Time t){
+	   m_txTriggerStats.triggers++;
+	   if (m_txMachineState == BUSY) {
+		   return; // TransmitComplete() will try again
+	   }
+	   UpdateNextAvail(t);
+   }
 
 	void QbbNetDevice::SetQueue(Ptr<BEgressQueue> q){
 		NS_LOG_FUNCTION(this << q);
 		m_queue = q;
+		m_switchQueue = q;
 	}
 
 	Ptr<BEgressQueue> QbbNetDevice::GetQueue(){
-		return DynamicCast<BEgressQueue>(m_queue);
+		return m_switchQueue;
 	}
 
 	Ptr<RdmaEgressQueue> QbbNetDevice::GetRdmaQueue(){
@@ -538,7 +671,7 @@ NS_LOG_COMPONENT_DEFINE("QbbNetDevice");
 
 	void QbbNetDevice::TakeDown(){
 		// TODO: delete packets in the queue, set link down
-		if (!IsSwitchNode(m_node)){
+		if (!m_switch){
 			// clean the high prio queue
 			m_rdmaEQ->CleanHighPrio(m_traceDrop);
 			// notify driver/RdmaHw that this link is down
@@ -568,14 +701,14 @@ NS_LOG_COMPONENT_DEFINE("QbbNetDevice");
 
 			Time delta = t < Simulator::Now() ? Time(0) : t - Simulator::Now();
 			m_nextSend = Simulator::Schedule(delta, &QbbNetDevice::DequeueAndTransmit, this);
+			m_txTriggerStats.events++;
 		}
 	}
 
 	void QbbNetDevice::OnPeerJoinGroup(uint32_t group)
 	{
-		Ptr<SwitchNode> sw = DynamicCast<SwitchNode>(GetNode());
-		if(sw) {
-			sw->OnPeerJoinGroup(m_ifIndex, group);
+		if(m_switch) {
+			m_switch->OnPeerJoinGroup(m_ifIndex, group);
 		}
 	}
 	
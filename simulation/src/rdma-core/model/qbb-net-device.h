@@ -29,25 +29,50 @@
 #include "ns3/ipv4-header.h"
 #include "ns3/udp-header.h"
 #include "ns3/rdma-queue-pair.h"
+#include "ns3/rdma-nic-cache.h"
 #include <vector>
+#include <map>
+#include <queue>
 #include <unordered_set>
 #include <ns3/rdma.h>
 #include <ns3/queue-item.h>
 
 namespace ns3 {
 
+class SwitchNode;
+class RdmaHw;
+
+/**
+ * @brief Egress queue of a NIC: the ACK queue first, then a round-robin between the SQs ready to send.
+ * 
+ * The SQs are not scanned on each dequeue. Each SQ is either:
+ * - Idle: nothing to send or blocked by its window. `UpdateQp()` should be called when this may change.
+ * - Ready: in the ready list of its priority, ordered by round-robin position.
+ * - Waiting: in a min-heap keyed by its next available time, until the rate limiter allows it to send.
+ * 
+ * The state is validated lazily when the SQ is selected, so a ready SQ may turn out to be idle or waiting.
+ * A paused priority skips its whole ready list.
+ */
 class RdmaEgressQueue : public Object{
 public:
 	static const uint32_t qCnt = 8;
 	static uint32_t ack_q_idx;
 	int m_qlast;
-	uint32_t m_rrlast;
+	uint64_t m_rrlast; //!< Round-robin position of the last SQ served.
 	Ptr<DropTailQueue<Packet>> m_ackQ; // highest priority queue
 	Ptr<RdmaTxQueuePairGroup> m_qpGrp; // queue pairs
-
-	// callback for get next packet
-	typedef Callback<Ptr<Packet>, Ptr<RdmaTxQueuePair> > RdmaGetNxtPkt;
-	RdmaGetNxtPkt m_rdmaGetNxtPkt;
+	RdmaNicCaches* m_caches{nullptr}; //!< Caches of the NIC, or nullptr if not modelled.
+	RdmaHw* m_rdmaHw{nullptr}; //!< Generates the next packet of a SQ.
+
+	/**
+	 * @brief Scheduling state of a SQ.
+	 */
+	enum SchedState : uint8_t {
+		SQ_IDLE = 0,
+		SQ_READY,
+		SQ_WAITING,
+		SQ_FINISHED
+	};
 
 	static TypeId GetTypeId (void);
 	RdmaEgressQueue();
@@ -60,11 +85,55 @@ public:
 	void EnqueueHighPrioQ(Ptr<Packet> p);
 	void CleanHighPrio(TracedCallback<Ptr<const Packet>, uint32_t> dropCb);
 
+	/**
+	 * @brief Notify that the SQ may be able to send: send posted, ACK, NACK, rate change...
+	 */
+	void UpdateQp(Ptr<RdmaTxQueuePair> qp);
+
+	/**
+	 * @brief Forget the scheduling state of all the SQs, e.g. when the SQs are reassigned.
+	 */
+	void ClearSchedule();
+
+	/**
+	 * @return The earliest time a waiting SQ can send, or the maximum simulation time.
+	 */
+	Time GetNextAvailTime();
+
 	TracedCallback<Ptr<const Packet>, uint32_t> m_traceRdmaEnqueue;
   using TraceRdmaEnqueueCallback = void(*)(Ptr<const Packet>, uint32_t priority);
 
 	TracedCallback<Ptr<const Packet>, uint32_t> m_traceRdmaDequeue;
   using TraceRdmaDequeueCallback = void(*)(Ptr<const Packet>, uint32_t priority);
+
+private:
+	struct TimerEntry {
+		Time t;
+		uint64_t order;
+		Ptr<RdmaTxQueuePair> qp;
+
+		bool operator>(const TimerEntry& o) const
+		{
+			return t != o.t ? t > o.t : order > o.order;
+		}
+	};
+
+	void Classify(Ptr<RdmaTxQueuePair> qp);
+	void WakeExpired();
+
+	/**
+	 * @brief Fetch the contexts needed by the next packet of a ready SQ.
+	 * @return false if the contexts are missing from the caches. The SQ then waits for the fetch.
+	 */
+	bool FetchContexts(Ptr<RdmaTxQueuePair> qp);
+	bool IsValid(const TimerEntry& e) const;
+
+	//! Ready SQs of each priority, keyed by round-robin position.
+	std::map<uint64_t, Ptr<RdmaTxQueuePair>> m_ready[qCnt];
+	//! Waiting SQs. Entries are not removed when the SQ changes state, but skipped when invalid.
+	std::priority_queue<TimerEntry, std::vector<TimerEntry>, std::greater<TimerEntry>> m_timers;
+	//! Finished SQs not yet removed from `m_qpGrp`.
+	uint32_t m_nFinished{0};
 };
 
 /**
@@ -81,6 +150,17 @@ public:
   QbbNetDevice ();
   ~QbbNetDevice () override;
 
+  /**
+   * Also resolve once whether the device is a switch port or a NIC,
+   * so the per-packet paths do not need RTTI.
+   */
+  void SetNode (Ptr<Node> node) override;
+
+  /**
+   * @return The switch of the port, or nullptr if the device is a NIC.
+   */
+  SwitchNode* GetSwitch () const { return m_switch; }
+
   /**
    * Receive a packet from a connected PointToPointChannel.
    *
@@ -131,6 +211,28 @@ public:
    void ReassignedQp(Ptr<RdmaTxQueuePair> qp);
    void TriggerTransmit(void);
 
+   /**
+    * @brief Request a transmit attempt at time `t`, on behalf of a SQ.
+    * 
+    * The device keeps a single armed transmit event, moved earlier only when `t` is earlier.
+    * While a packet is being transmitted, the request is dropped, because the end of the
+    * transmission tries to transmit again and arms the event for the earliest waiting SQ.
+    */
+   void TriggerTransmit(Time t);
+
+   /**
+    * @brief Counters of the transmit triggers of the SQs of the NIC.
+    */
+   struct TxTriggerStats
+   {
+     uint64_t posted_wrs{}; //!< Send requests posted to the SQs.
+     uint64_t triggers{}; //!< Calls to `TriggerTransmit(Time)`.
+     uint64_t events{}; //!< Transmit events scheduled.
+   };
+
+   void NotifyPostSend(uint64_t count) { m_txTriggerStats.posted_wrs += count; }
+   const TxTriggerStats& GetTxTriggerStats() const { return m_txTriggerStats; }
+
 	void SendPfc(uint32_t qIndex, uint32_t type); // type: 0 = pause, 1 = resume
 
   /**
@@ -163,6 +265,8 @@ protected:
 
   /// Look for an available packet and send it using TransmitStart(p)
   virtual void DequeueAndTransmit(void);
+  void DequeueAndTransmitNic(void);
+  void DequeueAndTransmitSwitch(void);
 
   /// Resume a paused queue and call DequeueAndTransmit()
   virtual void Resume(unsigned qIndex);
@@ -179,6 +283,7 @@ protected:
 
   /* RP parameters */
   EventId  m_nextSend;		//< The next send event
+  TxTriggerStats m_txTriggerStats;
   /* State variable for rate-limited queues */
 
   //qcn
@@ -201,19 +306,18 @@ protected:
    */
   std::unordered_set<uint32_t> m_groups;
 
+  SwitchNode* m_switch{nullptr}; //!< Node of the device if it is a switch port, see `SetNode()`.
+  Ptr<BEgressQueue> m_switchQueue; //!< Same as `m_queue`, already cast.
+
 public:
 	Ptr<RdmaEgressQueue> m_rdmaEQ;
 	void RdmaEnqueueHighPrioQ(Ptr<Packet> p);
 
-	// callback for processing packet in RDMA
-	typedef Callback<int, Ptr<Packet>, CustomHeader&> RdmaReceiveCb;
-	RdmaReceiveCb m_rdmaReceiveCb;
+	// RdmaHw of the NIC, which processes the received packets and is notified of the sent packets
+	RdmaHw* m_rdmaHw{nullptr};
 	// callback for link down
 	typedef Callback<void, Ptr<QbbNetDevice> > RdmaLinkDownCb;
 	RdmaLinkDownCb m_rdmaLinkDownCb;
-	// callback for sent a packet
-	typedef Callback<void, Ptr<RdmaTxQueuePair>, Ptr<Packet>, Time> RdmaPktSent;
-	RdmaPktSent m_rdmaPktSent;
 
 	Ptr<RdmaEgressQueue> GetRdmaQueue();
 	void TakeDown(); // take down this device
@@ -39,7 +39,7 @@ void RdmaBTH::Print(std::ostream &os) const
 
 uint32_t RdmaBTH::GetSerializedSize() const
 {
-	return 7;
+	return 13 + (m_has_flow_key ? sizeof(m_flow_key.k) : 0);
 }
 
 void RdmaBTH::Serialize(TagBuffer start) const
@@ -47,11 +47,18 @@ void RdmaBTH::Serialize(TagBuffer start) const
 	const uint8_t payload = m_reliable
 		| (m_multicast << 1)
 		| (m_ack_req << 2)
-		| (m_notif << 3);
+		| (m_notif << 3)
+		| (m_has_flow_key << 4);
 
 	start.WriteU8(payload);
 	start.WriteU32(m_imm);
-	start.WriteU16(m_key);
+	start.WriteU32(m_dqpn);
+	start.WriteU32(m_sqpn);
+	if (m_has_flow_key) {
+		for (uint32_t k : m_flow_key.k) {
+			start.WriteU32(k);
+		}
+	}
 }
 
 void RdmaBTH::Deserialize(TagBuffer start)
@@ -61,8 +68,15 @@ void RdmaBTH::Deserialize(TagBuffer start)
 	m_multicast = payload & 2;
 	m_ack_req   = payload & 4;
 	m_notif     = payload & 8;
+	m_has_flow_key = payload & 16;
 	m_imm       = start.ReadU32();
-	m_key       = start.ReadU16();
+	m_dqpn      = start.ReadU32();
+	m_sqpn      = start.ReadU32();
+	if (m_has_flow_key) {
+		for (uint32_t& k : m_flow_key.k) {
+			k = start.ReadU32();
+		}
+	}
 }
 
 bool RdmaBTH::GetReliable() const
@@ -115,4 +129,10 @@ uint32_t RdmaBTH::GetImm() const
 	return m_imm;
 }
 
+void RdmaBTH::SetFlowKey(const EcmpFlowKey& key)
+{
+	m_has_flow_key = true;
+	m_flow_key = key;
+}
+
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 #include <ns3/object.h>
 #include <ns3/tag.h>
+#include <ns3/ecmp-hash.h>
 
 namespace ns3 {
 
@@ -29,8 +30,28 @@ public:
 	void SetNotif(bool notif);
 	void SetImm(uint32_t imm);
 	uint32_t GetImm() const;
-	uint16_t GetDestQpKey() const { return m_key; }
-	void SetDestQpKey(uint16_t key) { m_key = key; }
+
+	/**
+	 * @brief QP number of the destination (see `RdmaQpTable`).
+	 * Zero when the sender does not know it: the destination QP is the one bound to the UDP destination port
+	 * (see `RdmaHw::BindPort()`), for example for multicast.
+	 */
+	uint32_t GetDestQpn() const { return m_dqpn; }
+	void SetDestQpn(uint32_t qpn) { m_dqpn = qpn; }
+
+	/**
+	 * @brief QP number of the source, like in the DETH of UD packets, so that the receiver can reply.
+	 */
+	uint32_t GetSrcQpn() const { return m_sqpn; }
+	void SetSrcQpn(uint32_t qpn) { m_sqpn = qpn; }
+
+	/**
+	 * @brief Cache the ECMP flow key, so that switches do not rebuild and rehash the 5-tuple.
+	 * Should match the IP/UDP headers of the packet.
+	 */
+	void SetFlowKey(const EcmpFlowKey& key);
+	bool HasFlowKey() const { return m_has_flow_key; }
+	const EcmpFlowKey& GetFlowKey() const { return m_flow_key; }
 
 private:
 	// true: RC, false: UD.
@@ -39,7 +60,10 @@ private:
 	bool m_multicast{false}; //<! When `true`, the destination is a multicast group.
 	bool m_notif{false}; //<! When `true`, a notification event is generated in the RX side.
 	uint32_t m_imm{0};
-	uint16_t m_key{0}; // Destination QP key.
+	uint32_t m_dqpn{0}; // Destination QP number.
+	uint32_t m_sqpn{0}; // Source QP number.
+	bool m_has_flow_key{false};
+	EcmpFlowKey m_flow_key{};
 };
 
 }
@@ -0,0 +1,63 @@
+#include <ns3/rdma-cc.h>
+#include <ns3/abort.h>
+
+namespace ns3 {
+
+RdmaCcState MakeRdmaCcState(uint32_t mode, DataRate rate)
+{
+	switch (mode){
+		case CC_DCQCN: {
+			DcqcnCc cc;
+			cc.m_targetRate = rate;
+			return cc;
+		}
+		case CC_HPCC: {
+			HpccCc cc;
+			cc.m_curRate = rate;
+			return cc;
+		}
+		case CC_TIMELY: {
+			TimelyCc cc;
+			cc.m_curRate = rate;
+			return cc;
+		}
+		case CC_DCTCP:
+			return DctcpCc{};
+		case CC_HPCC_PINT: {
+			HpccPintCc cc;
+			cc.m_curRate = rate;
+			return cc;
+		}
+		case CC_SWIFT: {
+			SwiftCc cc;
+			cc.m_curRate = rate;
+			return cc;
+		}
+		default:
+			NS_ABORT_MSG("Unknown CC mode " << mode);
+	}
+	return DcqcnCc{};
+}
+
+IntHeader::Mode GetRdmaCcIntMode(uint32_t mode)
+{
+	switch (mode){
+		case CC_HPCC:
+			return IntHeader::NORMAL;
+		case CC_TIMELY:
+		case CC_SWIFT:
+			return IntHeader::TS;
+		case CC_HPCC_PINT:
+			return IntHeader::PINT;
+		default:
+			return IntHeader::NONE;
+	}
+}
+
+bool IsRdmaCcSupported(uint32_t mode)
+{
+	const IntHeader::Mode needed = GetRdmaCcIntMode(mode);
+	return needed == IntHeader::NONE || needed == IntHeader::mode;
+}
+
+} // namespace ns3
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <ns3/data-rate.h>
+#include <ns3/rdma-timer-wheel.h>
+#include <ns3/nstime.h>
+#include <ns3/int-header.h>
+#include <variant>
+
+namespace ns3 {
+
+/**
+ * @brief Congestion control algorithms of the NIC.
+ *
+ * The values are the ones of the `CcMode` attribute of the original HPCC code base.
+ */
+enum RdmaCcMode : uint32_t {
+	CC_DCQCN = 1,
+	CC_HPCC = 3,
+	CC_TIMELY = 7,
+	CC_DCTCP = 8,
+	CC_HPCC_PINT = 10,
+	CC_SWIFT = 11,
+};
+
+/**
+ * @brief Congestion feedback received by an SQ with an ACK or a NACK.
+ */
+struct RdmaCcFeedback
+{
+	uint32_t ack_seq{}; //!< Next PSN expected by the receiver.
+	uint32_t snd_nxt{}; //!< Next PSN to send by the SQ once the ACK is processed, truncated like the PSN of the headers.
+	bool ecn{}; //!< The receiver has seen a CE mark (CNP flag of the ACK).
+	const IntHeader* ih{}; //!< INT echoed back by the receiver, in the format of `IntHeader::mode`.
+};
+
+/******************************
+ * Per-algorithm states of an SQ.
+ * Only the state of the algorithm in use is stored in the SQ (see `RdmaCcState`).
+ *****************************/
+
+/**
+ * @brief Mellanox's version of DCQCN (see `RdmaHw`).
+ */
+struct DcqcnCc
+{
+	static constexpr RdmaCcMode mode = CC_DCQCN;
+
+	DataRate m_targetRate;	//< Target rate
+	RdmaTimer m_eventUpdateAlpha;
+	double m_alpha{1};
+	bool m_alpha_cnp_arrived{false}; // indicate if CNP arrived in the last slot
+	bool m_first_cnp{true}; // indicate if the current CNP is the first CNP
+	RdmaTimer m_eventDecreaseRate;
+	bool m_decrease_cnp_arrived{false}; // indicate if CNP arrived in the last slot
+	uint32_t m_rpTimeStage{0};
+	RdmaTimer m_rpTimer;
+	// Analytic mode (see `RdmaHw::UpdateDcqcn()`): when the timers above would fire next.
+	Time m_nextAlpha;
+	Time m_nextDecrease;
+	Time m_nextRateInc;
+	bool m_rateIncActive{false}; // whether `m_rpTimer` would be running
+};
+
+/**
+ * @brief HPCC, driven by the INT of each hop.
+ */
+struct HpccCc
+{
+	static constexpr RdmaCcMode mode = CC_HPCC;
+
+	uint32_t m_lastUpdateSeq{0};
+	DataRate m_curRate;
+	IntHop hop[IntHeader::maxHop]{};
+	uint32_t m_incStage{0};
+	double u{1};
+};
+
+/**
+ * @brief TIMELY, driven by the RTT gradient.
+ */
+struct TimelyCc
+{
+	static constexpr RdmaCcMode mode = CC_TIMELY;
+
+	uint32_t m_lastUpdateSeq{0};
+	DataRate m_curRate;
+	uint32_t m_incStage{0};
+	uint64_t lastRtt{0};
+	double rttDiff{0};
+};
+
+/**
+ * @brief DCTCP, driven by the fraction of CE-marked ACKs.
+ */
+struct DctcpCc
+{
+	static constexpr RdmaCcMode mode = CC_DCTCP;
+
+	uint32_t m_lastUpdateSeq{0};
+	uint32_t m_caState{0};
+	uint32_t m_highSeq{0}; // when to exit cwr
+	double m_alpha{1};
+	uint32_t m_ecnCnt{0};
+	uint32_t m_batchSizeOfAlpha{0};
+};
+
+/**
+ * @brief HPCC-PINT, driven by the probabilistic INT of the bottleneck.
+ */
+struct HpccPintCc
+{
+	static constexpr RdmaCcMode mode = CC_HPCC_PINT;
+
+	uint32_t m_lastUpdateSeq{0};
+	DataRate m_curRate;
+	uint32_t m_incStage{0};
+};
+
+/**
+ * @brief Swift, driven by the RTT compared to a target delay.
+ */
+struct SwiftCc
+{
+	static constexpr RdmaCcMode mode = CC_SWIFT;
+
+	uint32_t m_lastUpdateSeq{0};
+	DataRate m_curRate;
+	Time m_lastDecrease; // at most one decrease per RTT
+};
+
+/**
+ * @brief Congestion control state of an SQ.
+ *
+ * The algorithm is the type of the alternative.
+ * `RdmaHw` dispatches the feedback with `std::visit()` to an overload per algorithm,
+ * so the handlers are bound at compile time and there is no virtual call on the ACK path.
+ */
+using RdmaCcState = std::variant<DcqcnCc, HpccCc, TimelyCc, DctcpCc, HpccPintCc, SwiftCc>;
+
+/**
+ * @param mode One of `RdmaCcMode`.
+ * @param rate Initial rate of the SQ.
+ * @return The initial state of the algorithm.
+ */
+RdmaCcState MakeRdmaCcState(uint32_t mode, DataRate rate);
+
+/**
+ * @return The format of the INT header the algorithm needs, or `IntHeader::NONE`.
+ */
+IntHeader::Mode GetRdmaCcIntMode(uint32_t mode);
+
+/**
+ * @return true If the algorithm can run with the INT header format of the network (`IntHeader::mode`).
+ */
+bool IsRdmaCcSupported(uint32_t mode);
+
+} // namespace ns3
@@ -18,6 +18,9 @@
 #include "ns3/rdma-reliable-qp.h"
 #include "ns3/rdma-unreliable-qp.h"
 #include "ns3/log.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 namespace ns3 {
 
@@ -42,8 +45,8 @@ TypeId RdmaHw::GetTypeId (void)
 				MakeUintegerAccessor(&RdmaHw::m_mtu),
 				MakeUintegerChecker<uint32_t>())
 		.AddAttribute ("CcMode",
-				"which mode of DCQCN is running",
-				UintegerValue(0),
+				"Congestion control of the QPs (1: DCQCN, 3: HPCC, 7: TIMELY, 8: DCTCP, 10: HPCC-PINT, 11: Swift)",
+				UintegerValue(CC_DCQCN),
 				MakeUintegerAccessor(&RdmaHw::m_cc_mode),
 				MakeUintegerChecker<uint32_t>())
 		.AddAttribute("NackInterval",
@@ -66,6 +69,23 @@ TypeId RdmaHw::GetTypeId (void)
 				BooleanValue(false),
 				MakeBooleanAccessor(&RdmaHw::m_backto0),
 				MakeBooleanChecker())
+		.AddAttribute("SelectiveRepeat",
+				"Selective repeat of the RC QPs (IRN): the receiver keeps out-of-order packets and the sender only retransmits the holes. "
+				"The on-the-fly bytes are bounded by the BDP (see `BaseRtt`).",
+				BooleanValue(false),
+				MakeBooleanAccessor(&RdmaHw::m_selectiveRepeat),
+				MakeBooleanChecker())
+		.AddAttribute("AckCoalesceBytes",
+				"The RC receivers merge the requested ACKs until this many bytes are received since the last ACK. "
+				"NACKs, CNPs and the ACKs of the last packet of a request are sent immediately. Disable coalescing if equals to 0.",
+				UintegerValue(0),
+				MakeUintegerAccessor(&RdmaHw::m_ackCoalesceBytes),
+				MakeUintegerChecker<uint32_t>())
+		.AddAttribute("AckCoalesceDelay",
+				"Maximum delay of a coalesced ACK",
+				TimeValue(MicroSeconds(2)),
+				MakeTimeAccessor(&RdmaHw::m_ackCoalesceDelay),
+				MakeTimeChecker())
 		.AddAttribute("EwmaGain",
 				"Control gain parameter which determines the level of rate decrease",
 				DoubleValue(1.0 / 16),
@@ -121,6 +141,117 @@ TypeId RdmaHw::GetTypeId (void)
 				BooleanValue(true),
 				MakeBooleanAccessor(&RdmaHw::m_fast_react),
 				MakeBooleanChecker())
+		.AddAttribute("DcqcnAnalytic",
+				"Replay the DCQCN timers when the QP is touched instead of scheduling periodic events",
+				BooleanValue(false),
+				MakeBooleanAccessor(&RdmaHw::m_dcqcnAnalytic),
+				MakeBooleanChecker())
+		.AddAttribute("TargetUtil",
+				"The Target Utilization of the bottleneck bandwidth, by default 95%",
+				DoubleValue(0.95),
+				MakeDoubleAccessor(&RdmaHw::m_targetUtil),
+				MakeDoubleChecker<double>())
+		.AddAttribute("MiThresh",
+				"Threshold of number of consecutive AI before MI",
+				UintegerValue(5),
+				MakeUintegerAccessor(&RdmaHw::m_miThresh),
+				MakeUintegerChecker<uint32_t>())
+		.AddAttribute("BaseRtt",
+				"Base RTT of the flows for HPCC, the window is the BDP",
+				TimeValue(MicroSeconds(9)),
+				MakeTimeAccessor(&RdmaHw::m_baseRtt),
+				MakeTimeChecker())
+		.AddAttribute("TimelyAlpha",
+				"Alpha of TIMELY",
+				DoubleValue(0.875),
+				MakeDoubleAccessor(&RdmaHw::m_tmly_alpha),
+				MakeDoubleChecker<double>())
+		.AddAttribute("TimelyBeta",
+				"Beta of TIMELY",
+				DoubleValue(0.8),
+				MakeDoubleAccessor(&RdmaHw::m_tmly_beta),
+				MakeDoubleChecker<double>())
+		.AddAttribute("TimelyTLow",
+				"TLow of TIMELY (ns)",
+				UintegerValue(50000),
+				MakeUintegerAccessor(&RdmaHw::m_tmly_TLow),
+				MakeUintegerChecker<uint64_t>())
+		.AddAttribute("TimelyTHigh",
+				"THigh of TIMELY (ns)",
+				UintegerValue(500000),
+				MakeUintegerAccessor(&RdmaHw::m_tmly_THigh),
+				MakeUintegerChecker<uint64_t>())
+		.AddAttribute("TimelyMinRtt",
+				"MinRtt of TIMELY (ns)",
+				UintegerValue(20000),
+				MakeUintegerAccessor(&RdmaHw::m_tmly_minRtt),
+				MakeUintegerChecker<uint64_t>())
+		.AddAttribute("DctcpRateAI",
+				"DCTCP's Rate increment unit in AI period",
+				DataRateValue(DataRate("1000Mb/s")),
+				MakeDataRateAccessor(&RdmaHw::m_dctcp_rai),
+				MakeDataRateChecker())
+		.AddAttribute("PintProb",
+				"Probability of using each PINT feedback",
+				DoubleValue(1.0),
+				MakeDoubleAccessor(&RdmaHw::m_pint_prob),
+				MakeDoubleChecker<double>(0, 1))
+		.AddAttribute("SwiftTargetDelay",
+				"Target RTT of Swift",
+				TimeValue(MicroSeconds(25)),
+				MakeTimeAccessor(&RdmaHw::m_swift_target),
+				MakeTimeChecker())
+		.AddAttribute("SwiftBeta",
+				"Multiplicative decrease factor of Swift",
+				DoubleValue(0.8),
+				MakeDoubleAccessor(&RdmaHw::m_swift_beta),
+				MakeDoubleChecker<double>())
+		.AddAttribute("SwiftMaxMdf",
+				"Max multiplicative decrease of Swift in one RTT",
+				DoubleValue(0.5),
+				MakeDoubleAccessor(&RdmaHw::m_swift_maxMdf),
+				MakeDoubleChecker<double>(0, 1))
+		.AddAttribute("QpcCacheEntries",
+				"Count of QP contexts cached by the NIC. Disable the QPC cache model if equals to 0.",
+				UintegerValue(0),
+				MakeUintegerAccessor(&RdmaHw::m_qpcEntries),
+				MakeUintegerChecker<uint32_t>())
+		.AddAttribute("QpcCacheWays",
+				"Associativity of the QPC cache",
+				UintegerValue(8),
+				MakeUintegerAccessor(&RdmaHw::m_qpcWays),
+				MakeUintegerChecker<uint32_t>(1))
+		.AddAttribute("QpcMissLatency",
+				"Time to fetch a QP context from the host memory",
+				TimeValue(MicroSeconds(1)),
+				MakeTimeAccessor(&RdmaHw::m_qpcMissLatency),
+				MakeTimeChecker())
+		.AddAttribute("MttCacheEntries",
+				"Count of page translations cached by the NIC. Disable the MTT cache model if equals to 0.",
+				UintegerValue(0),
+				MakeUintegerAccessor(&RdmaHw::m_mttEntries),
+				MakeUintegerChecker<uint32_t>())
+		.AddAttribute("MttCacheWays",
+				"Associativity of the MTT cache",
+				UintegerValue(8),
+				MakeUintegerAccessor(&RdmaHw::m_mttWays),
+				MakeUintegerChecker<uint32_t>(1))
+		.AddAttribute("MttPageSize",
+				"Size of the memory pages translated by the MTT",
+				UintegerValue(4096),
+				MakeUintegerAccessor(&RdmaHw::m_mttPageSize),
+				MakeUintegerChecker<uint32_t>(1))
+		.AddAttribute("MttMissLatency",
+				"Time to fetch a page translation from the host memory",
+				TimeValue(MicroSeconds(1)),
+				MakeTimeAccessor(&RdmaHw::m_mttMissLatency),
+				MakeTimeChecker())
+		.AddAttribute("TimerWheelTick",
+				"Resolution of the timing wheel of the QP timers (retransmission, delayed ACK, DCQCN). "
+				"The timers are simulator events if equals to 0.",
+				TimeValue(Time(0)),
+				MakeTimeAccessor(&RdmaHw::m_timerWheelTick),
+				MakeTimeChecker(Time(0)))
 		.AddAttribute("RateBound",
 				"Bound packet sending by rate, for test only",
 				BooleanValue(true),
@@ -135,6 +266,11 @@ void RdmaHw::Setup()
 	NS_LOG_FUNCTION(this);
 	m_node = GetObject<Node>();
 	NS_ASSERT(m_node);
+	m_pint_rng = CreateObject<UniformRandomVariable>();
+	m_caches.qpc.Configure(m_qpcEntries, m_qpcWays, m_qpcMissLatency);
+	m_caches.mtt.Configure(m_mttEntries, m_mttWays, m_mttMissLatency);
+	m_caches.mttPageSize = m_mttPageSize;
+	m_timers.Configure(m_timerWheelTick);
 		
 	for (uint32_t i = 0; i < m_node->GetNDevices(); i++){
 		Ptr<QbbNetDevice> dev = NULL;
@@ -151,12 +287,12 @@ void RdmaHw::Setup()
 			continue;
 		// share data with NIC
 		dev->m_rdmaEQ->m_qpGrp = &m_nic[i];
+		dev->m_rdmaEQ->m_caches = m_caches.IsEnabled() ? &m_caches : nullptr;
 		// setup callback
-		dev->m_rdmaReceiveCb = MakeCallback(&RdmaHw::Receive, this);
+		dev->m_rdmaHw = this;
 		dev->m_rdmaLinkDownCb = MakeCallback(&RdmaHw::SetLinkDown, this);
-		dev->m_rdmaPktSent = MakeCallback(&RdmaHw::PktSent, this);
 		// config NIC
-		dev->m_rdmaEQ->m_rdmaGetNxtPkt = MakeCallback(&RdmaHw::GetNxtPacket, this);
+		dev->m_rdmaEQ->m_rdmaHw = this;
 	}
 }
 
@@ -166,6 +302,7 @@ RdmaReliableQP RdmaHw::CreateReliableQP(uint16_t pg, uint16_t sport, Ipv4Address
   qp.sq = CreateObject<RdmaReliableSQ>(m_node, pg, GetServerAddress(m_node), sport, dip, dport);
   qp.rq = CreateObject<RdmaReliableRQ>(qp.sq);
   RegisterQP(qp.sq, qp.rq);
+  BindPort(qp.sq);
 
 	return qp;
 }
@@ -176,6 +313,7 @@ RdmaUnreliableQP RdmaHw::CreateUnreliableQP(uint16_t pg, uint16_t sport)
   qp.sq = CreateObject<RdmaUnreliableSQ>(m_node, pg, GetServerAddress(m_node), sport);
   qp.rq = CreateObject<RdmaUnreliableRQ>(qp.sq);
   RegisterQP(qp.sq, qp.rq);
+  BindPort(qp.sq);
 	
 	return qp;
 }
@@ -185,22 +323,26 @@ void RdmaHw::RegisterQP(Ptr<RdmaTxQueuePair> sq, Ptr<RdmaRxQueuePair> rq)
 	Ptr<RdmaReliableRQ> rel_rq = DynamicCast<RdmaReliableRQ>(rq);
 	if(rel_rq) {
 		rel_rq->SetNackInterval(m_nack_interval);
+		rel_rq->SetAckCoalescing(m_ackCoalesceBytes, m_ackCoalesceDelay);
 		// DynamicCast<RdmaReliableSQ>(sq)->SetWin(0.95);
 		DynamicCast<RdmaReliableSQ>(sq)->SetAckInterval(m_chunk, m_ack_interval);
+		if (m_selectiveRepeat){
+			rel_rq->SetSelectiveRepeat(true);
+			DynamicCast<RdmaReliableSQ>(sq)->SetSelectiveRepeat(true);
+		}
 	}
-	const uint64_t key = sq->GetKey();
-
-	// Store in map
-	m_rxQpMap[key] = rq;
-
-	// add qp
-	m_qpMap[key] = sq;
+	sq->m_qpn = m_qps.Add(sq, rq);
+	sq->m_rdmaHw = this;
 
 	// set init variables
-	NS_ASSERT(m_cc_mode == 1);
 	DataRate m_bps = sq->GetDevice()->GetDataRate();
 	sq->SetMaxRate(m_bps);
 	sq->SetMTU(m_mtu);
+	SetCcMode(sq, m_cc_mode);
+	if (rel_rq && m_selectiveRepeat){
+		// BDP-based flow control of IRN, so that the receiver never has more than a BDP out of order
+		DynamicCast<RdmaReliableSQ>(sq)->SetWin(m_bps * m_baseRtt / 8);
+	}
 
 	// Notify Nic
 	NS_ASSERT(m_nic.size() == 1);
@@ -208,35 +350,64 @@ void RdmaHw::RegisterQP(Ptr<RdmaTxQueuePair> sq, Ptr<RdmaRxQueuePair> rq)
 	sq->GetDevice()->NewQp(sq);
 }
 
-uint64_t RdmaHw::GetRxQpKey(uint16_t dport)
+void RdmaHw::BindPort(Ptr<RdmaTxQueuePair> sq)
 {
-	return dport;
+	m_portQpn[sq->GetSrcPort()] = sq->GetQpn();
+}
+
+void RdmaHw::DestroyQP(Ptr<RdmaTxQueuePair> sq)
+{
+	NS_LOG_FUNCTION(this << sq->GetQpn());
+
+	sq->StopTimers();
+	sq->Finish();
+	DeleteQueuePair(sq);
+
+	// The scheduler of the NIC removes the finished SQ
+	sq->TriggerDevTransmit();
 }
 
 void RdmaHw::DeleteQueuePair(Ptr<RdmaTxQueuePair> qp){
-	// remove qp from the m_qpMap
-	uint64_t key = qp->GetKey();
-	m_qpMap.erase(key);
-}
-
-Ptr<RdmaRxQueuePair> RdmaHw::GetRxQp(uint32_t sip, uint32_t dip, uint16_t sport, uint16_t dport, uint16_t pg, bool create){
-	uint64_t key = GetRxQpKey(dport);
-	auto it = m_rxQpMap.find(key);
-	NS_ASSERT_MSG(it != m_rxQpMap.end(), "Cannot find the destination RQ");
-	if (it != m_rxQpMap.end())
-		return it->second;
-	if (create){
-		// create new rx qp
-		Ptr<RdmaRxQueuePair> q = CreateObject<RdmaRxQueuePair>(m_qpMap.at(sport));
-		// init the qp
-		q->m_local_ip = sip;
-		q->m_local_port = sport;
-		q->m_ecn_source.qIndex = pg;
-		// store in map
-		m_rxQpMap[key] = q;
-		return q;
-	}
-	return NULL;
+	const uint32_t qpn = qp->GetQpn();
+	if (!m_qps.Find(qpn))
+		return;
+
+	if (Ptr<RdmaReliableSQ> rc = DynamicCast<RdmaReliableSQ>(qp)){
+		m_destroyedRcStats.tx_bytes += rc->GetTxBytes();
+		m_destroyedRcStats.retx_bytes += rc->GetRetxBytes();
+		m_destroyedRcStats.acked_bytes += rc->GetAckedBytes();
+	}
+	auto it = m_portQpn.find(qp->GetSrcPort());
+	if (it != m_portQpn.end() && it->second == qpn)
+		m_portQpn.erase(it);
+	m_qps.Remove(qpn);
+}
+
+RdmaHw::RcStats RdmaHw::GetRcStats() const
+{
+	RcStats stats = m_destroyedRcStats;
+	m_qps.ForEach([&stats](const RdmaQpTable::Entry& e){
+		if (Ptr<RdmaReliableSQ> rc = DynamicCast<RdmaReliableSQ>(e.sq)){
+			stats.tx_bytes += rc->GetTxBytes();
+			stats.retx_bytes += rc->GetRetxBytes();
+			stats.acked_bytes += rc->GetAckedBytes();
+		}
+	});
+	return stats;
+}
+
+uint32_t RdmaHw::ResolvePort(const CustomHeader& ch) const
+{
+	uint16_t port = 0;
+	if (ch.l3Prot == 0x11)
+		port = ch.udp.dport;
+	else if (ch.l3Prot == 0xFC || ch.l3Prot == 0xFD)
+		port = ch.ack.dport;
+	else
+		NS_ABORT_MSG("Cannot resolve the QP of protocol " << ch.l3Prot << " without QPN");
+
+	auto it = m_portQpn.find(port);
+	return it != m_portQpn.end() ? it->second : 0;
 }
 
 uint32_t RdmaHw::ResolveIface(Ipv4Address ip)
@@ -247,19 +418,39 @@ uint32_t RdmaHw::ResolveIface(Ipv4Address ip)
 	}
 	return it->second;
 }
-void RdmaHw::DeleteRxQp(uint32_t dip, uint16_t pg, uint16_t dport){
-	uint64_t key = ((uint64_t)dip << 32) | ((uint64_t)pg << 16) | (uint64_t)dport;
-	m_rxQpMap.erase(key);
-}
 
 int RdmaHw::Receive(Ptr<Packet> p, CustomHeader &ch)
 {
 	RdmaBTH bth;
 	NS_ABORT_UNLESS(p->PeekPacketTag(bth));
-	m_rxQpMap.at(bth.GetDestQpKey())->Receive(p, ch);
+	const uint32_t qpn = bth.GetDestQpn() != 0 ? bth.GetDestQpn() : ResolvePort(ch);
+	const RdmaQpTable::Entry* qp = m_qps.Find(qpn);
+	if (!qp){
+		NS_LOG_LOGIC("Drop packet to QP " << qpn << ", destroyed or never created");
+		return 0;
+	}
+	if (m_caches.IsEnabled()){
+		// The packets of a QP wait for the same fetch, so they are still processed in order
+		const Time ready = m_caches.AccessRx(qpn, ch);
+		if (ready > Simulator::Now()){
+			Simulator::Schedule(ready - Simulator::Now(), &RdmaHw::DeliverToQp, this, p, ch, qpn);
+			return 0;
+		}
+	}
+	qp->rq->Receive(p, ch);
 	return 0;
 }
 
+void RdmaHw::DeliverToQp(Ptr<Packet> p, CustomHeader ch, uint32_t qpn)
+{
+	const RdmaQpTable::Entry* qp = m_qps.Find(qpn);
+	if (!qp){
+		NS_LOG_LOGIC("Drop packet to QP " << qpn << ", destroyed while its context was fetched");
+		return;
+	}
+	qp->rq->Receive(p, ch);
+}
+
 void RdmaHw::QpComplete(Ptr<RdmaTxQueuePair> qp){
 	m_traceQpComplete(qp);
 
@@ -290,18 +481,19 @@ void RdmaHw::RedistributeQp()
 		if (m_nic[i].GetDevice() == NULL)
 			continue;
 		m_nic[i].Clear();
+		m_nic[i].GetDevice()->GetRdmaQueue()->ClearSchedule();
 	}
 
 	// redistribute qp
-	for (auto &it : m_qpMap){
-		Ptr<RdmaTxQueuePair> qp = it.second;
+	m_qps.ForEach([this](const RdmaQpTable::Entry& e){
+		Ptr<RdmaTxQueuePair> qp = e.sq;
 
 		NS_ASSERT(m_nic.size() == 1); // Refactored, allow only one NIC
 		uint32_t nic_idx = 0;
 		m_nic[nic_idx].AddQp(qp);
 		// Notify Nic
 		m_nic[nic_idx].GetDevice()->ReassignedQp(qp);
-	}
+	});
 }
 
 Ptr<Packet> RdmaHw::GetNxtPacket(Ptr<RdmaTxQueuePair> qp){
@@ -309,6 +501,7 @@ Ptr<Packet> RdmaHw::GetNxtPacket(Ptr<RdmaTxQueuePair> qp){
 }
 
 void RdmaHw::PktSent(Ptr<RdmaTxQueuePair> qp, Ptr<Packet> pkt, Time interframeGap){
+	UpdateDcqcn(qp);
 	qp->m_lastPktSize = pkt->GetSize();
 	UpdateNextAvail(qp, interframeGap, pkt->GetSize());
 	
@@ -319,6 +512,22 @@ void RdmaHw::PktSent(Ptr<RdmaTxQueuePair> qp, Ptr<Packet> pkt, Time interframeGa
 	}
 }
 
+void RdmaHw::SetCcMode(Ptr<RdmaTxQueuePair> qp, uint32_t cc){
+	NS_ABORT_MSG_UNLESS(IsRdmaCcSupported(cc), "CC mode " << cc << " does not use the INT header format of the network");
+	qp->StopTimers();
+	qp->m_rate = qp->GetMaxRate();
+	qp->m_cc = MakeRdmaCcState(cc, qp->GetMaxRate());
+}
+
+void RdmaHw::ReceiveAck(Ptr<RdmaTxQueuePair> qp, const RdmaCcFeedback& fb){
+	std::visit([&](auto& cc){ HandleAck(qp, cc, fb); }, qp->m_cc);
+}
+
+void RdmaHw::ReceiveCnp(Ptr<RdmaTxQueuePair> qp){
+	if (std::holds_alternative<DcqcnCc>(qp->m_cc))
+		cnp_received_mlx(qp);
+}
+
 void RdmaHw::UpdateNextAvail(Ptr<RdmaTxQueuePair> qp, Time interframeGap, uint32_t pkt_size){
 	Time sendingTime;
 	if (m_rateBound)
@@ -342,6 +551,9 @@ void RdmaHw::ChangeRate(Ptr<RdmaTxQueuePair> qp, DataRate new_rate){
 
 	// change to new rate
 	qp->m_rate = new_rate;
+
+	// the next avail time and the window may have changed
+	m_nic[0].GetDevice()->GetRdmaQueue()->UpdateQp(qp);
 }
 
 #define PRINT_LOG 0
@@ -349,80 +561,209 @@ void RdmaHw::ChangeRate(Ptr<RdmaTxQueuePair> qp, DataRate new_rate){
  * Mellanox's version of DCQCN
  *****************************/
 void RdmaHw::UpdateAlphaMlx(Ptr<RdmaTxQueuePair> q){
+	AlphaTickMlx(q);
+	ScheduleUpdateAlphaMlx(q);
+}
+void RdmaHw::AlphaTickMlx(Ptr<RdmaTxQueuePair> q){
+	DcqcnCc& mlx = q->Dcqcn();
 	#if PRINT_LOG
-	//std::cout << Simulator::Now() << " alpha update:" << m_node->GetId() << ' ' << q->mlx.m_alpha << ' ' << (int)q->mlx.m_alpha_cnp_arrived << '\n';
-	//printf("%lu alpha update: %08x %08x %u %u %.6lf->", Simulator::Now().GetTimeStep(), q->sip.Get(), q->dip.Get(), q->sport, q->dport, q->mlx.m_alpha);
+	//std::cout << Simulator::Now() << " alpha update:" << m_node->GetId() << ' ' << mlx.m_alpha << ' ' << (int)mlx.m_alpha_cnp_arrived << '\n';
+	//printf("%lu alpha update: %08x %08x %u %u %.6lf->", Simulator::Now().GetTimeStep(), q->sip.Get(), q->dip.Get(), q->sport, q->dport, mlx.m_alpha);
 	#endif
-	if (q->mlx.m_alpha_cnp_arrived){
-		q->mlx.m_alpha = (1 - m_g)*q->mlx.m_alpha + m_g; 	//binary feedback
+	if (mlx.m_alpha_cnp_arrived){
+		mlx.m_alpha = (1 - m_g)*mlx.m_alpha + m_g; 	//binary feedback
 	}else {
-		q->mlx.m_alpha = (1 - m_g)*q->mlx.m_alpha; 	//binary feedback
+		mlx.m_alpha = (1 - m_g)*mlx.m_alpha; 	//binary feedback
 	}
 	#if PRINT_LOG
-	//printf("%.6lf\n", q->mlx.m_alpha);
+	//printf("%.6lf\n", mlx.m_alpha);
 	#endif
-	q->mlx.m_alpha_cnp_arrived = false; // clear the CNP_arrived bit
-	ScheduleUpdateAlphaMlx(q);
+	mlx.m_alpha_cnp_arrived = false; // clear the CNP_arrived bit
 }
 void RdmaHw::ScheduleUpdateAlphaMlx(Ptr<RdmaTxQueuePair> q){
-	q->mlx.m_eventUpdateAlpha = Simulator::Schedule(MicroSeconds(m_alpha_resume_interval), &RdmaHw::UpdateAlphaMlx, this, q);
+	DcqcnCc& mlx = q->Dcqcn();
+	m_timers.Schedule(mlx.m_eventUpdateAlpha, MicroSeconds(m_alpha_resume_interval), [this, q = PeekPointer(q)] { UpdateAlphaMlx(q); });
 }
 
 void RdmaHw::cnp_received_mlx(Ptr<RdmaTxQueuePair> q){
-	q->mlx.m_alpha_cnp_arrived = true; // set CNP_arrived bit for alpha update
-	q->mlx.m_decrease_cnp_arrived = true; // set CNP_arrived bit for rate decrease
-	if (q->mlx.m_first_cnp){
+	DcqcnCc& mlx = q->Dcqcn();
+	UpdateDcqcn(q); // the updates due before this CNP
+	mlx.m_alpha_cnp_arrived = true; // set CNP_arrived bit for alpha update
+	mlx.m_decrease_cnp_arrived = true; // set CNP_arrived bit for rate decrease
+	if (mlx.m_first_cnp){
 		// init alpha
-		q->mlx.m_alpha = 1;
-		q->mlx.m_alpha_cnp_arrived = false;
-		// schedule alpha update
-		ScheduleUpdateAlphaMlx(q);
-		// schedule rate decrease
-		ScheduleDecreaseRateMlx(q, 1); // add 1 ns to make sure rate decrease is after alpha update
+		mlx.m_alpha = 1;
+		mlx.m_alpha_cnp_arrived = false;
+		if (m_dcqcnAnalytic){
+			const Time now = Simulator::Now();
+			mlx.m_nextAlpha = now + MicroSeconds(m_alpha_resume_interval);
+			mlx.m_nextDecrease = now + MicroSeconds(m_rateDecreaseInterval) + NanoSeconds(1);
+			mlx.m_rateIncActive = false;
+		}else {
+			// schedule alpha update
+			ScheduleUpdateAlphaMlx(q);
+			// schedule rate decrease
+			ScheduleDecreaseRateMlx(q, 1); // add 1 ns to make sure rate decrease is after alpha update
+		}
 		// set rate on first CNP
-		q->mlx.m_targetRate = q->m_rate = m_rateOnFirstCNP * q->m_rate;
-		q->mlx.m_first_cnp = false;
+		mlx.m_targetRate = q->m_rate = m_rateOnFirstCNP * q->m_rate;
+		mlx.m_first_cnp = false;
 	}
 }
 
 void RdmaHw::CheckRateDecreaseMlx(Ptr<RdmaTxQueuePair> q){
+	DcqcnCc& mlx = q->Dcqcn();
 	ScheduleDecreaseRateMlx(q, 0);
-	if (q->mlx.m_decrease_cnp_arrived){
-		#if PRINT_LOG
-		printf("%lu rate dec: %08x %08x %u %u (%0.3lf %.3lf)->", Simulator::Now().GetTimeStep(), q->sip.Get(), q->dip.Get(), q->sport, q->dport, q->mlx.m_targetRate.GetBitRate() * 1e-9, q->m_rate.GetBitRate() * 1e-9);
-		#endif
-		bool clamp = true;
-		if (!m_EcnClampTgtRate){
-			if (q->mlx.m_rpTimeStage == 0)
-				clamp = false;
-		}
-		if (clamp)
-			q->mlx.m_targetRate = q->m_rate;
-		q->m_rate = std::max(m_minRate, q->m_rate * (1 - q->mlx.m_alpha / 2));
-		// reset rate increase related things
-		q->mlx.m_rpTimeStage = 0;
-		q->mlx.m_decrease_cnp_arrived = false;
-		Simulator::Cancel(q->mlx.m_rpTimer);
-		q->mlx.m_rpTimer = Simulator::Schedule(MicroSeconds(m_rpgTimeReset), &RdmaHw::RateIncEventTimerMlx, this, q);
-		#if PRINT_LOG
-		printf("(%.3lf %.3lf)\n", q->mlx.m_targetRate.GetBitRate() * 1e-9, q->m_rate.GetBitRate() * 1e-9);
-		#endif
+	if (DecreaseTickMlx(q)){
+		m_timers.Schedule(mlx.m_rpTimer, MicroSeconds(m_rpgTimeReset), [this, q = PeekPointer(q)] { RateIncEventTimerMlx(q); });
+	}
+}
+bool RdmaHw::DecreaseTickMlx(Ptr<RdmaTxQueuePair> q){
+	DcqcnCc& mlx = q->Dcqcn();
+	if (!mlx.m_decrease_cnp_arrived){
+		return false;
 	}
+	#if PRINT_LOG
+	printf("%lu rate dec: %08x %08x %u %u (%0.3lf %.3lf)->", Simulator::Now().GetTimeStep(), q->sip.Get(), q->dip.Get(), q->sport, q->dport, mlx.m_targetRate.GetBitRate() * 1e-9, q->m_rate.GetBitRate() * 1e-9);
+	#endif
+	bool clamp = true;
+	if (!m_EcnClampTgtRate){
+		if (mlx.m_rpTimeStage == 0)
+			clamp = false;
+	}
+	if (clamp)
+		mlx.m_targetRate = q->m_rate;
+	q->m_rate = std::max(m_minRate, q->m_rate * (1 - mlx.m_alpha / 2));
+	// reset rate increase related things
+	mlx.m_rpTimeStage = 0;
+	mlx.m_decrease_cnp_arrived = false;
+	#if PRINT_LOG
+	printf("(%.3lf %.3lf)\n", mlx.m_targetRate.GetBitRate() * 1e-9, q->m_rate.GetBitRate() * 1e-9);
+	#endif
+	return true;
 }
 void RdmaHw::ScheduleDecreaseRateMlx(Ptr<RdmaTxQueuePair> q, uint32_t delta){
-	q->mlx.m_eventDecreaseRate = Simulator::Schedule(MicroSeconds(m_rateDecreaseInterval) + NanoSeconds(delta), &RdmaHw::CheckRateDecreaseMlx, this, q);
+	DcqcnCc& mlx = q->Dcqcn();
+	m_timers.Schedule(mlx.m_eventDecreaseRate, MicroSeconds(m_rateDecreaseInterval) + NanoSeconds(delta), [this, q = PeekPointer(q)] { CheckRateDecreaseMlx(q); });
+}
+
+namespace {
+
+/**
+ * @brief Advance a periodic timer of the analytic mode past `now`.
+ * @return The count of ticks due, that is with a time before or at `now`.
+ */
+uint64_t AdvanceTicks(Time& due, Time interval, Time now)
+{
+	if (due > now)
+		return 0;
+	const uint64_t n = (now - due).GetTimeStep() / interval.GetTimeStep() + 1;
+	due += interval * int64_t(n);
+	return n;
+}
+
+} // namespace
+
+void RdmaHw::UpdateDcqcn(Ptr<RdmaTxQueuePair> q){
+	if (!m_dcqcnAnalytic)
+		return;
+	DcqcnCc* cc = std::get_if<DcqcnCc>(&q->m_cc);
+	if (!cc || cc->m_first_cnp)
+		return;
+	DcqcnCc& mlx = *cc;
+
+	enum Timer { ALPHA, DECREASE, RATE_INC };
+	const Time now = Simulator::Now();
+	const Time itv[3] = {MicroSeconds(m_alpha_resume_interval), MicroSeconds(m_rateDecreaseInterval), MicroSeconds(m_rpgTimeReset)};
+	Time* due[3] = {&mlx.m_nextAlpha, &mlx.m_nextDecrease, &mlx.m_nextRateInc};
+
+	// While a CNP is pending, the timers depend on each other (the rate decrease uses alpha, and restarts the rate increase),
+	// so they are replayed one by one. Only a few ticks: the CNP is consumed by the first alpha update and rate decrease.
+	while (mlx.m_alpha_cnp_arrived || mlx.m_decrease_cnp_arrived){
+		// Find the next timer to fire.
+		// At the same time, the one scheduled first (longest interval) fires first, as in the event queue.
+		int next = -1;
+		for (int k : {DECREASE, ALPHA, RATE_INC}){
+			if (k == RATE_INC && !mlx.m_rateIncActive)
+				continue;
+			if (next < 0 || *due[k] < *due[next] || (*due[k] == *due[next] && itv[k] > itv[next]))
+				next = k;
+		}
+		const Time t = *due[next];
+		if (t > now)
+			return;
+
+		*due[next] += itv[next];
+		if (next == ALPHA){
+			AlphaTickMlx(q);
+		}else if (next == DECREASE){
+			if (DecreaseTickMlx(q)){
+				mlx.m_rateIncActive = true;
+				mlx.m_nextRateInc = t + itv[RATE_INC];
+			}
+		}else {
+			RateIncEventMlx(q);
+			mlx.m_rpTimeStage++;
+		}
+	}
+
+	// Without CNP, the timers are independent, and all the ticks of each one are applied at once
+	const uint64_t alphaTicks = AdvanceTicks(mlx.m_nextAlpha, itv[ALPHA], now);
+	if (alphaTicks > 0)
+		mlx.m_alpha *= std::pow(1 - m_g, double(alphaTicks));
+	AdvanceTicks(mlx.m_nextDecrease, itv[DECREASE], now); // no CNP, no decrease
+	if (mlx.m_rateIncActive)
+		RateIncTicksMlx(q, AdvanceTicks(mlx.m_nextRateInc, itv[RATE_INC], now));
+}
+
+void RdmaHw::RateIncTicksMlx(Ptr<RdmaTxQueuePair> q, uint64_t n){
+	DcqcnCc& mlx = q->Dcqcn();
+
+	// Fast recovery and active increase, at most `m_rpgThreshold + 1` ticks
+	for (; n > 0 && mlx.m_rpTimeStage <= m_rpgThreshold; n--){
+		RateIncEventMlx(q);
+		mlx.m_rpTimeStage++;
+	}
+	if (n == 0)
+		return;
+	mlx.m_rpTimeStage = std::min<uint64_t>(uint64_t(mlx.m_rpTimeStage) + n, std::numeric_limits<uint32_t>::max());
+
+	// Hyper increase: each tick, the target T grows by `m_rhai` up to the line rate L, and the rate R moves halfway to T.
+	// While T grows: T_j = T_0 + j * rhai, and R_j = T_j - rhai + (R_0 - T_0 + rhai) / 2^j.
+	// Once T = L: R_j = L - (L - R) / 2^j.
+	// Equal to `n` calls of `HyperIncreaseMlx()`, except that these truncate the rates to bit/s at each tick.
+	const double line = q->GetDevice()->GetDataRate().GetBitRate();
+	const double hai = m_rhai.GetBitRate();
+	double target = mlx.m_targetRate.GetBitRate();
+	double rate = q->m_rate.GetBitRate();
+
+	uint64_t growing = n; // ticks before the tick capping T
+	if (hai > 0)
+		growing = std::min<uint64_t>(n, std::max(std::ceil((line - target) / hai), 1.0) - 1);
+	if (growing > 0){
+		rate = target + (growing - 1) * hai + std::ldexp(rate - target + hai, -int(std::min<uint64_t>(growing, 2048)));
+		target += growing * hai;
+	}
+	if (n > growing){
+		target = line;
+		rate = line - std::ldexp(line - rate, -int(std::min<uint64_t>(n - growing, 2048)));
+	}
+	mlx.m_targetRate = DataRate(uint64_t(target));
+	q->m_rate = DataRate(uint64_t(rate));
 }
 
 void RdmaHw::RateIncEventTimerMlx(Ptr<RdmaTxQueuePair> q){
-	q->mlx.m_rpTimer = Simulator::Schedule(MicroSeconds(m_rpgTimeReset), &RdmaHw::RateIncEventTimerMlx, this, q);
+	DcqcnCc& mlx = q->Dcqcn();
+	m_timers.Schedule(mlx.m_rpTimer, MicroSeconds(m_rpgTimeReset), [this, q = PeekPointer(q)] { RateIncEventTimerMlx(q); });
 	RateIncEventMlx(q);
-	q->mlx.m_rpTimeStage++;
+	mlx.m_rpTimeStage++;
 }
 void RdmaHw::RateIncEventMlx(Ptr<RdmaTxQueuePair> q){
+	DcqcnCc& mlx = q->Dcqcn();
 	// check which increase phase: fast recovery, active increase, hyper increase
-	if (q->mlx.m_rpTimeStage < m_rpgThreshold){ // fast recovery
+	if (mlx.m_rpTimeStage < m_rpgThreshold){ // fast recovery
 		FastRecoveryMlx(q);
-	}else if (q->mlx.m_rpTimeStage == m_rpgThreshold){ // active increase
+	}else if (mlx.m_rpTimeStage == m_rpgThreshold){ // active increase
 		ActiveIncreaseMlx(q);
 	}else { // hyper increase
 		HyperIncreaseMlx(q);
@@ -430,43 +771,299 @@ void RdmaHw::RateIncEventMlx(Ptr<RdmaTxQueuePair> q){
 }
 
 void RdmaHw::FastRecoveryMlx(Ptr<RdmaTxQueuePair> q){
+	DcqcnCc& mlx = q->Dcqcn();
 	#if PRINT_LOG
-	printf("%lu fast recovery: %08x %08x %u %u (%0.3lf %.3lf)->", Simulator::Now().GetTimeStep(), q->sip.Get(), q->dip.Get(), q->sport, q->dport, q->mlx.m_targetRate.GetBitRate() * 1e-9, q->m_rate.GetBitRate() * 1e-9);
+	printf("%lu fast recovery: %08x %08x %u %u (%0.3lf %.3lf)->", Simulator::Now().GetTimeStep(), q->sip.Get(), q->dip.Get(), q->sport, q->dport, mlx.m_targetRate.GetBitRate() * 1e-9, q->m_rate.GetBitRate() * 1e-9);
 	#endif
-	q->m_rate = (q->m_rate / 2) + (q->mlx.m_targetRate / 2);
+	q->m_rate = (q->m_rate / 2) + (mlx.m_targetRate / 2);
 	#if PRINT_LOG
-	printf("(%.3lf %.3lf)\n", q->mlx.m_targetRate.GetBitRate() * 1e-9, q->m_rate.GetBitRate() * 1e-9);
+	printf("(%.3lf %.3lf)\n", mlx.m_targetRate.GetBitRate() * 1e-9, q->m_rate.GetBitRate() * 1e-9);
 	#endif
 }
 void RdmaHw::ActiveIncreaseMlx(Ptr<RdmaTxQueuePair> q){
+	DcqcnCc& mlx = q->Dcqcn();
 	#if PRINT_LOG
-	printf("%lu active inc: %08x %08x %u %u (%0.3lf %.3lf)->", Simulator::Now().GetTimeStep(), q->sip.Get(), q->dip.Get(), q->sport, q->dport, q->mlx.m_targetRate.GetBitRate() * 1e-9, q->m_rate.GetBitRate() * 1e-9);
+	printf("%lu active inc: %08x %08x %u %u (%0.3lf %.3lf)->", Simulator::Now().GetTimeStep(), q->sip.Get(), q->dip.Get(), q->sport, q->dport, mlx.m_targetRate.GetBitRate() * 1e-9, q->m_rate.GetBitRate() * 1e-9);
 	#endif
 	// get NIC
 	Ptr<QbbNetDevice> dev = q->GetDevice();
 	// increate rate
-	q->mlx.m_targetRate += m_rai;
-	if (q->mlx.m_targetRate > dev->GetDataRate())
-		q->mlx.m_targetRate = dev->GetDataRate();
-	q->m_rate = (q->m_rate / 2) + (q->mlx.m_targetRate / 2);
+	mlx.m_targetRate += m_rai;
+	if (mlx.m_targetRate > dev->GetDataRate())
+		mlx.m_targetRate = dev->GetDataRate();
+	q->m_rate = (q->m_rate / 2) + (mlx.m_targetRate / 2);
 	#if PRINT_LOG
-	printf("(%.3lf %.3lf)\n", q->mlx.m_targetRate.GetBitRate() * 1e-9, q->m_rate.GetBitRate() * 1e-9);
+	printf("(%.3lf %.3lf)\n", mlx.m_targetRate.GetBitRate() * 1e-9, q->m_rate.GetBitRate() * 1e-9);
 	#endif
 }
 void RdmaHw::HyperIncreaseMlx(Ptr<RdmaTxQueuePair> q){
+	DcqcnCc& mlx = q->Dcqcn();
 	#if PRINT_LOG
-	printf("%lu hyper inc: %08x %08x %u %u (%0.3lf %.3lf)->", Simulator::Now().GetTimeStep(), q->sip.Get(), q->dip.Get(), q->sport, q->dport, q->mlx.m_targetRate.GetBitRate() * 1e-9, q->m_rate.GetBitRate() * 1e-9);
+	printf("%lu hyper inc: %08x %08x %u %u (%0.3lf %.3lf)->", Simulator::Now().GetTimeStep(), q->sip.Get(), q->dip.Get(), q->sport, q->dport, mlx.m_targetRate.GetBitRate() * 1e-9, q->m_rate.GetBitRate() * 1e-9);
 	#endif
 	// get NIC
 	Ptr<QbbNetDevice> dev = q->GetDevice();
 	// increate rate
-	q->mlx.m_targetRate += m_rhai;
-	if (q->mlx.m_targetRate > dev->GetDataRate())
-		q->mlx.m_targetRate = dev->GetDataRate();
-	q->m_rate = (q->m_rate / 2) + (q->mlx.m_targetRate / 2);
+	mlx.m_targetRate += m_rhai;
+	if (mlx.m_targetRate > dev->GetDataRate())
+		mlx.m_targetRate = dev->GetDataRate();
+	q->m_rate = (q->m_rate / 2) + (mlx.m_targetRate / 2);
 	#if PRINT_LOG
-	printf("(%.3lf %.3lf)\n", q->mlx.m_targetRate.GetBitRate() * 1e-9, q->m_rate.GetBitRate() * 1e-9);
+	printf("(%.3lf %.3lf)\n", mlx.m_targetRate.GetBitRate() * 1e-9, q->m_rate.GetBitRate() * 1e-9);
 	#endif
 }
 
+/******************************
+ * Congestion control engine
+ *****************************/
+void RdmaHw::HandleAck(Ptr<RdmaTxQueuePair> q, DcqcnCc& cc, const RdmaCcFeedback& fb){
+	if (fb.ecn)
+		cnp_received_mlx(q);
+}
+
+/******************************
+ * HPCC
+ *****************************/
+void RdmaHw::HandleAck(Ptr<RdmaTxQueuePair> q, HpccCc& cc, const RdmaCcFeedback& fb){
+	if (fb.ack_seq > cc.m_lastUpdateSeq){ // if full RTT feedback is ready, do full update
+		UpdateRateHp(q, cc, fb, false);
+	}else if (m_fast_react){ // do fast react
+		UpdateRateHp(q, cc, fb, true);
+	}
+}
+
+void RdmaHw::UpdateRateHp(Ptr<RdmaTxQueuePair> q, HpccCc& cc, const RdmaCcFeedback& fb, bool fast_react){
+	const uint32_t next_seq = fb.snd_nxt;
+	IntHeader ih = *fb.ih;
+	if (cc.m_lastUpdateSeq == 0){ // first RTT
+		cc.m_lastUpdateSeq = next_seq;
+		// store INT
+		NS_ASSERT(ih.nhop <= IntHeader::maxHop);
+		for (uint32_t i = 0; i < ih.nhop; i++)
+			cc.hop[i] = ih.hop[i];
+		return;
+	}
+
+	// check packet INT
+	if (ih.nhop <= IntHeader::maxHop){
+		const uint64_t baseRtt = m_baseRtt.GetNanoSeconds();
+		const double win = q->GetMaxRate() * m_baseRtt / 8; // BDP (bytes)
+		// check each hop
+		double U = 0;
+		uint64_t dt = 0;
+		bool updated_any = false;
+		for (uint32_t i = 0; i < ih.nhop; i++){
+			NS_ASSERT(ih.hop[i].GetLineRate() == cc.hop[i].GetLineRate());
+			const uint64_t tau = ih.hop[i].GetTimeDelta(cc.hop[i]);
+			if (tau == 0) // no new sample of this hop
+				continue;
+			updated_any = true;
+			double duration = tau * 1e-9;
+			double txRate = (ih.hop[i].GetBytesDelta(cc.hop[i])) * 8 / duration;
+			double u = txRate / ih.hop[i].GetLineRate() + (double)std::min(ih.hop[i].GetQlen(), cc.hop[i].GetQlen()) * q->GetMaxRate().GetBitRate() / ih.hop[i].GetLineRate() / win;
+			if (u > U){
+				U = u;
+				dt = tau;
+			}
+			cc.hop[i] = ih.hop[i];
+		}
+
+		if (updated_any){
+			if (dt > baseRtt)
+				dt = baseRtt;
+			cc.u = (cc.u * (baseRtt - dt) + U * dt) / double(baseRtt);
+			double max_c = cc.u / m_targetUtil;
+
+			DataRate new_rate;
+			uint32_t new_incStage;
+			if (max_c >= 1 || cc.m_incStage >= m_miThresh){
+				new_rate = cc.m_curRate / max_c + m_rai;
+				new_incStage = 0;
+			}else{
+				new_rate = cc.m_curRate + m_rai;
+				new_incStage = cc.m_incStage+1;
+			}
+			if (new_rate < m_minRate)
+				new_rate = m_minRate;
+			if (new_rate > q->GetMaxRate())
+				new_rate = q->GetMaxRate();
+			ChangeRate(q, new_rate);
+			if (!fast_react){
+				cc.m_curRate = new_rate;
+				cc.m_incStage = new_incStage;
+			}
+		}
+	}
+	if (!fast_react){
+		if (next_seq > cc.m_lastUpdateSeq)
+			cc.m_lastUpdateSeq = next_seq;
+	}
+}
+
+/******************************
+ * TIMELY
+ *****************************/
+void RdmaHw::HandleAck(Ptr<RdmaTxQueuePair> q, TimelyCc& cc, const RdmaCcFeedback& fb){
+	// The rate is only updated with a full RTT feedback
+	if (fb.ack_seq <= cc.m_lastUpdateSeq)
+		return;
+
+	const uint32_t next_seq = fb.snd_nxt;
+	const uint64_t rtt = Simulator::Now().GetTimeStep() - fb.ih->ts;
+	if (cc.m_lastUpdateSeq != 0){ // not first RTT
+		int64_t new_rtt_diff = (int64_t)rtt - (int64_t)cc.lastRtt;
+		double rtt_diff = (1 - m_tmly_alpha) * cc.rttDiff + m_tmly_alpha * new_rtt_diff;
+		double gradient = rtt_diff / m_tmly_minRtt;
+		bool inc = false;
+		double c = 0;
+		if (rtt < m_tmly_TLow){
+			inc = true;
+		}else if (rtt > m_tmly_THigh){
+			c = 1 - m_tmly_beta * (1 - (double)m_tmly_THigh / rtt);
+			inc = false;
+		}else if (gradient <= 0){
+			inc = true;
+		}else{
+			c = 1 - m_tmly_beta * gradient;
+			if (c < 0)
+				c = 0;
+			inc = false;
+		}
+		DataRate new_rate;
+		if (inc){
+			if (cc.m_incStage < 5){
+				new_rate = cc.m_curRate + m_rai;
+			}else{
+				new_rate = cc.m_curRate + m_rhai;
+			}
+			if (new_rate > q->GetMaxRate())
+				new_rate = q->GetMaxRate();
+			cc.m_incStage++;
+		}else{
+			new_rate = std::max(m_minRate, cc.m_curRate * c);
+			cc.m_incStage = 0;
+		}
+		q->m_rate = cc.m_curRate = new_rate;
+		cc.rttDiff = rtt_diff;
+	}
+	cc.m_lastUpdateSeq = next_seq;
+	cc.lastRtt = rtt;
+}
+
+/******************************
+ * DCTCP
+ *****************************/
+void RdmaHw::HandleAck(Ptr<RdmaTxQueuePair> q, DctcpCc& cc, const RdmaCcFeedback& fb){
+	const uint32_t ack_seq = fb.ack_seq;
+	bool new_batch = false;
+
+	// update alpha
+	cc.m_ecnCnt += fb.ecn;
+	if (ack_seq > cc.m_lastUpdateSeq){ // if full RTT feedback is ready, do alpha update
+		new_batch = true;
+		if (cc.m_lastUpdateSeq == 0){ // first RTT
+			cc.m_lastUpdateSeq = fb.snd_nxt;
+			cc.m_batchSizeOfAlpha = fb.snd_nxt / m_mtu + 1;
+		}else {
+			double frac = std::min(1.0, double(cc.m_ecnCnt) / cc.m_batchSizeOfAlpha);
+			cc.m_alpha = (1 - m_g) * cc.m_alpha + m_g * frac;
+			cc.m_lastUpdateSeq = fb.snd_nxt;
+			cc.m_ecnCnt = 0;
+			cc.m_batchSizeOfAlpha = (fb.snd_nxt - ack_seq) / m_mtu + 1;
+		}
+	}
+
+	// check cwr exit
+	if (cc.m_caState == 1){
+		if (ack_seq > cc.m_highSeq)
+			cc.m_caState = 0;
+	}
+
+	// check if need to reduce rate: ECN and not in CWR
+	if (fb.ecn && cc.m_caState == 0){
+		q->m_rate = std::max(m_minRate, q->m_rate * (1 - cc.m_alpha / 2));
+		cc.m_caState = 1;
+		cc.m_highSeq = fb.snd_nxt;
+	}
+
+	// additive inc
+	if (cc.m_caState == 0 && new_batch)
+		q->m_rate = std::min(q->GetMaxRate(), q->m_rate + m_dctcp_rai);
+}
+
+/*********************
+ * HPCC-PINT
+ ********************/
+void RdmaHw::HandleAck(Ptr<RdmaTxQueuePair> q, HpccPintCc& cc, const RdmaCcFeedback& fb){
+	if (m_pint_prob < 1 && m_pint_rng->GetValue() >= m_pint_prob)
+		return;
+	// update rate
+	if (fb.ack_seq > cc.m_lastUpdateSeq){ // if full RTT feedback is ready, do full update
+		UpdateRateHpPint(q, cc, fb, false);
+	}else{ // do fast react
+		UpdateRateHpPint(q, cc, fb, true);
+	}
+}
+
+void RdmaHw::UpdateRateHpPint(Ptr<RdmaTxQueuePair> q, HpccPintCc& cc, const RdmaCcFeedback& fb, bool fast_react){
+	const uint32_t next_seq = fb.snd_nxt;
+	if (cc.m_lastUpdateSeq == 0){ // first RTT
+		cc.m_lastUpdateSeq = next_seq;
+		return;
+	}
+
+	// check packet INT
+	IntHeader ih = *fb.ih;
+	double U = Pint::decode_u(ih.GetPower());
+
+	DataRate new_rate;
+	uint32_t new_incStage;
+	double max_c = U / m_targetUtil;
+
+	if (max_c >= 1 || cc.m_incStage >= m_miThresh){
+		new_rate = cc.m_curRate / max_c + m_rai;
+		new_incStage = 0;
+	}else{
+		new_rate = cc.m_curRate + m_rai;
+		new_incStage = cc.m_incStage+1;
+	}
+	if (new_rate < m_minRate)
+		new_rate = m_minRate;
+	if (new_rate > q->GetMaxRate())
+		new_rate = q->GetMaxRate();
+	ChangeRate(q, new_rate);
+	if (!fast_react){
+		cc.m_curRate = new_rate;
+		cc.m_incStage = new_incStage;
+		if (next_seq > cc.m_lastUpdateSeq)
+			cc.m_lastUpdateSeq = next_seq;
+	}
+}
+
+/*********************
+ * Swift
+ * Rate-based like the other algorithms of the NIC, instead of a congestion window.
+ ********************/
+void RdmaHw::HandleAck(Ptr<RdmaTxQueuePair> q, SwiftCc& cc, const RdmaCcFeedback& fb){
+	const Time now = Simulator::Now();
+	const Time rtt = now - TimeStep(fb.ih->ts);
+
+	if (rtt < m_swift_target){
+		// additive increase, once per RTT
+		if (fb.ack_seq > cc.m_lastUpdateSeq){
+			cc.m_lastUpdateSeq = fb.snd_nxt;
+			cc.m_curRate = std::min(q->GetMaxRate(), cc.m_curRate + m_rai);
+			q->m_rate = cc.m_curRate;
+		}
+	}else if (now - cc.m_lastDecrease >= rtt){
+		// multiplicative decrease proportional to the excess of delay, at most once per RTT
+		const double excess = (rtt - m_swift_target).GetSeconds() / rtt.GetSeconds();
+		const double c = std::max(1 - m_swift_beta * excess, 1 - m_swift_maxMdf);
+		cc.m_curRate = std::max(m_minRate, cc.m_curRate * c);
+		cc.m_lastDecrease = now;
+		cc.m_lastUpdateSeq = fb.snd_nxt;
+		ChangeRate(q, cc.m_curRate);
+	}
+}
+
 }
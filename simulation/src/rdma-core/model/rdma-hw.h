@@ -8,21 +8,45 @@
 #include <ns3/json.h>
 #include <ns3/rdma-reliable-qp.h>
 #include <ns3/rdma-unreliable-qp.h>
+#include <ns3/rdma-qp-table.h>
+#include <ns3/rdma-nic-cache.h>
+#include <ns3/rdma-timer-wheel.h>
 #include "qbb-net-device.h"
 #include <unordered_map>
 #include <functional>
 #include "pint.h"
+#include <ns3/random-variable-stream.h>
 
 namespace ns3 {
 
 class RdmaHw : public Object {
+	// The per-packet calls of the NIC are direct calls
+	friend class QbbNetDevice;
+	friend class RdmaEgressQueue;
+
 public:
 
 	static TypeId GetTypeId (void);
 
 	void Setup(); // setup shared data and callbacks with the QbbNetDevice
+	/**
+	 * @brief Allocate the QPN of the QP (see `RdmaTxQueuePair::GetQpn()`) and attach the QP to the NIC.
+	 */
 	void RegisterQP(Ptr<RdmaTxQueuePair> sq, Ptr<RdmaRxQueuePair> rq);
-	void DeleteRxQp(uint32_t dip, uint16_t pg, uint16_t dport);
+
+	/**
+	 * @brief Make the QP reachable by packets without destination QPN, by the source port of the QP.
+	 * 
+	 * For the QPs whose remote QPN is not known, for example the receivers of a multicast group.
+	 * Only one QP can be bound to a port.
+	 */
+	void BindPort(Ptr<RdmaTxQueuePair> sq);
+
+	/**
+	 * @brief Detach the QP from the NIC and free its QPN, to be reused by a next QP.
+	 * The packets still in flight to the QP are dropped.
+	 */
+	void DestroyQP(Ptr<RdmaTxQueuePair> sq);
 
 	// call this function after the NIC is setup
 	void AddTableEntry(const Ipv4Address &dstAddr, uint32_t intf_idx);
@@ -30,24 +54,79 @@ public:
 	void RedistributeQp();
 
 	uint32_t GetCC() const { return m_cc_mode; }
+
+	/**
+	 * @brief Select the congestion control algorithm of an SQ, instead of the `CcMode` of the NIC.
+	 * 
+	 * Should be called before the SQ sends, because the state of the congestion control restarts from the line rate.
+	 * The algorithm should use the same INT header format as the network (see `IsRdmaCcSupported()`).
+	 * 
+	 * @param cc One of `RdmaCcMode`.
+	 */
+	void SetCcMode(Ptr<RdmaTxQueuePair> qp, uint32_t cc);
+
+	/**
+	 * @brief Feed the congestion control of the SQ with an ACK or a NACK.
+	 */
+	void ReceiveAck(Ptr<RdmaTxQueuePair> qp, const RdmaCcFeedback& fb);
+
+	/**
+	 * @brief Feed the congestion control of the SQ with a CNP.
+	 * Only DCQCN reacts to CNPs, the other algorithms get the ECN echo with the ACKs.
+	 */
+	void ReceiveCnp(Ptr<RdmaTxQueuePair> qp);
 	uint32_t GetMTU() const { return m_mtu; }
 
+	/**
+	 * @brief Create a QP bound to its source port (see `BindPort()`).
+	 */
 	RdmaReliableQP CreateReliableQP(uint16_t pg, uint16_t sport, Ipv4Address dip, uint16_t dport);
 	RdmaUnreliableQP CreateUnreliableQP(uint16_t pg, uint16_t sport);
 
-	const std::unordered_map<uint64_t, Ptr<RdmaTxQueuePair>>& GetAllSQs() const 
+	const RdmaQpTable& GetQpTable() const 
 	{
-		return m_qpMap;
+		return m_qps;
+	}
+
+	/**
+	 * @brief Payload counters of the RC SQs of the NIC, including the destroyed ones.
+	 */
+	struct RcStats
+	{
+		uint64_t tx_bytes{};
+		uint64_t retx_bytes{};
+		uint64_t acked_bytes{};
+	};
+
+	RcStats GetRcStats() const;
+
+	/**
+	 * @brief QPC and MTT caches of the NIC, disabled unless `QpcCacheEntries` or `MttCacheEntries` is set.
+	 */
+	const RdmaNicCaches& GetNicCaches() const
+	{
+		return m_caches;
+	}
+
+	/**
+	 * @brief Timers of the QPs of the NIC, a timing wheel if `TimerWheelTick` is set.
+	 */
+	RdmaTimerWheel& GetTimerWheel()
+	{
+		return m_timers;
+	}
+	const RdmaTimerWheel& GetTimerWheel() const
+	{
+		return m_timers;
 	}
 	
 private:
-	static uint64_t GetRxQpKey(uint16_t dport); // get the lookup key for m_rxQpMap
 	uint32_t ResolveIface(Ipv4Address ip); //!< Get the interface connected to this IP.
 	void DeleteQueuePair(Ptr<RdmaTxQueuePair> qp);
-
-	Ptr<RdmaRxQueuePair> GetRxQp(uint32_t sip, uint32_t dip, uint16_t sport, uint16_t dport, uint16_t pg, bool create); // get a rxQp
+	uint32_t ResolvePort(const CustomHeader& ch) const; //!< Get the QPN bound to the destination port.
 	
 	int Receive(Ptr<Packet> p, CustomHeader &ch); // callback function that the QbbNetDevice should use when receive packets. Only NIC can call this function. And do not call this upon PFC
+	void DeliverToQp(Ptr<Packet> p, CustomHeader ch, uint32_t qpn); //!< Receive a packet delayed by a cache miss.
 
 	void CheckandSendQCN(Ptr<RdmaRxQueuePair> q);
 	bool SenderShouldReqAck(Ptr<RdmaTxQueuePair> q, uint64_t payload_size);
@@ -87,16 +166,35 @@ private:
 	uint32_t m_chunk;
 	uint32_t m_ack_interval;
 	bool m_backto0;
+	bool m_selectiveRepeat;
+	uint32_t m_ackCoalesceBytes;
+	Time m_ackCoalesceDelay;
 	bool m_var_win, m_fast_react;
 	bool m_rateBound;
 
 	std::vector<RdmaTxQueuePairGroup> m_nic; // list of running nic controlled by this RdmaHw
 	
-	/// @brief Each QP has a key. Mapping from the key to the QP.
-	std::unordered_map<uint64_t, Ptr<RdmaTxQueuePair> > m_qpMap;
+	/// @brief The QPs, by QPN.
+	RdmaQpTable m_qps;
+
+	/// @brief The QPN bound to each port (see `BindPort()`).
+	std::unordered_map<uint16_t, uint32_t> m_portQpn;
+
+	/// @brief Counters of the destroyed RC SQs.
+	RcStats m_destroyedRcStats;
+
+	RdmaNicCaches m_caches;
+	uint32_t m_qpcEntries;
+	uint32_t m_qpcWays;
+	Time m_qpcMissLatency;
+	uint32_t m_mttEntries;
+	uint32_t m_mttWays;
+	uint32_t m_mttPageSize;
+	Time m_mttMissLatency;
 
-	/// @brief The key is the same as in `m_qpMap`.
-	std::unordered_map<uint64_t, Ptr<RdmaRxQueuePair> > m_rxQpMap;
+	/// @brief Destroyed before the QPs holding its timers: safe, as its destructor disarms them all (`RdmaTimerWheel::Clear()`).
+	RdmaTimerWheel m_timers;
+	Time m_timerWheelTick;
 
 	/// @brief Routing table from IP to output port index.
 	std::unordered_map<uint32_t, int> m_rtTable;
@@ -126,6 +224,26 @@ private:
 public:
 	void cnp_received_mlx(Ptr<RdmaTxQueuePair> q);
 
+	/**
+	 * @brief In analytic mode, bring the DCQCN state of the QP up to date.
+	 * 
+	 * Instead of three periodic events per QP, the analytic mode stores when each timer would fire next,
+	 * and applies the missed updates when the QP is touched (CNP, ACK, sent packet).
+	 * The few ticks consuming a CNP are replayed in order, then the ticks without CNP are applied in closed form:
+	 * alpha decays by `(1 - g)^k`, the rate decreases are no-ops, and the rate increases follow from the stage counter.
+	 * So the cost does not depend on the time since the last update.
+	 * The state is the same as in timer mode, up to the rounding of alpha and of the rates.
+	 * Does nothing in timer mode.
+	 */
+	void UpdateDcqcn(Ptr<RdmaTxQueuePair> q);
+
+private:
+	bool m_dcqcnAnalytic;
+
+	// Body of the timers, shared by both modes
+	void AlphaTickMlx(Ptr<RdmaTxQueuePair> q);
+	bool DecreaseTickMlx(Ptr<RdmaTxQueuePair> q); // returns true if the rate was decreased
+
 private:
 	// Mellanox's version of rate decrease
 	// It checks every m_rateDecreaseInterval if CNP arrived (m_decrease_cnp_arrived).
@@ -136,9 +254,54 @@ private:
 	// Mellanox's version of rate increase
 	void RateIncEventTimerMlx(Ptr<RdmaTxQueuePair> q);
 	void RateIncEventMlx(Ptr<RdmaTxQueuePair> q);
+	void RateIncTicksMlx(Ptr<RdmaTxQueuePair> q, uint64_t n); // `n` rate increase ticks at once, for the analytic mode
 	void FastRecoveryMlx(Ptr<RdmaTxQueuePair> q);
 	void ActiveIncreaseMlx(Ptr<RdmaTxQueuePair> q);
 	void HyperIncreaseMlx(Ptr<RdmaTxQueuePair> q);
+
+	/******************************
+	 * Congestion control engine
+	 * One overload per algorithm, selected at compile time by `ReceiveAck()`.
+	 *****************************/
+	void HandleAck(Ptr<RdmaTxQueuePair> q, DcqcnCc& cc, const RdmaCcFeedback& fb);
+	void HandleAck(Ptr<RdmaTxQueuePair> q, HpccCc& cc, const RdmaCcFeedback& fb);
+	void HandleAck(Ptr<RdmaTxQueuePair> q, TimelyCc& cc, const RdmaCcFeedback& fb);
+	void HandleAck(Ptr<RdmaTxQueuePair> q, DctcpCc& cc, const RdmaCcFeedback& fb);
+	void HandleAck(Ptr<RdmaTxQueuePair> q, HpccPintCc& cc, const RdmaCcFeedback& fb);
+	void HandleAck(Ptr<RdmaTxQueuePair> q, SwiftCc& cc, const RdmaCcFeedback& fb);
+
+	/******************************
+	 * HPCC
+	 *****************************/
+	double m_targetUtil;
+	uint32_t m_miThresh;
+	Time m_baseRtt; // base RTT of the flows, the window is the BDP
+	void UpdateRateHp(Ptr<RdmaTxQueuePair> q, HpccCc& cc, const RdmaCcFeedback& fb, bool fast_react);
+
+	/******************************
+	 * TIMELY
+	 *****************************/
+	double m_tmly_alpha, m_tmly_beta;
+	uint64_t m_tmly_TLow, m_tmly_THigh, m_tmly_minRtt; // ns
+
+	/******************************
+	 * DCTCP
+	 *****************************/
+	DataRate m_dctcp_rai;
+
+	/******************************
+	 * HPCC-PINT
+	 *****************************/
+	double m_pint_prob; // probability to use the feedback of an ACK
+	Ptr<UniformRandomVariable> m_pint_rng;
+	void UpdateRateHpPint(Ptr<RdmaTxQueuePair> q, HpccPintCc& cc, const RdmaCcFeedback& fb, bool fast_react);
+
+	/******************************
+	 * Swift
+	 *****************************/
+	Time m_swift_target; // target delay
+	double m_swift_beta; // multiplicative decrease factor
+	double m_swift_maxMdf; // max multiplicative decrease per RTT
 };
 
 } /* namespace ns3 */
@@ -0,0 +1,201 @@
+#include <ns3/rdma-ladder-scheduler.h>
+#include <ns3/event-impl.h>
+#include <ns3/assert.h>
+#include <ns3/log.h>
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("RdmaLadderScheduler");
+NS_OBJECT_ENSURE_REGISTERED(RdmaLadderScheduler);
+
+namespace {
+
+/// @brief Order of the bottom list, the next event last.
+bool After(const Scheduler::Event& a, const Scheduler::Event& b)
+{
+	return b.key < a.key;
+}
+
+} // namespace
+
+TypeId RdmaLadderScheduler::GetTypeId()
+{
+	static TypeId tid = TypeId("ns3::RdmaLadderScheduler")
+		.SetParent<Scheduler>()
+		.AddConstructor<RdmaLadderScheduler>()
+		;
+	return tid;
+}
+
+RdmaLadderScheduler::RdmaLadderScheduler()
+{
+	NS_LOG_FUNCTION(this);
+}
+
+RdmaLadderScheduler::~RdmaLadderScheduler()
+{
+	NS_LOG_FUNCTION(this);
+}
+
+void RdmaLadderScheduler::Insert(const Event& ev)
+{
+	const uint64_t ts = ev.key.m_ts;
+	m_size++;
+
+	if (ts >= m_topStart) {
+		if (m_top.empty()) {
+			m_topMin = m_topMax = ts;
+		}
+		else {
+			m_topMin = std::min(m_topMin, ts);
+			m_topMax = std::max(m_topMax, ts);
+		}
+		m_top.push_back(ev);
+		return;
+	}
+
+	for (uint32_t i = 0; i < m_nRungs; i++) {
+		Rung& r = m_rungs[i];
+		if (ts >= r.CurStart()) {
+			const uint64_t b = (ts - r.start) / r.width;
+			NS_ASSERT(b < r.buckets);
+			r.m_buckets[b].push_back(ev);
+			r.count++;
+			return;
+		}
+	}
+
+	InsertBottom(ev);
+}
+
+bool RdmaLadderScheduler::IsEmpty() const
+{
+	return m_size == 0;
+}
+
+Scheduler::Event RdmaLadderScheduler::PeekNext() const
+{
+	NS_ASSERT(!IsEmpty());
+	// Sorting the next bucket does not change the content of the scheduler
+	const_cast<RdmaLadderScheduler*>(this)->FillBottom();
+	return m_bottom.back();
+}
+
+Scheduler::Event RdmaLadderScheduler::RemoveNext()
+{
+	NS_ASSERT(!IsEmpty());
+	FillBottom();
+	const Event ev = m_bottom.back();
+	m_bottom.pop_back();
+	m_size--;
+	return ev;
+}
+
+void RdmaLadderScheduler::Remove(const Event& ev)
+{
+	const uint64_t ts = ev.key.m_ts;
+	m_size--;
+
+	if (ts >= m_topStart) {
+		// The bounds of the top list stay valid, only wider
+		EraseFrom(m_top, ev);
+		return;
+	}
+
+	for (uint32_t i = 0; i < m_nRungs; i++) {
+		Rung& r = m_rungs[i];
+		if (ts >= r.CurStart()) {
+			EraseFrom(r.m_buckets[(ts - r.start) / r.width], ev);
+			r.count--;
+			return;
+		}
+	}
+
+	auto it = std::lower_bound(m_bottom.begin(), m_bottom.end(), ev, After);
+	NS_ASSERT(it != m_bottom.end() && it->key == ev.key);
+	m_bottom.erase(it);
+}
+
+void RdmaLadderScheduler::EraseFrom(Bucket& bucket, const Event& ev)
+{
+	auto it = std::find_if(bucket.begin(), bucket.end(), [&](const Event& e) { return e.key == ev.key; });
+	NS_ASSERT(it != bucket.end());
+	*it = bucket.back();
+	bucket.pop_back();
+}
+
+void RdmaLadderScheduler::InsertBottom(const Event& ev)
+{
+	m_bottom.insert(std::upper_bound(m_bottom.begin(), m_bottom.end(), ev, After), ev);
+
+	// The events keep coming below the finest rung: spread them into a new rung
+	if (m_bottom.size() > threshold && m_nRungs < maxRungs && m_bottom.front().key.m_ts != m_bottom.back().key.m_ts) {
+		const uint64_t end = m_nRungs > 0 ? m_rungs[m_nRungs - 1].CurStart() : m_topStart;
+		SpawnRung(m_bottom, m_bottom.back().key.m_ts, end);
+		m_bottom.clear();
+	}
+}
+
+void RdmaLadderScheduler::SpawnRung(Bucket& events, uint64_t start, uint64_t end)
+{
+	NS_ASSERT(m_nRungs < maxRungs && !events.empty() && end > start);
+
+	// About one event per bucket
+	const uint64_t n = events.size();
+	const uint64_t width = std::max<uint64_t>((end - start + n - 1) / n, 1);
+
+	Rung& r = m_rungs[m_nRungs++];
+	r.start = start;
+	r.width = width;
+	r.buckets = (end - start + width - 1) / width;
+	r.cur = 0;
+	r.count = n;
+	if (r.m_buckets.size() < r.buckets) {
+		r.m_buckets.resize(r.buckets);
+	}
+	for (const Event& ev : events) {
+		NS_ASSERT(ev.key.m_ts >= start && ev.key.m_ts < end);
+		r.m_buckets[(ev.key.m_ts - start) / width].push_back(ev);
+	}
+}
+
+void RdmaLadderScheduler::FillBottom()
+{
+	while (m_bottom.empty()) {
+		if (m_nRungs == 0) {
+			NS_ASSERT(!m_top.empty());
+			// The top list becomes the first rung
+			const uint64_t end = m_topMax + 1;
+			SpawnRung(m_top, m_topMin, end);
+			m_top.clear();
+			m_topStart = m_rungs[0].start + uint64_t{m_rungs[0].buckets} * m_rungs[0].width;
+			continue;
+		}
+
+		Rung& r = m_rungs[m_nRungs - 1];
+		if (r.count == 0) {
+			m_nRungs--;
+			continue;
+		}
+		while (r.m_buckets[r.cur].empty()) {
+			r.cur++;
+		}
+
+		Bucket& b = r.m_buckets[r.cur];
+		const uint64_t start = r.CurStart();
+		r.count -= b.size();
+		r.cur++;
+
+		if (b.size() > threshold && r.width > 1 && m_nRungs < maxRungs) {
+			SpawnRung(b, start, start + r.width);
+			b.clear();
+		}
+		else {
+			m_bottom.swap(b);
+			std::sort(m_bottom.begin(), m_bottom.end(), After);
+		}
+	}
+}
+
+} // namespace ns3
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <ns3/scheduler.h>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * @brief Ladder queue (Tang, Goh and Thng, 2005), for the event streams of the RDMA fabric.
+ *
+ * Most of the events of the fabric (serialization, propagation, transmit triggers, timers) are scheduled
+ * within a few microseconds of now, in dense clusters. The `MapScheduler` pays a tree node allocation
+ * and a logarithmic insertion per event, and the `CalendarScheduler` resizes its fixed-width buckets
+ * with the population.
+ *
+ * The ladder keeps the far events unsorted in the top list. When the near events are exhausted, the top
+ * list is spread into the buckets of a rung, and a bucket too populated is spread into a finer rung
+ * instead of being sorted. Only the current bucket is sorted, into the bottom list, so the insertions
+ * and removals are amortized constant time.
+ *
+ * The events are stored by value in vectors whose capacity is kept when emptied: the buckets of the
+ * rungs and the lists are a pool, and the scheduler does not allocate once warmed up.
+ *
+ * Selected by `RdmaConfig::scheduler`.
+ */
+class RdmaLadderScheduler : public Scheduler
+{
+public:
+	static TypeId GetTypeId();
+
+	RdmaLadderScheduler();
+	~RdmaLadderScheduler() override;
+
+	void Insert(const Event& ev) override;
+	bool IsEmpty() const override;
+	Event PeekNext() const override;
+	Event RemoveNext() override;
+	void Remove(const Event& ev) override;
+
+private:
+	/// @brief Events above which a bucket is spread into a finer rung, and the bottom list into a rung.
+	static constexpr size_t threshold = 50;
+	static constexpr uint32_t maxRungs = 8;
+
+	using Bucket = std::vector<Event>;
+
+	struct Rung
+	{
+		uint64_t start{0}; //!< Time stamp of the first bucket.
+		uint64_t width{1}; //!< Time stamps per bucket.
+		uint32_t buckets{0}; //!< Buckets in use, `m_buckets` may have more.
+		uint32_t cur{0}; //!< First bucket not yet moved to the bottom list.
+		size_t count{0}; //!< Events in the rung.
+		std::vector<Bucket> m_buckets;
+
+		uint64_t CurStart() const { return start + uint64_t{cur} * width; }
+	};
+
+	/**
+	 * @brief Spread the events into a new rung, the finest one.
+	 * @param end The events to insert later in the rung are below `end`.
+	 */
+	void SpawnRung(Bucket& events, uint64_t start, uint64_t end);
+
+	/**
+	 * @brief Move the next bucket to the bottom list, if empty.
+	 */
+	void FillBottom();
+
+	void InsertBottom(const Event& ev);
+	static void EraseFrom(Bucket& bucket, const Event& ev);
+
+	Bucket m_top; //!< Unsorted, time stamps from `m_topStart`.
+	uint64_t m_topStart{0};
+	uint64_t m_topMin{0};
+	uint64_t m_topMax{0};
+
+	std::array<Rung, maxRungs> m_rungs; //!< The coarsest first.
+	uint32_t m_nRungs{0};
+
+	Bucket m_bottom; //!< Sorted, the next event last.
+	size_t m_size{0};
+};
+
+} // namespace ns3
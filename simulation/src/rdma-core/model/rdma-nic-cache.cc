@@ -0,0 +1,84 @@
+#include <ns3/rdma-nic-cache.h>
+#include <ns3/rdma-queue-pair.h>
+#include <ns3/simulator.h>
+#include <algorithm>
+
+namespace ns3 {
+
+void RdmaNicCache::Configure(uint32_t entries, uint32_t ways, Time missLatency)
+{
+	m_lines.clear();
+	m_stats = Stats{};
+	if (entries == 0) {
+		m_sets = 0;
+		m_ways = 0;
+		return;
+	}
+
+	m_ways = std::clamp<uint32_t>(ways, 1, entries);
+	m_sets = entries / m_ways;
+	m_lines.resize(size_t{m_sets} * m_ways);
+	m_missLatency = missLatency;
+}
+
+Time RdmaNicCache::Access(uint64_t key)
+{
+	const Time now = Simulator::Now();
+
+	// Mix the bits, so that consecutive keys and keys differing only in the upper bits spread over the sets
+	const uint64_t h = (key ^ (key >> 29)) * 0x9E3779B97F4A7C15ull;
+	Line* set = &m_lines[size_t{(h >> 32) % m_sets} * m_ways];
+	Line* victim = set;
+	m_clock++;
+
+	for (uint32_t i = 0; i < m_ways; i++) {
+		Line& line = set[i];
+		if (line.valid && line.key == key) {
+			m_stats.hits++;
+			line.lastUse = m_clock;
+			return Max(line.ready, now);
+		}
+		if (!line.valid || (victim->valid && line.lastUse < victim->lastUse)) {
+			victim = &line;
+		}
+	}
+
+	m_stats.misses++;
+	victim->valid = true;
+	victim->key = key;
+	victim->lastUse = m_clock;
+	victim->ready = now + m_missLatency;
+	return victim->ready;
+}
+
+Time RdmaNicCaches::AccessMtt(uint32_t qpn, uint64_t psn)
+{
+	if (!mtt.IsEnabled()) {
+		return Simulator::Now();
+	}
+	const uint64_t page = psn / mttPageSize;
+	return mtt.Access((uint64_t{qpn} << 32) | (page & 0xFFFFFFFF));
+}
+
+Time RdmaNicCaches::AccessTx(Ptr<RdmaTxQueuePair> qp)
+{
+	Time ready = Simulator::Now();
+	if (qpc.IsEnabled()) {
+		ready = qpc.Access(qp->GetQpn());
+	}
+	return Max(ready, AccessMtt(qp->GetQpn(), qp->GetNextPsn()));
+}
+
+Time RdmaNicCaches::AccessRx(uint32_t qpn, const CustomHeader& ch)
+{
+	Time ready = Simulator::Now();
+	if (qpc.IsEnabled()) {
+		ready = qpc.Access(qpn);
+	}
+	if (ch.l3Prot == 0x11) { // Data is written to the memory of the QP
+		ready = Max(ready, AccessMtt(qpn, ch.udp.seq));
+	}
+	return ready;
+}
+
+} // namespace ns3
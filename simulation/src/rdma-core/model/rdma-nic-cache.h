@@ -0,0 +1,90 @@
+#pragma once
+
+#include <ns3/nstime.h>
+#include <ns3/ptr.h>
+#include <ns3/custom-header.h>
+#include <cstdint>
+#include <vector>
+
+namespace ns3 {
+
+class RdmaTxQueuePair;
+
+/**
+ * @brief Set-associative cache of the NIC, in front of the host memory.
+ *
+ * The replacement is LRU in each set.
+ * A miss allocates the line right away, but the line is only usable once fetched from the host
+ * memory (over PCIe), after the miss latency. The accesses in the meantime wait for the same fetch.
+ */
+class RdmaNicCache
+{
+public:
+	struct Stats
+	{
+		uint64_t hits{};
+		uint64_t misses{};
+	};
+
+	/**
+	 * @param entries Capacity of the cache. Zero to disable the cache (everything hits).
+	 * @param ways Associativity, clamped to `entries`.
+	 */
+	void Configure(uint32_t entries, uint32_t ways, Time missLatency);
+
+	bool IsEnabled() const { return !m_lines.empty(); }
+
+	/**
+	 * @return When the entry is usable: now on a hit, later on a miss or if the entry is still fetched.
+	 */
+	Time Access(uint64_t key);
+
+	const Stats& GetStats() const { return m_stats; }
+
+private:
+	struct Line
+	{
+		bool valid{false};
+		uint64_t key{0};
+		uint64_t lastUse{0};
+		Time ready{};
+	};
+
+	std::vector<Line> m_lines; //!< Sets of `m_ways` contiguous lines.
+	uint32_t m_sets{0};
+	uint32_t m_ways{0};
+	Time m_missLatency{};
+	uint64_t m_clock{0}; //!< Incremented on each access, for LRU.
+	Stats m_stats{};
+};
+
+/**
+ * @brief Caches of the NIC for the QP contexts (QPC) and the memory translation table (MTT).
+ *
+ * Each packet sent or received needs the context of its QP.
+ * Each data packet also needs the translation of the memory page it reads or writes.
+ * The buffer of each QP is contiguous, so the page is given by the PSN.
+ */
+struct RdmaNicCaches
+{
+	RdmaNicCache qpc;
+	RdmaNicCache mtt;
+	uint32_t mttPageSize{4096};
+
+	bool IsEnabled() const { return qpc.IsEnabled() || mtt.IsEnabled(); }
+
+	/**
+	 * @return When the next packet of the SQ can be sent.
+	 */
+	Time AccessTx(Ptr<RdmaTxQueuePair> qp);
+
+	/**
+	 * @return When the packet received by the QP can be processed.
+	 */
+	Time AccessRx(uint32_t qpn, const CustomHeader& ch);
+
+private:
+	Time AccessMtt(uint32_t qpn, uint64_t psn);
+};
+
+} // namespace ns3
@@ -0,0 +1,195 @@
+#include <ns3/rdma-packet-template.h>
+#include <ns3/rdma-seq-header.h>
+#include <ns3/ipv4-header.h>
+#include <ns3/udp-header.h>
+#include <ns3/ppp-header.h>
+#include <ns3/buffer.h>
+#include <ns3/int-header.h>
+#include <ns3/simulator.h>
+#include <ns3/assert.h>
+#include <algorithm>
+#include <initializer_list>
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED(RdmaTemplateHeader);
+
+namespace {
+
+/**
+ * @brief Serialize headers into bytes, the first header of the list being the outermost.
+ */
+std::vector<uint8_t> SerializeHeaders(std::initializer_list<const Header*> headers)
+{
+	uint32_t size = 0;
+	for (const Header* h : headers) {
+		size += h->GetSerializedSize();
+	}
+
+	Buffer buf;
+	buf.AddAtStart(size);
+	Buffer::Iterator it = buf.Begin();
+	for (const Header* h : headers) {
+		h->Serialize(it);
+		it.Next(h->GetSerializedSize());
+	}
+
+	std::vector<uint8_t> bytes(size);
+	buf.CopyData(bytes.data(), size);
+	return bytes;
+}
+
+} // namespace
+
+void RdmaPacketTemplate::InitData(Ipv4Address sip, uint16_t sport, uint16_t pg)
+{
+	RdmaSeqHeader seqTs;
+	seqTs.SetPG(pg);
+
+	UdpHeader udpHeader;
+	udpHeader.SetSourcePort(sport);
+
+	Ipv4Header ipHeader;
+	ipHeader.SetSource(sip);
+	ipHeader.SetProtocol(0x11);
+	ipHeader.SetTtl(64);
+	ipHeader.SetTos(0);
+
+	PppHeader ppp;
+	ppp.SetProtocol(0x0021); // EtherToPpp(0x800), see point-to-point-net-device.cc
+
+	m_bytes = SerializeHeaders({&ppp, &ipHeader, &udpHeader, &seqTs});
+	NS_ASSERT(m_bytes.size() == SEQ + RdmaSeqHeader::GetHeaderSize());
+}
+
+void RdmaPacketTemplate::InitAck(Ipv4Address sip, Ipv4Address dip)
+{
+	Ipv4Header head;
+	head.SetSource(sip);
+	head.SetDestination(dip);
+	head.SetTtl(64);
+
+	PppHeader ppp;
+	ppp.SetProtocol(0x0021); // EtherToPpp(0x800), see point-to-point-net-device.cc
+
+	m_bytes = SerializeHeaders({&ppp, &head});
+}
+
+Ptr<Packet> RdmaPacketTemplate::MakeData(Ipv4Address dip, uint16_t dport, uint32_t psn, uint16_t ipid, uint32_t payload_size) const
+{
+	NS_ASSERT(IsInit());
+
+	RdmaTemplateHeader h;
+	h.m_tmpl = this;
+	h.m_size = m_bytes.size();
+	h.m_ipTotalLength = m_bytes.size() - IP + payload_size;
+	h.m_ipid = ipid;
+	h.m_l3Prot = 0x11;
+	h.m_dip = dip.Get();
+	h.m_dport = dport;
+	h.m_udpLength = m_bytes.size() - UDP + payload_size;
+	h.m_seq = psn;
+
+	Ptr<Packet> p = Create<Packet>(payload_size);
+	p->AddHeader(h);
+	return p;
+}
+
+Ptr<Packet> RdmaPacketTemplate::MakeAck(uint8_t l3Prot, uint16_t ipid, const qbbHeader& seqh) const
+{
+	NS_ASSERT(IsInit());
+
+	// Padded to the minimum Ethernet frame
+	const uint32_t padding = std::max(60 - 14 - 20 - (int)seqh.GetSerializedSize(), 0);
+
+	RdmaTemplateHeader h;
+	h.m_tmpl = this;
+	h.m_ack = &seqh;
+	h.m_size = m_bytes.size() + seqh.GetSerializedSize();
+	h.m_ipTotalLength = h.m_size - IP + padding;
+	h.m_ipid = ipid;
+	h.m_l3Prot = l3Prot;
+
+	Ptr<Packet> p = Create<Packet>(padding);
+	p->AddHeader(h);
+	return p;
+}
+
+TypeId RdmaTemplateHeader::GetTypeId()
+{
+	static TypeId tid = TypeId("ns3::RdmaTemplateHeader")
+		.SetParent<Header>()
+		.AddConstructor<RdmaTemplateHeader>()
+		;
+	return tid;
+}
+
+TypeId RdmaTemplateHeader::GetInstanceTypeId() const
+{
+	return GetTypeId();
+}
+
+void RdmaTemplateHeader::Print(std::ostream& os) const
+{
+	if (!m_parsed) {
+		return;
+	}
+	const CustomHeader& ch = *m_parsed;
+	os << "RDMA l3Prot=" << uint32_t(ch.l3Prot)
+	   << " " << Ipv4Address(ch.sip) << " > " << Ipv4Address(ch.dip)
+	   << " seq=" << (ch.l3Prot == 0x11 ? ch.udp.seq : ch.ack.seq);
+}
+
+uint32_t RdmaTemplateHeader::GetSerializedSize() const
+{
+	return m_size;
+}
+
+void RdmaTemplateHeader::Serialize(Buffer::Iterator start) const
+{
+	NS_ASSERT(m_tmpl);
+	const std::vector<uint8_t>& bytes = m_tmpl->m_bytes;
+
+	Buffer::Iterator i = start;
+	i.Write(bytes.data(), bytes.size());
+	if (m_ack) {
+		m_ack->Serialize(i);
+	}
+
+	// IPv4: total length, identification, then the protocol or the destination
+	i = start;
+	i.Next(RdmaPacketTemplate::IP + 2);
+	i.WriteHtonU16(m_ipTotalLength);
+	i.WriteHtonU16(m_ipid);
+	if (m_l3Prot != 0x11) {
+		i.Next(3);
+		i.WriteU8(m_l3Prot);
+		return;
+	}
+	i.Next(10);
+	i.WriteHtonU32(m_dip);
+
+	// UDP: destination port, length
+	i.Next(2);
+	i.WriteHtonU16(m_dport);
+	i.WriteHtonU16(m_udpLength);
+
+	// RdmaSeqHeader: PSN, and the send time for TIMELY and Swift (see `RdmaSeqHeader::RdmaSeqHeader()`)
+	i.Next(2);
+	i.WriteHtonU32(m_seq);
+	if (IntHeader::mode == IntHeader::TS) {
+		i.Next(2);
+		i.WriteU64(Simulator::Now().GetTimeStep());
+	}
+}
+
+uint32_t RdmaTemplateHeader::Deserialize(Buffer::Iterator start)
+{
+	m_tmpl = nullptr;
+	m_ack = nullptr;
+	m_parsed = std::make_shared<CustomHeader>(CustomHeader::L2_Header | CustomHeader::L3_Header | CustomHeader::L4_Header);
+	m_size = m_parsed->Deserialize(start);
+	return m_size;
+}
+
+} // namespace ns3
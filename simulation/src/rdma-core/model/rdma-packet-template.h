@@ -0,0 +1,93 @@
+#pragma once
+
+#include <ns3/header.h>
+#include <ns3/packet.h>
+#include <ns3/ipv4-address.h>
+#include <ns3/qbb-header.h>
+#include <ns3/custom-header.h>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * @brief Headers of the packets generated by a QP, serialized once.
+ *
+ * Most of the headers of a QP are constant. A packet is stamped with a single copy of the template,
+ * and only the fields changing per packet are patched: the lengths, the IP identification, the PSN,
+ * and the send time if `IntHeader::mode` is `IntHeader::TS`.
+ * The payload stays a zero-filled area of the packet, so it is never allocated.
+ *
+ * The headers are the same as when added one by one, except the IP checksum which is not computed,
+ * like when `ns3::Node::ChecksumEnabled` is false.
+ */
+class RdmaPacketTemplate
+{
+public:
+	/**
+	 * @brief Prepare the data packets: PPP, IPv4, UDP and `RdmaSeqHeader`.
+	 * The destination is patched per packet, for the UD QPs.
+	 */
+	void InitData(Ipv4Address sip, uint16_t sport, uint16_t pg);
+
+	/**
+	 * @brief Prepare the ACKs and NACKs: PPP and IPv4, followed by a `qbbHeader`.
+	 */
+	void InitAck(Ipv4Address sip, Ipv4Address dip);
+
+	bool IsInit() const { return !m_bytes.empty(); }
+
+	Ptr<Packet> MakeData(Ipv4Address dip, uint16_t dport, uint32_t psn, uint16_t ipid, uint32_t payload_size) const;
+
+	/**
+	 * @param l3Prot 0xFC for an ACK, 0xFD for a NACK.
+	 */
+	Ptr<Packet> MakeAck(uint8_t l3Prot, uint16_t ipid, const qbbHeader& seqh) const;
+
+	/// @brief Offsets of the headers from the start of the PPP header.
+	enum Offset : uint32_t {
+		IP = 2,
+		UDP = IP + 20,
+		SEQ = UDP + 8
+	};
+
+private:
+	friend class RdmaTemplateHeader;
+
+	std::vector<uint8_t> m_bytes;
+};
+
+/**
+ * @brief Header written from a `RdmaPacketTemplate`, so a packet is built with a single `AddHeader()`.
+ *
+ * When deserialized, for example to print the packet, the bytes are parsed by a `CustomHeader`.
+ */
+class RdmaTemplateHeader : public Header
+{
+public:
+	static TypeId GetTypeId();
+	TypeId GetInstanceTypeId() const override;
+	void Print(std::ostream& os) const override;
+	uint32_t GetSerializedSize() const override;
+	void Serialize(Buffer::Iterator start) const override;
+	uint32_t Deserialize(Buffer::Iterator start) override;
+
+private:
+	friend class RdmaPacketTemplate;
+
+	const RdmaPacketTemplate* m_tmpl{nullptr};
+	const qbbHeader* m_ack{nullptr}; //!< Appended after the template for the ACKs.
+	uint32_t m_size{0};
+	uint16_t m_ipTotalLength{0};
+	uint16_t m_ipid{0};
+	uint8_t m_l3Prot{0};
+	uint32_t m_dip{0};
+	uint16_t m_dport{0};
+	uint16_t m_udpLength{0};
+	uint32_t m_seq{0};
+
+	std::shared_ptr<CustomHeader> m_parsed; //!< Set by `Deserialize()`.
+};
+
+} // namespace ns3
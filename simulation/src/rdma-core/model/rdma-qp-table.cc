@@ -0,0 +1,46 @@
+#include <ns3/rdma-qp-table.h>
+#include <ns3/abort.h>
+
+namespace ns3 {
+
+RdmaQpTable::RdmaQpTable()
+	: m_entries(firstIndex)
+{
+}
+
+uint32_t RdmaQpTable::Add(Ptr<RdmaTxQueuePair> sq, Ptr<RdmaRxQueuePair> rq)
+{
+	uint32_t index;
+	if (!m_free.empty()) {
+		index = m_free.back();
+		m_free.pop_back();
+		// Next generation, the index is unchanged
+		m_entries[index].qpn += 1u << indexBits;
+	}
+	else {
+		index = m_entries.size();
+		NS_ABORT_MSG_IF(index > indexMask, "Too many QPs on the NIC");
+		m_entries.emplace_back();
+		m_entries[index].qpn = index;
+	}
+
+	Entry& e = m_entries[index];
+	e.sq = sq;
+	e.rq = rq;
+	return e.qpn;
+}
+
+void RdmaQpTable::Remove(uint32_t qpn)
+{
+	if (!Find(qpn)) {
+		return;
+	}
+
+	const uint32_t index = qpn & indexMask;
+	Entry& e = m_entries[index];
+	e.sq = nullptr;
+	e.rq = nullptr;
+	m_free.push_back(index);
+}
+
+} // namespace ns3
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <ns3/rdma-queue-pair.h>
+#include <cstdint>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * @brief Queue pairs of a NIC, indexed by QP number (QPN).
+ *
+ * The lower 24 bits of a QPN are the index of the QP context in a dense table,
+ * so finding the QP of a packet is O(1).
+ * The contexts of the destroyed QPs are reused from a free list.
+ * A reused context gets the next generation in the upper 8 bits of the QPN,
+ * so the late packets of a destroyed QP are not delivered to the new one.
+ *
+ * Like in InfiniBand, QPN 0 and 1 are reserved and never allocated.
+ * Here, QPN 0 means that the destination QP is not known by the sender (see `RdmaBTH::GetDestQpn()`).
+ */
+class RdmaQpTable
+{
+public:
+	static constexpr uint32_t indexBits = 24;
+	static constexpr uint32_t indexMask = (1u << indexBits) - 1;
+	static constexpr uint32_t firstIndex = 2;
+
+	struct Entry
+	{
+		uint32_t qpn{0}; //!< QPN of the QP, or of the last QP if the context is free.
+		Ptr<RdmaTxQueuePair> sq;
+		Ptr<RdmaRxQueuePair> rq;
+	};
+
+	RdmaQpTable();
+
+	/**
+	 * @return The QPN of the new QP.
+	 */
+	uint32_t Add(Ptr<RdmaTxQueuePair> sq, Ptr<RdmaRxQueuePair> rq);
+
+	/**
+	 * @brief Free the context of a QP. Does nothing if the QP is already removed.
+	 */
+	void Remove(uint32_t qpn);
+
+	/**
+	 * @return The QP, or nullptr if there is no QP with this QPN (anymore).
+	 */
+	const Entry* Find(uint32_t qpn) const
+	{
+		const uint32_t index = qpn & indexMask;
+		if (index >= m_entries.size()) {
+			return nullptr;
+		}
+		const Entry& e = m_entries[index];
+		return (e.qpn == qpn && e.sq) ? &e : nullptr;
+	}
+
+	/**
+	 * @return The count of QPs.
+	 */
+	size_t GetN() const { return m_entries.size() - firstIndex - m_free.size(); }
+
+	/**
+	 * @brief Call `f(const Entry&)` on each QP, in the order of their index.
+	 */
+	template<typename F>
+	void ForEach(F&& f) const
+	{
+		for (size_t i = firstIndex; i < m_entries.size(); i++) {
+			if (m_entries[i].sq) {
+				f(m_entries[i]);
+			}
+		}
+	}
+
+private:
+	std::vector<Entry> m_entries;
+	std::vector<uint32_t> m_free; //!< Indices of the free contexts.
+};
+
+} // namespace ns3
@@ -9,6 +9,7 @@
 #include <ns3/rdma-queue-pair.h>
 #include <ns3/rdma-hw.h>
 #include <ns3/rdma-bth.h>
+#include <ns3/rdma-helper.h>
 #include <ns3/log.h>
 
 namespace ns3 {
@@ -35,36 +36,6 @@ RdmaTxQueuePair::RdmaTxQueuePair(Ptr<Node> node, uint16_t pg, Ipv4Address sip, u
 	m_max_rate = 0;
 	m_rate = 0;
 	m_nextAvail = Simulator::Now();
-	mlx.m_alpha = 1;
-	mlx.m_alpha_cnp_arrived = false;
-	mlx.m_first_cnp = true;
-	mlx.m_decrease_cnp_arrived = false;
-	mlx.m_rpTimeStage = 0;
-	hp.m_lastUpdateSeq = 0;
-	for (uint32_t i = 0; i < sizeof(hp.keep) / sizeof(hp.keep[0]); i++)
-		hp.keep[i] = 0;
-	hp.m_incStage = 0;
-	hp.m_lastGap = 0;
-	hp.u = 1;
-	for (uint32_t i = 0; i < IntHeader::maxHop; i++){
-		hp.hopState[i].u = 1;
-		hp.hopState[i].incStage = 0;
-	}
-
-	tmly.m_lastUpdateSeq = 0;
-	tmly.m_incStage = 0;
-	tmly.lastRtt = 0;
-	tmly.rttDiff = 0;
-
-	dctcp.m_lastUpdateSeq = 0;
-	dctcp.m_caState = 0;
-	dctcp.m_highSeq = 0;
-	dctcp.m_alpha = 1;
-	dctcp.m_ecnCnt = 0;
-	dctcp.m_batchSizeOfAlpha = 0;
-
-	hpccPint.m_lastUpdateSeq = 0;
-	hpccPint.m_incStage = 0;
 }
 
 RdmaTxQueuePair::~RdmaTxQueuePair()
@@ -76,7 +47,10 @@ void RdmaTxQueuePair::SetMaxRate(DataRate max_rate)
 {
 	m_max_rate = max_rate.GetBitRate();
 	m_rate = m_max_rate;
-	mlx.m_targetRate = m_max_rate;
+
+	// Keep the same algorithm
+	StopTimers();
+	m_cc = MakeRdmaCcState(GetCcMode(), m_max_rate);
 }
 
 DataRate RdmaTxQueuePair::GetMaxRate() const
@@ -84,41 +58,91 @@ DataRate RdmaTxQueuePair::GetMaxRate() const
 	return m_max_rate;
 }
 
+uint32_t RdmaTxQueuePair::GetCcMode() const
+{
+	return std::visit([](const auto& cc) -> uint32_t { return cc.mode; }, m_cc);
+}
+
+void RdmaTxQueuePair::PostSend(SendRequest sr)
+{
+	PostSendBatch(std::span<SendRequest>(&sr, 1));
+}
+
+void RdmaTxQueuePair::PostSendBatch(std::span<SendRequest> srs, OnSendCallback on_send)
+{
+	NS_LOG_FUNCTION(this << srs.size());
+	NS_ASSERT_MSG(!srs.empty(), "Empty batch of send requests");
+
+	// In a distributed simulation, all the processes create the QPs, so that they have the same QPNs,
+	// but only the process of the node sends, and calls `on_send`
+	if(!IsLocalNode(m_node)) {
+		return;
+	}
+
+	if(on_send) {
+		OnSendCallback& last = srs.back().on_send;
+		if(!last) {
+			last = std::move(on_send);
+		}
+		else {
+			last = [first = std::move(last), then = std::move(on_send)]() {
+				first();
+				then();
+			};
+		}
+	}
+
+	for(SendRequest& sr : srs) {
+		PushSendRequest(std::move(sr));
+	}
+
+	GetDevice()->NotifyPostSend(srs.size());
+	TriggerDevTransmit();
+}
+
 void RdmaTxQueuePair::TriggerDevTransmit()
 {
 	NS_LOG_FUNCTION(this);
 	NS_LOG_LOGIC("Try to send at " << m_nextAvail.GetSeconds());
 
-	// Trigger to possibly send
-	if(m_nextAvail <= Simulator::Now()) {
-		Simulator::Schedule(Seconds(0), &QbbNetDevice::TriggerTransmit, GetDevice());
-	}
-	else {
-		Simulator::Schedule(m_nextAvail - Simulator::Now(), &QbbNetDevice::TriggerTransmit, GetDevice());
-	}
+	Ptr<QbbNetDevice> dev = GetDevice();
+	dev->GetRdmaQueue()->UpdateQp(this);
+
+	// Trigger to possibly send, coalesced with the transmit event of the device
+	dev->TriggerTransmit(Max(m_nextAvail, Simulator::Now()));
 }
 
 void RdmaTxQueuePair::StopTimers()
 {
-	Simulator::Cancel(mlx.m_eventUpdateAlpha);
-	Simulator::Cancel(mlx.m_eventDecreaseRate);
-	Simulator::Cancel(mlx.m_rpTimer);
+	if (DcqcnCc* mlx = std::get_if<DcqcnCc>(&m_cc)){
+		mlx->m_eventUpdateAlpha.Cancel();
+		mlx->m_eventDecreaseRate.Cancel();
+		mlx->m_rpTimer.Cancel();
+	}
 }
 
 Ptr<QbbNetDevice> RdmaTxQueuePair::GetDevice()
 {
 	// Assume each server has only one NIC
-	NS_ASSERT(m_node->GetNDevices() == 2);
-	return DynamicCast<QbbNetDevice>(m_node->GetDevice(1));	
+	if (!m_dev) {
+		NS_ASSERT(m_node->GetNDevices() == 2);
+		m_dev = PeekPointer(DynamicCast<QbbNetDevice>(m_node->GetDevice(1)));
+	}
+	return m_dev;
+}
+
+const RdmaPacketTemplate& RdmaTxQueuePair::GetPacketTemplate()
+{
+	if (!m_pktTemplate.IsInit()) {
+		m_pktTemplate.InitData(m_sip, m_sport, m_pg);
+	}
+	return m_pktTemplate;
 }
 
 void RdmaTxQueuePair::LazyInitCnp()
 {
 	// Assume each server has only one NIC
 	Ptr<QbbNetDevice> dev = GetDevice();
-	Ptr<RdmaHw> rdma = m_node->GetObject<RdmaHw>();
-	const uint32_t cc = rdma->GetCC();
-	NS_ASSERT(cc == 1);
 	NS_ASSERT(m_rate > 0);
 
 	#if 0
@@ -196,11 +220,9 @@ void RdmaRxQueuePair::ReceiveCnp(Ptr<Packet> p, const CustomHeader &ch)
 	uint32_t i;
 #endif
 
-	Ptr<RdmaHw> rdma{m_tx->GetNode()->GetObject<RdmaHw>()};
-	const uint32_t cc{rdma->GetCC()};
-	NS_ASSERT(cc == 1);
+	RdmaHw* rdma{m_tx->GetRdmaHw()};
 	m_tx->LazyInitCnp();
-	rdma->cnp_received_mlx(m_tx);
+	rdma->ReceiveCnp(m_tx);
 }
 
 /*********************
@@ -242,6 +264,8 @@ RdmaTxQueuePairGroup::RdmaTxQueuePairGroup(Ptr<QbbNetDevice> dev)
 
 void RdmaTxQueuePairGroup::AddQp(Ptr<RdmaTxQueuePair> qp)
 {
+	qp->m_sched.index = m_qps.size();
+	qp->m_sched.order = m_nextOrder++;
 	m_qps.push_back(qp);
 }
 
@@ -260,6 +284,7 @@ void RdmaTxQueuePairGroup::RemoveFinished(int begin, int end, int& res)
 				res = nxt;
 			}
 			m_qps[nxt] = m_qps[i];
+			m_qps[nxt]->m_sched.index = nxt;
 			nxt++;
 		}
 	}
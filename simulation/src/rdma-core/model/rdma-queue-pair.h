@@ -8,12 +8,16 @@
 #include <ns3/event-id.h>
 #include <ns3/custom-header.h>
 #include <ns3/int-header.h>
+#include <ns3/rdma-cc.h>
+#include <ns3/rdma-packet-template.h>
 #include <functional>
+#include <span>
 #include <vector>
 
 namespace ns3 {
 
 class QbbNetDevice;
+class RdmaHw;
 
 /**
  * \brief Common base to UD and RC SQs.
@@ -42,14 +46,23 @@ public:
 	
 	/**
 	 * @brief Equivalent of `ibv_send_wr()`.
+	 * 
+	 * Move-only, so the completion callback is never copied once posted.
 	 */
 	struct SendRequest
 	{
+		SendRequest() = default;
+		SendRequest(SendRequest&&) = default;
+		SendRequest& operator=(SendRequest&&) = default;
+		SendRequest(const SendRequest&) = delete;
+		SendRequest& operator=(const SendRequest&) = delete;
+
 		uint32_t payload_size{}; //!< How much bytes to write.
 		uint32_t imm{}; //!< Immediate data.
 		bool multicast{}; //!< Is `dip` a multicast group?
 		Ipv4Address dip{}; //!< Note: Only for UD SQ.
 		uint16_t dport{};  //!< Note: Only for UD SQ.
+		uint32_t dqpn{};   //!< Destination QPN, or zero to address the QP bound to `dport`. Note: Only for UD SQ.
 		OnSendCallback on_send{}; //!< For UD QP: called when the packet leaves the NIC; For RC QP: called when ACKed.
 	
 		// Private
@@ -58,10 +71,19 @@ public:
 		uint64_t GetEndPSN() const { return first_psn + payload_size; }
 	};
 
-	virtual void PostSend(SendRequest sr)
-	{
-		NS_ABORT_MSG("Not implemented");
-	}
+	/**
+	 * @brief Post a single send request.
+	 */
+	void PostSend(SendRequest sr);
+
+	/**
+	 * @brief Post a chain of send requests, like `ibv_post_send()` with linked WRs.
+	 * 
+	 * The requests are moved into the SQ, and the NIC is triggered once for the whole batch.
+	 * 
+	 * @param on_send Called once, after the `on_send` of the last request of the batch.
+	 */
+	void PostSendBatch(std::span<SendRequest> srs, OnSendCallback on_send = {});
 
 	/**
 	 * \returns true When this SQ is ready to send and a next packet is available.
@@ -81,11 +103,27 @@ public:
 
 	virtual bool HasDataToSend() const = 0;
 
+	/**
+	 * \returns true When the SQ cannot send because of its window of on-the-fly packets.
+	 */
+	virtual bool IsWinBound() const
+	{
+		return false;
+	}
+
 	virtual Ptr<Packet> GetNextPacket()
 	{
 		return nullptr;
 	}
 
+	/**
+	 * @returns The PSN of the next packet to send.
+	 */
+	virtual uint64_t GetNextPsn() const
+	{
+		return 0;
+	}
+
 	/**
 	 * @returns The time when the next packet will be ready to send.
 	 */
@@ -111,10 +149,15 @@ public:
 	
 	void LazyInitCnp();
 
-	uint64_t GetKey()
-	{
-		return m_sport;
-	}
+	/**
+	 * @return The QP number, allocated by `RdmaHw::RegisterQP()`.
+	 */
+	uint32_t GetQpn() const { return m_qpn; }
+
+	/**
+	 * @return The `RdmaHw` of the node, set by `RdmaHw::RegisterQP()`.
+	 */
+	RdmaHw* GetRdmaHw() const { return m_rdmaHw; }
 
 	void Finish()
 	{
@@ -123,71 +166,71 @@ public:
 
 	void StopTimers();
 
+	/**
+	 * @brief Set the line rate of the SQ, and restart its congestion control from this rate.
+	 */
 	void SetMaxRate(DataRate data_rate);
 	DataRate GetMaxRate() const;
 
+	/**
+	 * @return The congestion control algorithm of the SQ, one of `RdmaCcMode`.
+	 */
+	uint32_t GetCcMode() const;
+
 protected:
+	/**
+	 * @brief Store a posted send request. The NIC is triggered by the caller.
+	 */
+	virtual void PushSendRequest(SendRequest&& sr) = 0;
+
+	/**
+	 * @return The headers of the data packets of the SQ, prepared on the first packet.
+	 */
+	const RdmaPacketTemplate& GetPacketTemplate();
+
 	Ptr<Node> m_node{};
+	QbbNetDevice* m_dev{nullptr}; //!< Cached by `GetDevice()`, owned by the node.
+	RdmaHw* m_rdmaHw{nullptr};
 	uint32_t m_mtu{0};
 	Ipv4Address m_sip{};
 	uint16_t m_sport{0};
 	uint16_t m_pg{0};
+	uint32_t m_qpn{0};
 	DataRate m_max_rate{}; // max rate
 	Time m_nextAvail{};	//< Next time the QP is ready to send (regardless of if the queue is empty).
 	uint32_t m_lastPktSize{0};
 	bool m_finished{false};
+	RdmaPacketTemplate m_pktTemplate;
 
 	friend class RdmaHw;
+	friend class RdmaEgressQueue;
+	friend class RdmaTxQueuePairGroup;
+
+	/**
+	 * @brief State of the SQ in the scheduler of its `RdmaEgressQueue`.
+	 */
+	struct {
+		uint32_t index{0}; //!< Index in the `RdmaTxQueuePairGroup`.
+		uint64_t order{0}; //!< Round-robin position, increasing in the order the SQs are added to the group.
+		uint8_t state{0}; //!< One of `RdmaEgressQueue::SchedState`.
+		Time wake{}; //!< When waiting in the timer heap, the time of the valid entry.
+	} m_sched{};
 
 	/******************************
 	 * runtime states
 	 *****************************/
 	DataRate m_rate;	//< Current rate
-	struct {
-		DataRate m_targetRate;	//< Target rate
-		EventId m_eventUpdateAlpha;
-		double m_alpha;
-		bool m_alpha_cnp_arrived; // indicate if CNP arrived in the last slot
-		bool m_first_cnp; // indicate if the current CNP is the first CNP
-		EventId m_eventDecreaseRate;
-		bool m_decrease_cnp_arrived; // indicate if CNP arrived in the last slot
-		uint32_t m_rpTimeStage;
-		EventId m_rpTimer;
-	} mlx{};
-	struct {
-		uint32_t m_lastUpdateSeq;
-		DataRate m_curRate;
-		IntHop hop[IntHeader::maxHop];
-		uint32_t keep[IntHeader::maxHop];
-		uint32_t m_incStage;
-		double m_lastGap;
-		double u;
-		struct {
-			double u;
-			DataRate Rc;
-			uint32_t incStage;
-		}hopState[IntHeader::maxHop];
-	} hp{};
-	struct{
-		uint32_t m_lastUpdateSeq;
-		DataRate m_curRate;
-		uint32_t m_incStage;
-		uint64_t lastRtt;
-		double rttDiff;
-	} tmly{};
-	struct{
-		uint32_t m_lastUpdateSeq;
-		uint32_t m_caState;
-		uint32_t m_highSeq; // when to exit cwr
-		double m_alpha;
-		uint32_t m_ecnCnt;
-		uint32_t m_batchSizeOfAlpha;
-	} dctcp{};
-	struct{
-		uint32_t m_lastUpdateSeq;
-		DataRate m_curRate;
-		uint32_t m_incStage;
-	} hpccPint{};
+
+	/**
+	 * @brief State of the congestion control algorithm of the SQ.
+	 * By default, the `CcMode` of the `RdmaHw` (see `RdmaHw::SetCcMode()`).
+	 */
+	RdmaCcState m_cc{};
+
+	/**
+	 * @brief DCQCN state. The SQ should run DCQCN.
+	 */
+	DcqcnCc& Dcqcn() { return std::get<DcqcnCc>(m_cc); }
 };
 
 using RdmaImm = uint32_t;
@@ -281,6 +324,7 @@ public:
 private:
 	std::vector<Ptr<RdmaTxQueuePair>> m_qps;
 	Ptr<QbbNetDevice> m_dev;
+	uint64_t m_nextOrder{0}; //!< Round-robin position of the next SQ added.
 };
 
 }
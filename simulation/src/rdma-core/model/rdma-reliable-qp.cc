@@ -2,6 +2,7 @@
 #include <ns3/qbb-net-device.h>
 #include <ns3/rdma-hw.h>
 #include <ns3/rdma-bth.h>
+#include <ns3/packet-meta-tag.h>
 #include <ns3/qbb-header.h>
 #include <ns3/simulator.h>
 #include <ns3/ppp-header.h>
@@ -12,11 +13,11 @@ namespace ns3 {
 
 	
 static uint64_t make_key(uint32_t sip, uint16_t sport) {
-	return (sip << 32) | sport;
+	return (uint64_t{sip} << 32) | sport;
 } 
 
 static uint64_t make_key(Ipv4Address sip, uint16_t sport) {
-	return (sip.Get() << 32) | sport;
+	return make_key(sip.Get(), sport);
 } 
 
 struct MonitoringRcQp
@@ -26,8 +27,8 @@ struct MonitoringRcQp
 		Time last; // Last time the QP was monitored
 		uint64_t sq_psn{};
 		uint64_t rq_psn{};
-		RdmaReliableSQ* sq; // TX SQ
-		RdmaReliableRQ* rq; // RX RQ
+		RdmaReliableSQ* sq{}; // TX SQ
+		RdmaReliableRQ* rq{}; // RX RQ
 	};
 
 	// (sip, sport)
@@ -38,18 +39,70 @@ static MonitoringRcQp rcqp_mon;
 
 NS_LOG_COMPONENT_DEFINE("RdmaReliableQP");
 
+/**
+ * @brief The QPs are only monitored for the debug logs, to not look them up for each packet otherwise.
+ */
+static bool IsRcQpMonitored()
+{
+	return g_log.IsEnabled(LOG_DEBUG);
+}
+
+/**
+ * @brief Add the range [begin, end) to a set of disjoint ranges, merging the overlapping or adjacent ones.
+ */
+static void AddRange(std::map<uint64_t, uint64_t>& ranges, uint64_t begin, uint64_t end)
+{
+	auto it = ranges.upper_bound(begin);
+	if(it != ranges.begin() && std::prev(it)->second >= begin) {
+		--it;
+		begin = it->first;
+	}
+	while(it != ranges.end() && it->first <= end) {
+		end = std::max(end, it->second);
+		it = ranges.erase(it);
+	}
+	ranges.emplace(begin, end);
+}
+
+/**
+ * @brief Remove the part of the ranges below `first`.
+ */
+static void TrimRanges(std::map<uint64_t, uint64_t>& ranges, uint64_t first)
+{
+	while(!ranges.empty() && ranges.begin()->first < first) {
+		const uint64_t end = ranges.begin()->second;
+		ranges.erase(ranges.begin());
+		if(end > first) {
+			ranges.emplace(first, end);
+			break;
+		}
+	}
+}
+
 RdmaReliableSQ::RdmaReliableSQ(Ptr<Node> node, uint16_t pg, Ipv4Address sip, uint16_t sport, Ipv4Address dip, uint16_t dport)
     : RdmaTxQueuePair(node, pg, sip, sport),
       m_dip(dip),
-      m_dport(dport)
+      m_dport(dport),
+      m_flow_key(MakeEcmpFlowKey(sip.Get(), dip.Get(), sport, dport))
 {
 	NS_LOG_FUNCTION(this);
 
-	auto& info = rcqp_mon.tomonitor[make_key(sip, sport)];
-	info.sq = this;
+	if(IsRcQpMonitored()) {
+		auto& info = rcqp_mon.tomonitor[make_key(sip, sport)];
+		info.sq = this;
+	}
 }
 
-RdmaReliableSQ::~RdmaReliableSQ() = default;
+RdmaReliableSQ::~RdmaReliableSQ()
+{
+	m_retr_to.Cancel();
+
+	// The QPN and the port may be reused by a next QP
+	auto it = rcqp_mon.tomonitor.find(make_key(m_sip, m_sport));
+	if(it != rcqp_mon.tomonitor.end() && it->second.sq == this) {
+		rcqp_mon.tomonitor.erase(it);
+	}
+}
 
 void RdmaReliableSQ::SetAckInterval(uint64_t chunk, uint64_t ack_interval)
 {
@@ -84,6 +137,14 @@ void RdmaReliableSQ::Acknowledge(uint64_t next_psn_expected)
 			m_snd_nxt = m_snd_una;
 		}
 
+		if(m_selective) {
+			TrimRanges(m_sacked, m_snd_una);
+			if(m_recovery && m_snd_una >= m_recovery_end) {
+				NS_LOG_LOGIC("Exit recovery");
+				m_recovery = false;
+			}
+		}
+
 		NotifyPendingCompEvents();
 	}
 	
@@ -103,12 +164,22 @@ void RdmaReliableSQ::ScheduleRetrTimeout()
 
 	// https://www.rdmamojo.com/2013/01/12/ibv_modify_qp/
 	const Time retr_timeout = MicroSeconds(65.536);
-	m_retr_to = Simulator::Schedule(retr_timeout, &RdmaReliableSQ::OnRetrTimeout, this);
+	GetRdmaHw()->GetTimerWheel().Schedule(m_retr_to, retr_timeout, [this] { OnRetrTimeout(); });
 }
 
 void RdmaReliableSQ::OnRetrTimeout()
 {
 	NS_LOG_FUNCTION(this);
+
+	if(m_selective) {
+		// Everything not SACKed is lost, including the retransmissions
+		m_recovery = false;
+		EnterRecovery(m_snd_nxt);
+		ScheduleRetrTimeout();
+		TriggerDevTransmit();
+		return;
+	}
+
 	RecoverNack(m_snd_una);
 }
 
@@ -117,18 +188,19 @@ void RdmaReliableSQ::NotifyPendingCompEvents()
 	bool at_least_one_completion{false};
 
 	while(!m_to_send.empty()) {
-		auto it{m_to_send.begin()};
-		const SendRequest& next{it->second};
+		const SendRequest& next{m_to_send.front()};
 		const psn_t sr_end_psn{next.GetEndPSN()};
 		if(m_snd_una < sr_end_psn) {
 			break;
 		}
-		const OnSendCallback& on_ack{next.on_send};
+		const OnSendCallback on_ack{std::move(m_to_send.front().on_send)};
+		m_to_send.pop_front();
+		if(m_cur > 0) { m_cur--; }
 		if(on_ack) { on_ack(); }
-		m_to_send.erase(it);
 
 		at_least_one_completion = true;
 	}
+	SeekCurrent();
 
 	if(at_least_one_completion) {
 		// This may unblock, because next op could have been blocked until ACK is received
@@ -143,6 +215,10 @@ uint64_t RdmaReliableSQ::GetOnTheFly() const
 
 bool RdmaReliableSQ::IsWinBound() const
 {
+	if(HasRetxToSend()) {
+		return false; // Retransmissions are in the window
+	}
+
 	const uint64_t w = GetWin();
 	return w != 0 && GetOnTheFly() >= w;
 }
@@ -153,7 +229,7 @@ bool RdmaReliableSQ::HasDataToSend() const
 		NS_LOG_WARN("Should not happen");
 	}
 
-	return m_next_op_first_psn > m_snd_nxt && !m_to_send.empty();
+	return (m_next_op_first_psn > m_snd_nxt && !m_to_send.empty()) || HasRetxToSend();
 }
 
 bool RdmaReliableSQ::IsReadyToSend() const
@@ -180,7 +256,7 @@ bool RdmaReliableSQ::IsReadyToSend() const
 	return true;
 }
 
-void RdmaReliableSQ::PostSend(SendRequest sr)
+void RdmaReliableSQ::PushSendRequest(SendRequest&& sr)
 {
 	NS_LOG_FUNCTION(this);
 	
@@ -194,19 +270,26 @@ void RdmaReliableSQ::PostSend(SendRequest sr)
 	sr.first_psn = m_next_op_first_psn;
 	m_next_op_first_psn += sr.payload_size;
 
-	m_to_send[sr.first_psn] = sr;
-
 	NS_LOG_LOGIC("Post reliable psn=" << sr.first_psn << ",payload_size=" << sr.payload_size);
-	TriggerDevTransmit();
+	m_to_send.push_back(std::move(sr));
+}
+
+void RdmaReliableSQ::SeekCurrent()
+{
+	// `m_snd_nxt` only moves forward by at most one request at a time when sending,
+	// but can jump forward on ACK
+	while(m_cur < m_to_send.size() && m_to_send[m_cur].GetEndPSN() <= m_snd_nxt) {
+		m_cur++;
+	}
 }
 
 Ptr<Packet> RdmaReliableSQ::GetNextPacket()
 {
 	NS_LOG_FUNCTION(this);
 
-	{
+	if(IsRcQpMonitored()) {
 		auto it = rcqp_mon.tomonitor.find(make_key(m_sip, m_sport));
-		if(it != rcqp_mon.tomonitor.end()) {
+		if(it != rcqp_mon.tomonitor.end() && it->second.rq) {
 			auto& info = rcqp_mon.tomonitor[make_key(m_sip, m_sport)];
 
 			const Time now = Simulator::Now();
@@ -230,30 +313,65 @@ Ptr<Packet> RdmaReliableSQ::GetNextPacket()
 		}
 	}
 
-	if(m_to_send.empty()) {
+	if(HasRetxToSend()) {
+		return GetNextRetxPacket();
+	}
+
+	if(m_cur >= m_to_send.size()) {
 		NS_ASSERT(false);
 		return nullptr;
 	}
-	auto it{m_to_send.upper_bound(m_snd_nxt)};
-	NS_ASSERT_MSG(it != m_to_send.begin(), "{m_snd_nxt=" << m_snd_nxt << ",m_snd_una=" << m_snd_una << ",it->second.first_psn=" << it->second.first_psn << "}");
 
-	const SendRequest& sr{(--it)->second};
+	const SendRequest& sr{m_to_send[m_cur]};
+	NS_ASSERT_MSG(m_snd_nxt < sr.GetEndPSN(), "{m_snd_nxt=" << m_snd_nxt << ",m_snd_una=" << m_snd_una << ",sr.first_psn=" << sr.first_psn << "}");
 	const psn_t sr_already_sent_payload{m_snd_nxt - sr.first_psn};
 	NS_ASSERT(m_snd_nxt >= sr.first_psn);
 	const psn_t sr_rem_to_send{sr.payload_size - sr_already_sent_payload};
 	NS_ASSERT(sr_rem_to_send > 0);
 	const psn_t packet_size = std::min<psn_t>(m_mtu, sr_rem_to_send);
+	const bool op_last_pkt = (m_snd_nxt + packet_size == sr.GetEndPSN());
+	const bool ack_req = op_last_pkt || ShouldReqAck(packet_size); // The last packet always requests an ACK
+	
+	NS_LOG_INFO("Sending psn=" << m_snd_nxt << ",payload_size=" << packet_size);
+	Ptr<Packet> p = MakePacket(sr, m_snd_nxt, packet_size, ack_req);
+
+	// Update state
+	m_tx_bytes += packet_size;
+	if(m_snd_nxt < m_snd_high) {
+		m_retx_bytes += std::min<psn_t>(packet_size, m_snd_high - m_snd_nxt);
+	}
+	m_snd_nxt += packet_size;
+	m_snd_high = std::max(m_snd_high, m_snd_nxt);
+	if(op_last_pkt) {
+		m_cur++;
+	}
+
+	if(ack_req) {
+		NS_ASSERT(m_snd_nxt > highest_ack_psn);
+		highest_ack_psn = m_snd_nxt;
+		if(!m_retr_to.IsRunning()) {
+			ScheduleRetrTimeout();
+		}
+	}
 
+	// return
+	return p;
+}
+
+Ptr<Packet> RdmaReliableSQ::MakePacket(const SendRequest& sr, psn_t psn, psn_t size, bool ack_req)
+{
 	RdmaBTH bth;
 	bth.SetReliable(true);
 	bth.SetMulticast(false);
-	bth.SetDestQpKey(m_dport);
+	bth.SetDestQpn(m_dqpn);
+	bth.SetSrcQpn(m_qpn);
+	bth.SetFlowKey(m_flow_key);
 
-	const bool op_last_pkt = (m_snd_nxt + packet_size == sr.GetEndPSN());
+	const bool op_last_pkt = (psn + size == sr.GetEndPSN());
 	
 	if (!op_last_pkt) {
 		bth.SetNotif(false);
-		bth.SetAckReq(ShouldReqAck(packet_size));
+		bth.SetAckReq(ack_req);
 	}
 	else {
 		bth.SetNotif(true); // Last packet, generate a notif on the RX
@@ -261,55 +379,92 @@ Ptr<Packet> RdmaReliableSQ::GetNextPacket()
 		bth.SetImm(sr.imm);
 	}
 	
-	NS_LOG_INFO("Sending psn=" << m_snd_nxt << ",payload_size=" << packet_size);
-	Ptr<Packet> p = Create<Packet>(packet_size);
-
-	// Add RdmaSeqHeader
-	RdmaSeqHeader seqTs;
-	seqTs.SetSeq(m_snd_nxt);
-	seqTs.SetPG(m_pg);
-	p->AddHeader(seqTs);
-	
-	// Add UDP header
-	UdpHeader udpHeader;
-	udpHeader.SetDestinationPort(m_dport);
-	udpHeader.SetSourcePort(m_sport);
-	p->AddHeader(udpHeader);
-
-	// Add IPv4 header
-	Ipv4Header ipHeader;
-	ipHeader.SetSource(m_sip);
-	ipHeader.SetDestination(m_dip);
-	ipHeader.SetProtocol(0x11);
-	ipHeader.SetPayloadSize(p->GetSize());
-	ipHeader.SetTtl(64);
-	ipHeader.SetTos(0);
-	ipHeader.SetIdentification(m_ipid);
-	p->AddHeader(ipHeader);
-
-	// Add PPP header
-	PppHeader ppp;
-	ppp.SetProtocol(0x0021); // EtherToPpp(0x800), see point-to-point-net-device.cc
-	p->AddHeader(ppp);
+	Ptr<Packet> p = GetPacketTemplate().MakeData(m_dip, m_dport, psn, m_ipid, size);
 
 	// Add BTH header
 	p->AddPacketTag(bth);
 
-	// Update state
-	m_snd_nxt += packet_size;
+	PacketMetaTag meta(0x11, m_sip.Get(), m_dip.Get(), m_sport, m_dport, m_pg);
+	p->AddPacketTag(meta);
 
 	// Wrap-around is guaranteed in C++. This will reset to zero after overflow.
 	m_ipid++;
 
-	if(bth.GetAckReq()) {
-		NS_ASSERT(m_snd_nxt > highest_ack_psn);
-		highest_ack_psn = m_snd_nxt;
-		if(!m_retr_to.IsRunning()) {
-			ScheduleRetrTimeout();
+	return p;
+}
+
+size_t RdmaReliableSQ::FindRequest(psn_t psn) const
+{
+	// The requests are sorted by PSN, and `psn` is before `m_snd_nxt`
+	size_t lo = 0;
+	size_t hi = std::min(m_cur + 1, m_to_send.size());
+	while(hi - lo > 1) {
+		const size_t mid = (lo + hi) / 2;
+		if(m_to_send[mid].first_psn <= psn) {
+			lo = mid;
+		}
+		else {
+			hi = mid;
 		}
 	}
+	NS_ASSERT(psn >= m_to_send[lo].first_psn && psn < m_to_send[lo].GetEndPSN());
+	return lo;
+}
+
+void RdmaReliableSQ::EnterRecovery(psn_t sack_high)
+{
+	if(!m_recovery) {
+		NS_LOG_LOGIC("Enter recovery {una=" << m_snd_una << ",nxt=" << m_snd_nxt << "}");
+		m_recovery = true;
+		m_recovery_end = m_snd_nxt;
+		m_retx_nxt = m_snd_una;
+		m_sack_high = 0;
+	}
+	m_sack_high = std::max(m_sack_high, sack_high);
+}
+
+RdmaReliableSQ::psn_t RdmaReliableSQ::GetNextRetxPSN() const
+{
+	// Skip the SACKed range, if any. The ranges are merged so there is at most one.
+	psn_t psn = std::max(m_retx_nxt, m_snd_una);
+	auto it = m_sacked.upper_bound(psn);
+	if(it != m_sacked.begin() && std::prev(it)->second > psn) {
+		psn = std::prev(it)->second;
+	}
+	return psn;
+}
+
+bool RdmaReliableSQ::HasRetxToSend() const
+{
+	return m_recovery && GetNextRetxPSN() < std::min(m_sack_high, m_snd_nxt);
+}
+
+Ptr<Packet> RdmaReliableSQ::GetNextRetxPacket()
+{
+	const psn_t psn = GetNextRetxPSN();
+	
+	// Retransmit until the next SACKed range
+	psn_t hole_end = std::min(m_sack_high, m_snd_nxt);
+	auto it = m_sacked.upper_bound(psn);
+	if(it != m_sacked.end()) {
+		hole_end = std::min(hole_end, it->first);
+	}
+
+	const SendRequest& sr{m_to_send[FindRequest(psn)]};
+	const psn_t packet_size = std::min<psn_t>({m_mtu, sr.GetEndPSN() - psn, hole_end - psn});
+
+	NS_LOG_INFO("Retransmitting psn=" << psn << ",payload_size=" << packet_size);
+	Ptr<Packet> p = MakePacket(sr, psn, packet_size, true);
+
+	m_retx_nxt = psn + packet_size;
+	m_tx_bytes += packet_size;
+	m_retx_bytes += packet_size;
+
+	highest_ack_psn = std::max(highest_ack_psn, m_retx_nxt);
+	if(!m_retr_to.IsRunning()) {
+		ScheduleRetrTimeout();
+	}
 
-	// return
 	return p;
 }
 
@@ -323,11 +478,24 @@ void RdmaReliableSQ::RecoverNack(uint64_t next_psn_expected)
 	TriggerDevTransmit();
 }
 
+void RdmaReliableSQ::RecoverSack(uint64_t next_psn_expected, uint64_t sack_begin, uint64_t sack_end)
+{
+	NS_LOG_FUNCTION(this << next_psn_expected << sack_begin << sack_end);
+
+	Acknowledge(next_psn_expected);
+	if(sack_end > m_snd_una) {
+		AddRange(m_sacked, std::max<uint64_t>(sack_begin, m_snd_una), sack_end);
+	}
+	EnterRecovery(sack_end);
+	TriggerDevTransmit();
+}
+
 void RdmaReliableSQ::Rollback()
 {
 	// NS_ASSERT(!m_to_send.empty());
 	NS_ASSERT_MSG(m_snd_nxt >= m_snd_una, "{m_snd_nxt=" << m_snd_nxt << ",m_snd_una=" << m_snd_una << "}");
 	m_snd_nxt = m_snd_una;
+	m_cur = 0; // the front request is the one of `m_snd_una`
 	highest_ack_psn = m_snd_una;
 
 	ScheduleRetrTimeout();
@@ -363,10 +531,22 @@ bool RdmaReliableRQ::Receive(Ptr<Packet> p, const CustomHeader& ch)
 }
 
 RdmaReliableRQ::RdmaReliableRQ(Ptr<RdmaReliableSQ> sq)
-	: RdmaRxQueuePair{sq}
+	: RdmaRxQueuePair{sq}, m_sq{PeekPointer(sq)}
 {
-	auto& info = rcqp_mon.tomonitor[make_key(sq->GetDestIP(), sq->GetDestPort())];
-	info.rq = this;
+	if(IsRcQpMonitored()) {
+		auto& info = rcqp_mon.tomonitor[make_key(sq->GetDestIP(), sq->GetDestPort())];
+		info.rq = this;
+	}
+}
+
+RdmaReliableRQ::~RdmaReliableRQ()
+{
+	RdmaReliableSQ* sq = m_sq;
+	auto it = rcqp_mon.tomonitor.find(make_key(sq->GetDestIP(), sq->GetDestPort()));
+	if(it != rcqp_mon.tomonitor.end() && it->second.rq == this) {
+		it->second.rq = nullptr;
+	}
+	m_ackTimer.Cancel();
 }
 
 int RdmaReliableRQ::ReceiverCheckSeq(uint32_t seq, uint32_t size)
@@ -403,6 +583,48 @@ int RdmaReliableRQ::ReceiverCheckSeq(uint32_t seq, uint32_t size)
 	}
 }
 
+int RdmaReliableRQ::ReceiverCheckSeqSr(uint32_t seq, uint32_t size)
+{
+	NS_LOG_FUNCTION(this << seq << size);
+
+	// Same return values as `ReceiverCheckSeq()`,
+	// but the packets out of order are kept and always generate a NACK with a SACK
+	const uint64_t expected = ReceiverNextExpectedSeq;
+	const uint64_t end = uint64_t{seq} + size;
+	if (end <= expected) {
+		NS_LOG_LOGIC("Duplicate received {expected=" << expected << ",recv=" << seq << "}");
+		return 3;
+	}
+	if (seq > expected) {
+		NS_LOG_LOGIC("Out of order {expected=" << expected << ",recv=" << seq << "}");
+		AddRange(m_ooo, seq, end);
+		return 2;
+	}
+
+	// Fill a hole, and the ranges received out of order may now be in order
+	ReceiverNextExpectedSeq = end;
+	bool hole_filled{false};
+	while (!m_ooo.empty() && m_ooo.begin()->first <= ReceiverNextExpectedSeq) {
+		ReceiverNextExpectedSeq = std::max<uint64_t>(ReceiverNextExpectedSeq, m_ooo.begin()->second);
+		m_ooo.erase(m_ooo.begin());
+		hole_filled = true;
+	}
+	return hole_filled ? 1 : 5;
+}
+
+void RdmaReliableRQ::NotifyInOrder()
+{
+	while (!m_pendingNotifs.empty() && m_pendingNotifs.begin()->first <= ReceiverNextExpectedSeq) {
+		RecvNotif notif;
+		notif.has_imm = true;
+		notif.imm = m_pendingNotifs.begin()->second;
+		m_pendingNotifs.erase(m_pendingNotifs.begin());
+		if (m_onRecv) {
+			m_onRecv(notif);
+		}
+	}
+}
+
 /**
  * \return true If the interval between the two values spans on more than one chunk.
  */
@@ -447,14 +669,15 @@ void RdmaReliableRQ::ReceiveUdp(Ptr<Packet> p, const CustomHeader &ch)
 	NS_ABORT_UNLESS(p->PeekPacketTag(bth));
 	NS_ASSERT(bth.GetReliable());
 	NS_ASSERT(ch.dip == m_local_ip);
-	NS_ASSERT(ch.sip == DynamicCast<RdmaReliableSQ>(m_tx)->GetDestIP());
-	NS_ASSERT(ch.udp.sport == DynamicCast<RdmaReliableSQ>(m_tx)->GetDestPort());
+	NS_ASSERT(ch.sip == m_sq->GetDestIP());
+	NS_ASSERT(ch.udp.sport == m_sq->GetDestPort());
 	NS_ASSERT(ch.udp.dport == m_local_port);
 	
 	const uint8_t ecnbits = ch.GetIpv4EcnBits();
 	const uint32_t payload_size = p->GetSize() - ch.GetSerializedSize();
-	int x = ReceiverCheckSeq(ch.udp.seq, payload_size);
+	int x = m_selective ? ReceiverCheckSeqSr(ch.udp.seq, payload_size) : ReceiverCheckSeq(ch.udp.seq, payload_size);
 	const bool success{x == 1 || x == 5};
+	const bool duplicate{x == 3};
 
 	if(bth.GetAckReq()) {
 			NS_LOG_LOGIC("ACK requested, sending back ACK");
@@ -467,9 +690,6 @@ void RdmaReliableRQ::ReceiveUdp(Ptr<Packet> p, const CustomHeader &ch)
 	}
 
 	if (x == 1 || x == 2) { //generate ACK or NACK
-		
-		NS_LOG_LOGIC("Send back " << (x == 1 ? "ACK" : "NACK"));
-		
 		qbbHeader seqh;
 		seqh.SetSeq(ReceiverNextExpectedSeq);
 		seqh.SetPG(ch.udp.pg);
@@ -478,45 +698,27 @@ void RdmaReliableRQ::ReceiveUdp(Ptr<Packet> p, const CustomHeader &ch)
 		seqh.SetIntHeader(ch.udp.ih);
 		if (ecnbits)
 			seqh.SetCnp();
+		if (x == 2 && m_selective)
+			seqh.SetSack(ch.udp.seq, ch.udp.seq + payload_size);
 
-		Ptr<Packet> newp = Create<Packet>(std::max(60-14-20-(int)seqh.GetSerializedSize(), 0));
-		newp->AddHeader(seqh);
-
-		Ipv4Header head;	// Prepare IPv4 header
-		head.SetDestination(Ipv4Address(ch.sip));
-		head.SetSource(Ipv4Address(ch.dip));
-		head.SetProtocol(x == 1 ? 0xFC : 0xFD); //ack=0xFC nack=0xFD
-		head.SetTtl(64);
-		head.SetPayloadSize(newp->GetSize());
-		head.SetIdentification(m_ipid++);
-
-		newp->AddHeader(head);
-		
-		const auto EtherToPpp = [](uint16_t proto) -> uint16_t {
-			switch(proto){
-				case 0x0800: return 0x0021;   //IPv4
-				case 0x86DD: return 0x0057;   //IPv6
-				default: NS_ASSERT_MSG (false, "PPP Protocol number not defined!");
-			}
-			return 0;
-		};
-
-		PppHeader ppp;
-		ppp.SetProtocol(EtherToPpp (0x800));
-		newp->AddHeader (ppp);
-
-		RdmaBTH bth;
-		bth.SetDestQpKey(ch.udp.sport);
-		newp->AddPacketTag(bth);
-
-		// send
-		Ptr<QbbNetDevice> dev = m_tx->GetDevice();
-		dev->RdmaEnqueueHighPrioQ(newp);
-		m_tx->TriggerDevTransmit();
+		// NACKs, CNPs and the ACK of the last packet of a request are never delayed
+		if (x == 1 && !ecnbits && !bth.GetNotif() && CoalesceAck(seqh)) {
+			NS_LOG_LOGIC("Coalesce ACK of " << ReceiverNextExpectedSeq);
+		}
+		else {
+			SendAck(x == 1 ? 0xFC : 0xFD, seqh); //ack=0xFC nack=0xFD
+		}
 	}
 
+	if(m_selective) {
+		// The request is complete once all its packets are received, in any order
+		if(!duplicate && bth.GetNotif()) {
+			m_pendingNotifs.emplace(uint64_t{ch.udp.seq} + payload_size, bth.GetImm());
+		}
+		NotifyInOrder();
+	}
 	// If no error, call completion event
-	if(m_onRecv && success && bth.GetNotif()) {
+	else if(m_onRecv && success && bth.GetNotif()) {
 		RecvNotif notif;
 		notif.has_imm = true;
 		notif.imm = bth.GetImm();
@@ -524,6 +726,55 @@ void RdmaReliableRQ::ReceiveUdp(Ptr<Packet> p, const CustomHeader &ch)
 	}
 }
 
+bool RdmaReliableRQ::CoalesceAck(const qbbHeader& seqh)
+{
+	if (m_coalesceBytes == 0 || ReceiverNextExpectedSeq - m_lastAckSeq >= m_coalesceBytes) {
+		return false;
+	}
+
+	// Only the last ACK is kept: it acknowledges all the previous ones, and has the latest INT
+	m_pendingAck = seqh;
+	if (!m_ackTimer.IsRunning()) {
+		m_sq->GetRdmaHw()->GetTimerWheel().Schedule(m_ackTimer, m_coalesceDelay, [this] { FlushAck(); });
+	}
+	return true;
+}
+
+void RdmaReliableRQ::FlushAck()
+{
+	NS_LOG_FUNCTION(this);
+	SendAck(0xFC, m_pendingAck);
+}
+
+void RdmaReliableRQ::SendAck(uint8_t l3Prot, const qbbHeader& seqh)
+{
+	NS_LOG_LOGIC("Send back " << (l3Prot == 0xFC ? "ACK" : "NACK") << " of " << seqh.GetSeq());
+
+	// This ACK supersedes the coalesced one
+	m_ackTimer.Cancel();
+	m_lastAckSeq = seqh.GetSeq();
+
+	RdmaReliableSQ* sq = m_sq;
+	if (!m_ackTemplate.IsInit()) {
+		m_ackTemplate.InitAck(Ipv4Address(m_local_ip), Ipv4Address(sq->GetDestIP()));
+	}
+	Ptr<Packet> newp = m_ackTemplate.MakeAck(l3Prot, m_ipid++, seqh);
+
+	RdmaBTH bth;
+	bth.SetDestQpn(sq->GetDestQpn());
+	bth.SetSrcQpn(m_tx->GetQpn());
+	bth.SetFlowKey(MakeEcmpFlowKey(m_local_ip, sq->GetDestIP(), m_local_port, sq->GetDestPort()));
+	newp->AddPacketTag(bth);
+
+	PacketMetaTag meta(l3Prot, m_local_ip, sq->GetDestIP(), m_local_port, sq->GetDestPort(), seqh.GetPG());
+	newp->AddPacketTag(meta);
+
+	// send
+	Ptr<QbbNetDevice> dev = m_tx->GetDevice();
+	dev->RdmaEnqueueHighPrioQ(newp);
+	m_tx->TriggerDevTransmit();
+}
+
 void RdmaReliableRQ::ReceiveAck(Ptr<Packet> p, const CustomHeader &ch)
 {
 	NS_LOG_FUNCTION(this);
@@ -540,8 +791,11 @@ void RdmaReliableRQ::ReceiveAck(Ptr<Packet> p, const CustomHeader &ch)
 	const bool nack = (ch.l3Prot == 0xFD);
 	int i;
 	
-	Ptr<RdmaReliableSQ> tx = DynamicCast<RdmaReliableSQ>(m_tx);
-	NS_ASSERT(tx);
+	RdmaReliableSQ* tx = m_sq;
+
+	// The window may depend on the rate
+	RdmaHw* rdma = m_tx->GetRdmaHw();
+	rdma->UpdateDcqcn(m_tx);
 
 	if (!m_backto0) {
 		tx->Acknowledge(seq);
@@ -551,21 +805,25 @@ void RdmaReliableRQ::ReceiveAck(Ptr<Packet> p, const CustomHeader &ch)
 		tx->Acknowledge(goback_seq);
 	}
 	
-	if (nack) {
+	if (nack && m_selective) {
+		tx->RecoverSack(seq, ch.ack.sackBegin, ch.ack.sackEnd);
+	}
+	else if (nack) {
 		tx->RecoverNack(seq);
 	}
 	
-	Ptr<RdmaHw> rdma = m_tx->GetNode()->GetObject<RdmaHw>();
-	const uint32_t cc = rdma->GetCC();
-	NS_ASSERT(cc == 1);
-	
 	if (cnp){
 		m_tx->LazyInitCnp();
-		rdma->cnp_received_mlx(m_tx);
 	}
+
+	RdmaCcFeedback fb;
+	fb.ack_seq = seq;
+	fb.snd_nxt = tx->GetNextToSendPSN();
+	fb.ecn = cnp;
+	fb.ih = &ch.ack.ih;
+	rdma->ReceiveAck(m_tx, fb);
 	
 	// ACK may advance the on-the-fly window, allowing more packets to send
-	Ptr<QbbNetDevice> dev = m_tx->GetDevice();
 	m_tx->TriggerDevTransmit();
 }
 
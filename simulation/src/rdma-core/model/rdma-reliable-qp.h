@@ -1,8 +1,11 @@
 #pragma once
 
 #include <ns3/rdma-queue-pair.h>
-#include <queue>
+#include <ns3/ecmp-hash.h>
+#include <ns3/qbb-header.h>
+#include <ns3/rdma-ring-buffer.h>
 #include <map>
+#include <queue>
 
 namespace ns3 {
 
@@ -19,36 +22,76 @@ public:
 	void SetVarWin(bool v);
 	void Acknowledge(uint64_t next_psn_expected);
 	uint64_t GetOnTheFly() const;
-	bool IsWinBound() const;
+	bool IsWinBound() const override;
 	uint64_t GetWin() const; // window size calculated from m_rate
 	uint64_t GetChunk() const { return m_chunk; }
 	bool IsReadyToSend() const override;
 	bool HasDataToSend() const override;
-	void PostSend(SendRequest sr) override;
 	Ptr<Packet> GetNextPacket() override;
+	uint64_t GetNextPsn() const override { return HasRetxToSend() ? GetNextRetxPSN() : m_snd_nxt; }
 	
 	void RecoverNack(uint64_t next_psn_expected);
 
+	/**
+	 * @brief Selective repeat (IRN): on NACK, only retransmit the PSNs the receiver has not SACKed,
+	 * instead of going back to the first lost PSN.
+	 */
+	void SetSelectiveRepeat(bool sr) { m_selective = sr; }
+
+	/**
+	 * @brief Receive a NACK in selective repeat.
+	 * @param sack_begin, sack_end PSN range received out of order by the receiver.
+	 */
+	void RecoverSack(uint64_t next_psn_expected, uint64_t sack_begin, uint64_t sack_end);
+
+	uint64_t GetTxBytes() const { return m_tx_bytes; } //!< Payload sent, including retransmissions.
+	uint64_t GetRetxBytes() const { return m_retx_bytes; } //!< Payload sent more than once.
+	uint64_t GetAckedBytes() const { return m_snd_una; } //!< Payload received by the receiver (goodput).
+
 	uint16_t GetDestPort() const { return m_dport; }
+
+	/**
+	 * @brief Connect to the remote QP, like `ibv_modify_qp()` to RTR.
+	 * Without it, the remote QP is the one bound to the destination port (see `RdmaHw::BindPort()`).
+	 */
+	void SetDestQpn(uint32_t qpn) { m_dqpn = qpn; }
+	uint32_t GetDestQpn() const { return m_dqpn; }
 	uint32_t GetDestIP() const { return m_dip.Get(); }
 	uint32_t GetFirstUnaPSN() const { return m_snd_una; }
 	uint32_t GetNextToSendPSN() const { return m_snd_nxt; }
 	uint32_t GetNextOpFirstPSN() const { return m_next_op_first_psn; }
 
+protected:
+	void PushSendRequest(SendRequest&& sr) override;
+
 private:
 	bool ShouldReqAck(uint64_t payload_size) const;
 	void NotifyPendingCompEvents();
 	void Rollback();
+	void SeekCurrent();
 	void ScheduleRetrTimeout();
 	void OnRetrTimeout();
+	Ptr<Packet> MakePacket(const SendRequest& sr, psn_t psn, psn_t size, bool ack_req);
+	size_t FindRequest(psn_t psn) const;
+	void EnterRecovery(psn_t sack_high);
+	psn_t GetNextRetxPSN() const;
+	bool HasRetxToSend() const;
+	Ptr<Packet> GetNextRetxPacket();
 
 private:
-	EventId m_retr_to;
+	RdmaTimer m_retr_to;
 	uint64_t highest_ack_psn{0}; //!< PSN following the highest PSN sent with an ACK request.
 
-	std::map<psn_t, SendRequest> m_to_send; //!< Pending packet to send. Removed when ACKed.
+	/**
+	 * @brief Posted send requests, in PSN order. Removed from the front when ACKed.
+	 * The front is the request of `m_snd_una`.
+	 */
+	RdmaRingBuffer<SendRequest> m_to_send;
+	size_t m_cur{0}; //!< Index in `m_to_send` of the request of `m_snd_nxt`.
 	Ipv4Address m_dip;
 	uint16_t m_dport{0};
+	uint32_t m_dqpn{0};
+	EcmpFlowKey m_flow_key{}; //!< Same for all data packets of the SQ.
 	uint16_t m_ipid{0};
 	uint64_t m_snd_nxt{0}; 	  		//<! Next PSN to send.
   	uint64_t m_snd_una{0}; 	  		//<! Lowest PSN unacknowledged.
@@ -57,21 +100,46 @@ private:
 	uint64_t m_next_op_first_psn{};
 	uint64_t m_chunk{0};
 	uint64_t m_ack_interval{0};
+	uint64_t m_snd_high{0}; //!< Highest PSN sent, the payload below is retransmitted.
+	uint64_t m_tx_bytes{0};
+	uint64_t m_retx_bytes{0};
+
+	// Selective repeat
+	bool m_selective{false};
+	bool m_recovery{false};
+	psn_t m_recovery_end{0}; //!< The recovery ends when the PSNs sent before the first loss are ACKed.
+	psn_t m_retx_nxt{0};     //!< Next PSN to retransmit in recovery.
+	psn_t m_sack_high{0};    //!< The PSNs below not ACKed nor SACKed are lost.
+	std::map<psn_t, psn_t> m_sacked; //!< Ranges [first, second) SACKed by the receiver, above `m_snd_una`.
 };
 
 class RdmaReliableRQ : public RdmaRxQueuePair
 {
 public:
 	RdmaReliableRQ(Ptr<RdmaReliableSQ> sq);
+	~RdmaReliableRQ() override;
 	bool Receive(Ptr<Packet> p, const CustomHeader& ch) override;
 
-	uint32_t GetChunk() const { return DynamicCast<RdmaReliableSQ>(m_tx)->GetChunk(); }
+	uint32_t GetChunk() const { return m_sq->GetChunk(); }
 	void SetNackInterval(Time nack_itv) { m_nack_interval = nack_itv; }
 	void SetBackTo0(bool backto0) { m_backto0 = backto0; }
+	void SetSelectiveRepeat(bool sr) { m_selective = sr; }
+
+	/**
+	 * @brief Delay the ACKs until `bytes` are received since the last ACK, for at most `delay`.
+	 * @param bytes Zero to send an ACK for each packet requesting one.
+	 */
+	void SetAckCoalescing(uint32_t bytes, Time delay)
+	{
+		m_coalesceBytes = bytes;
+		m_coalesceDelay = delay;
+	}
 
 	uint32_t GetNextExpectedPSN() const { return ReceiverNextExpectedSeq; }
 
 protected:
+	RdmaReliableSQ* m_sq; //!< Same as `m_tx`, already cast.
+
 	//! Next expected PSN to receive.
 	uint32_t ReceiverNextExpectedSeq{0};
 
@@ -79,8 +147,34 @@ protected:
 	Time m_nack_interval{0};
 	uint32_t m_lastNACK{0};
 	bool m_backto0{false};
+
+	// Selective repeat
+	bool m_selective{false};
+	std::map<uint64_t, uint64_t> m_ooo; //!< PSN ranges [first, second) received out of order.
+	std::map<uint64_t, uint32_t> m_pendingNotifs; //!< Immediate of the requests received out of order, by end PSN.
+	RdmaPacketTemplate m_ackTemplate; //!< Headers of the ACKs and NACKs, prepared on the first one.
+
+	// ACK coalescing
+	uint32_t m_coalesceBytes{0};
+	Time m_coalesceDelay{0};
+	uint32_t m_lastAckSeq{0}; //!< PSN of the last ACK or NACK sent.
+	qbbHeader m_pendingAck;   //!< ACK delayed until `m_ackTimer`.
+	RdmaTimer m_ackTimer;
 	
 	int ReceiverCheckSeq(uint32_t seq, uint32_t size);
+	int ReceiverCheckSeqSr(uint32_t seq, uint32_t size);
+
+	/**
+	 * @brief Generate the notifications of the requests received out of order that are now complete.
+	 */
+	void NotifyInOrder();
+
+	/**
+	 * @return true If the ACK is delayed, to be merged with the next ones.
+	 */
+	bool CoalesceAck(const qbbHeader& seqh);
+	void FlushAck();
+	void SendAck(uint8_t l3Prot, const qbbHeader& seqh);
 	
 	/**
 	 * @brief Send ACK or NACK when appropriate.
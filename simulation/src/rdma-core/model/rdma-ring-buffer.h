@@ -0,0 +1,72 @@
+#pragma once
+
+#include <ns3/assert.h>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * @brief FIFO in a circular buffer, with random access.
+ *
+ * The capacity is a power of two and doubles when full, so the elements are contiguous
+ * (modulo the wrap-around) and a push or pop is O(1) without allocation in the steady state.
+ * `T` should be default-constructible and movable. Popped slots are reset to `T{}`.
+ */
+template<typename T>
+class RdmaRingBuffer
+{
+public:
+	bool empty() const { return m_size == 0; }
+	size_t size() const { return m_size; }
+
+	T& operator[](size_t i)
+	{
+		NS_ASSERT(i < m_size);
+		return m_buf[(m_head + i) & (m_buf.size() - 1)];
+	}
+
+	const T& operator[](size_t i) const
+	{
+		NS_ASSERT(i < m_size);
+		return m_buf[(m_head + i) & (m_buf.size() - 1)];
+	}
+
+	T& front() { return (*this)[0]; }
+	T& back() { return (*this)[m_size - 1]; }
+
+	void push_back(T&& value)
+	{
+		if (m_size == m_buf.size()) {
+			Grow();
+		}
+		m_buf[(m_head + m_size) & (m_buf.size() - 1)] = std::move(value);
+		m_size++;
+	}
+
+	void pop_front()
+	{
+		NS_ASSERT(m_size > 0);
+		m_buf[m_head] = T{};
+		m_head = (m_head + 1) & (m_buf.size() - 1);
+		m_size--;
+	}
+
+private:
+	void Grow()
+	{
+		std::vector<T> buf(m_buf.empty() ? 8 : m_buf.size() * 2);
+		for (size_t i = 0; i < m_size; i++) {
+			buf[i] = std::move((*this)[i]);
+		}
+		m_buf = std::move(buf);
+		m_head = 0;
+	}
+
+	std::vector<T> m_buf;
+	size_t m_head{0};
+	size_t m_size{0};
+};
+
+} // namespace ns3
@@ -0,0 +1,373 @@
+#include <ns3/rdma-timer-wheel.h>
+#include <ns3/simulator.h>
+#include <ns3/event-impl.h>
+#include <ns3/assert.h>
+#include <algorithm>
+#include <bit>
+#include <limits>
+
+namespace ns3 {
+
+RdmaTimerWheel::SchedulerStats RdmaTimerWheel::s_sched{};
+
+namespace {
+
+/// @brief `RdmaTimer::m_level` of a timer unlinked from its slot, to be fired by the current tick.
+constexpr uint8_t expiringLevel = 0xFF;
+
+/// @brief `RdmaTimer::m_level` of a timer scheduled as a simulator event.
+constexpr uint8_t eventLevel = 0xFE;
+
+/**
+ * @return The first slot set in the bitmap from `from`, or -1.
+ */
+int FindSlot(const std::array<uint64_t, RdmaTimerWheel::slots / 64>& bits, uint32_t from)
+{
+	for (uint32_t w = from / 64; w < bits.size(); w++) {
+		uint64_t b = bits[w];
+		if (w == from / 64) {
+			b &= ~uint64_t{0} << (from % 64);
+		}
+		if (b) {
+			return w * 64 + std::countr_zero(b);
+		}
+	}
+	return -1;
+}
+
+/**
+ * @brief Cancel the event without going through the simulator, which may already be destroyed.
+ */
+void CancelEvent(EventId& id)
+{
+	if (EventImpl* ev = id.PeekEventImpl()) {
+		ev->Cancel();
+	}
+	id = EventId();
+}
+
+} // namespace
+
+/**
+ * @brief Simulator event of a timer, or of a tick of the wheel if without timer.
+ */
+class RdmaTimerWheel::Event : public EventImpl
+{
+public:
+	Event(RdmaTimerWheel* wheel, RdmaTimer* timer)
+		: m_wheel{wheel}, m_timer{timer}
+	{
+		s_sched.pending++;
+		s_sched.maxPending = std::max(s_sched.maxPending, s_sched.pending);
+	}
+
+	~Event() override
+	{
+		s_sched.pending--;
+	}
+
+protected:
+	void Notify() override
+	{
+		if (m_timer) {
+			m_wheel->Expire(*m_timer);
+		}
+		else {
+			m_wheel->OnTick();
+		}
+	}
+
+private:
+	RdmaTimerWheel* m_wheel;
+	RdmaTimer* m_timer;
+};
+
+RdmaTimer& RdmaTimer::operator=(const RdmaTimer&)
+{
+	Cancel();
+	return *this;
+}
+
+RdmaTimer::~RdmaTimer()
+{
+	Cancel();
+}
+
+void RdmaTimer::Cancel()
+{
+	if (m_wheel) {
+		m_wheel->Cancel(*this);
+	}
+}
+
+RdmaTimerWheel::~RdmaTimerWheel()
+{
+	Clear();
+}
+
+void RdmaTimerWheel::Configure(Time tick)
+{
+	NS_ASSERT(!tick.IsStrictlyNegative());
+	Clear();
+	m_tick = tick;
+	m_now = 0;
+}
+
+void RdmaTimerWheel::Schedule(RdmaTimer& timer, Time delay, std::function<void()> fn)
+{
+	NS_ASSERT(!delay.IsStrictlyNegative());
+
+	if (timer.IsRunning()) {
+		Cancel(timer);
+	}
+	m_stats.arms++;
+
+	timer.m_wheel = this;
+	timer.m_fn = std::move(fn);
+	timer.m_expiry = Simulator::Now() + delay;
+	timer.m_seq = m_seq++;
+
+	if (!IsEnabled()) {
+		timer.m_level = eventLevel;
+		timer.m_event = ScheduleEvent(timer.m_expiry, &timer);
+		Link(timer, m_eventTimers);
+		return;
+	}
+
+	// Nothing is due before the event of the next tick, so the wheel can catch up with the time at once
+	const int64_t step = m_tick.GetTimeStep();
+	uint64_t now = Simulator::Now().GetTimeStep() / step;
+	if (m_event.PeekEventImpl()) {
+		now = std::min(now, m_eventTick - 1);
+	}
+	m_now = std::max(m_now, now);
+
+	timer.m_tick = std::max<uint64_t>((timer.m_expiry.GetTimeStep() + step - 1) / step, m_now + 1);
+	Link(timer);
+	ScheduleTick();
+}
+
+void RdmaTimerWheel::Clear()
+{
+	auto disarm = [](RdmaTimer* t) {
+		t->m_wheel = nullptr;
+		t->m_fn = nullptr;
+		CancelEvent(t->m_event);
+	};
+
+	for (auto& level : m_slots) {
+		for (RdmaTimer*& head : level) {
+			for (RdmaTimer* t = head; t; t = t->m_next) {
+				disarm(t);
+			}
+			head = nullptr;
+		}
+	}
+	for (RdmaTimer* t = m_eventTimers; t; t = t->m_next) {
+		disarm(t);
+	}
+	m_eventTimers = nullptr;
+	for (RdmaTimer* t : m_expiring) {
+		if (t) {
+			disarm(t);
+		}
+	}
+	m_expiring.clear();
+
+	m_occupied = {};
+	m_count = 0;
+	CancelEvent(m_event);
+}
+
+void RdmaTimerWheel::Cancel(RdmaTimer& timer)
+{
+	NS_ASSERT(timer.m_wheel == this);
+	m_stats.cancels++;
+
+	if (timer.m_level == eventLevel) {
+		CancelEvent(timer.m_event);
+		Unlink(timer, m_eventTimers);
+	}
+	else if (timer.m_level == expiringLevel) {
+		// Cancelled by a timer firing in the same tick
+		*std::find(m_expiring.begin(), m_expiring.end(), &timer) = nullptr;
+	}
+	else {
+		Unlink(timer);
+		if (m_count == 0) {
+			ScheduleTick();
+		}
+	}
+
+	timer.m_wheel = nullptr;
+	timer.m_fn = nullptr;
+}
+
+void RdmaTimerWheel::Expire(RdmaTimer& timer)
+{
+	if (timer.m_level == eventLevel) {
+		timer.m_event = EventId();
+		Unlink(timer, m_eventTimers);
+	}
+	timer.m_wheel = nullptr;
+	m_stats.expirations++;
+
+	// The callback may re-arm the timer
+	std::function<void()> fn = std::move(timer.m_fn);
+	timer.m_fn = nullptr;
+	fn();
+}
+
+void RdmaTimerWheel::Link(RdmaTimer& timer)
+{
+	// The lowest level whose range covers the expiration
+	const uint64_t delta = timer.m_tick - m_now;
+	uint32_t level = 0;
+	while (level + 1 < levels && delta >> (levelBits * (level + 1))) {
+		level++;
+	}
+	// Beyond the range of the wheel, the timer is cascaded again until in range
+	const uint32_t slot = (timer.m_tick >> (levelBits * level)) & (slots - 1);
+
+	timer.m_level = level;
+	timer.m_slot = slot;
+	Link(timer, m_slots[level][slot]);
+	m_occupied[level][slot / 64] |= uint64_t{1} << (slot % 64);
+	m_count++;
+}
+
+void RdmaTimerWheel::Unlink(RdmaTimer& timer)
+{
+	RdmaTimer*& head = m_slots[timer.m_level][timer.m_slot];
+	Unlink(timer, head);
+	if (!head) {
+		m_occupied[timer.m_level][timer.m_slot / 64] &= ~(uint64_t{1} << (timer.m_slot % 64));
+	}
+	m_count--;
+}
+
+void RdmaTimerWheel::Link(RdmaTimer& timer, RdmaTimer*& head)
+{
+	timer.m_prev = nullptr;
+	timer.m_next = head;
+	if (head) {
+		head->m_prev = &timer;
+	}
+	head = &timer;
+}
+
+void RdmaTimerWheel::Unlink(RdmaTimer& timer, RdmaTimer*& head)
+{
+	if (timer.m_prev) {
+		timer.m_prev->m_next = timer.m_next;
+	}
+	else {
+		head = timer.m_next;
+	}
+	if (timer.m_next) {
+		timer.m_next->m_prev = timer.m_prev;
+	}
+	timer.m_prev = nullptr;
+	timer.m_next = nullptr;
+}
+
+RdmaTimer* RdmaTimerWheel::Detach(uint32_t level, uint32_t slot)
+{
+	RdmaTimer* list = m_slots[level][slot];
+	m_slots[level][slot] = nullptr;
+	m_occupied[level][slot / 64] &= ~(uint64_t{1} << (slot % 64));
+	for (RdmaTimer* t = list; t; t = t->m_next) {
+		m_count--;
+	}
+	return list;
+}
+
+void RdmaTimerWheel::Cascade(uint32_t level)
+{
+	const uint32_t slot = (m_now >> (levelBits * level)) & (slots - 1);
+	RdmaTimer* t = Detach(level, slot);
+	while (t) {
+		RdmaTimer* next = t->m_next;
+		Link(*t);
+		t = next;
+	}
+}
+
+uint64_t RdmaTimerWheel::NextTick() const
+{
+	uint64_t next = std::numeric_limits<uint64_t>::max();
+	for (uint32_t level = 0; level < levels; level++) {
+		const uint32_t shift = levelBits * level;
+		const uint32_t current = (m_now >> shift) & (slots - 1);
+		const uint64_t rotation = (m_now >> (shift + levelBits)) << (shift + levelBits);
+
+		// The slots after the current one are in this rotation, the others in the next one
+		const int slot = FindSlot(m_occupied[level], current + 1);
+		if (slot >= 0) {
+			next = std::min(next, rotation + (uint64_t(slot) << shift));
+		}
+		else if (FindSlot(m_occupied[level], 0) >= 0) {
+			next = std::min(next, rotation + (uint64_t{1} << (shift + levelBits)));
+		}
+	}
+	return next;
+}
+
+void RdmaTimerWheel::ScheduleTick()
+{
+	if (m_count == 0) {
+		CancelEvent(m_event);
+		return;
+	}
+
+	const uint64_t next = NextTick();
+	if (m_event.PeekEventImpl() && m_eventTick <= next) {
+		return;
+	}
+	CancelEvent(m_event);
+	m_eventTick = next;
+	m_event = ScheduleEvent(TimeStep(next * m_tick.GetTimeStep()), nullptr);
+}
+
+void RdmaTimerWheel::OnTick()
+{
+	m_event = EventId();
+	m_now = m_eventTick;
+
+	// Cascade the upper levels wrapping around, from the top, so that the timers reach their level
+	for (uint32_t level = levels - 1; level > 0; level--) {
+		if ((m_now & ((uint64_t{1} << (levelBits * level)) - 1)) == 0) {
+			Cascade(level);
+		}
+	}
+
+	for (RdmaTimer* t = Detach(0, m_now & (slots - 1)); t; t = t->m_next) {
+		NS_ASSERT(t->m_tick == m_now);
+		t->m_level = expiringLevel;
+		m_expiring.push_back(t);
+	}
+	std::sort(m_expiring.begin(), m_expiring.end(), [](const RdmaTimer* a, const RdmaTimer* b) {
+		return a->m_expiry < b->m_expiry || (a->m_expiry == b->m_expiry && a->m_seq < b->m_seq);
+	});
+
+	// A timer may cancel or re-arm the others
+	for (size_t i = 0; i < m_expiring.size(); i++) {
+		RdmaTimer* t = m_expiring[i];
+		if (t) {
+			t->m_level = 0;
+			m_expiring[i] = nullptr;
+			Expire(*t);
+		}
+	}
+	m_expiring.clear();
+
+	ScheduleTick();
+}
+
+EventId RdmaTimerWheel::ScheduleEvent(Time at, RdmaTimer* timer)
+{
+	m_stats.events++;
+	return Simulator::Schedule(at - Simulator::Now(), Create<Event>(this, timer));
+}
+
+} // namespace ns3
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <ns3/nstime.h>
+#include <ns3/event-id.h>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace ns3 {
+
+class RdmaTimerWheel;
+
+/**
+ * @brief Timer of a QP (retransmission timeout, delayed ACK, DCQCN), armed on the `RdmaTimerWheel` of its NIC.
+ *
+ * Arming an armed timer re-arms it. Cancelling or destroying the timer disarms it.
+ * A copy of a timer is not armed: the timer is bound to its owner.
+ */
+class RdmaTimer
+{
+public:
+	RdmaTimer() = default;
+	RdmaTimer(const RdmaTimer&) {}
+	RdmaTimer& operator=(const RdmaTimer&);
+	~RdmaTimer();
+
+	bool IsRunning() const { return m_wheel != nullptr; }
+
+	/**
+	 * @brief Disarm the timer, if armed.
+	 */
+	void Cancel();
+
+private:
+	friend class RdmaTimerWheel;
+
+	RdmaTimerWheel* m_wheel{nullptr}; //!< Set while armed.
+	std::function<void()> m_fn;
+	Time m_expiry{};
+	uint64_t m_seq{0}; //!< Order of arming.
+
+	EventId m_event; //!< If the wheel is disabled.
+
+	// List of the slot, or of the simulator events
+	RdmaTimer* m_prev{nullptr};
+	RdmaTimer* m_next{nullptr};
+	uint64_t m_tick{0};
+	uint32_t m_slot{0};
+	uint8_t m_level{0};
+};
+
+/**
+ * @brief Hierarchical timing wheel of a NIC, owning the timers of its QPs.
+ *
+ * Most of the timers of the QPs are re-armed or cancelled long before they expire
+ * (the retransmission timeout is re-armed by each ACK).
+ * As simulator events, each re-arm inserts an event in the scheduler, and the cancelled events stay
+ * in the scheduler until their expiration, so the scheduler grows with the count of QPs and of ACKs.
+ *
+ * On the wheel, arming and cancelling a timer only links or unlinks it from a slot.
+ * The wheel has `levels` levels of `slots` slots, the level `k` covering `slots^(k+1)` ticks,
+ * and the timers of an upper level are cascaded down when the lower level wraps around.
+ * The wheel schedules one simulator event at a time: at the next tick having timers, or at the next wrap around.
+ *
+ * The timers expire at the end of the tick of their expiration time, so up to one tick late.
+ * A timer expiring in the current tick, as with a zero delay, fires at the next one.
+ * The timers expiring in the same tick fire in the order of their expiration time, then of arming.
+ *
+ * If the tick is zero, the wheel is disabled and each timer is a simulator event, with the exact expiration time.
+ */
+class RdmaTimerWheel
+{
+public:
+	static constexpr uint32_t levelBits = 8;
+	static constexpr uint32_t slots = 1u << levelBits;
+	static constexpr uint32_t levels = 4;
+
+	/**
+	 * @brief Counters of this wheel.
+	 * Only what goes through the wheel is counted: the events that the timers would schedule
+	 * without the wheel are not, so these counters do not measure the events saved by the wheel.
+	 */
+	struct Stats
+	{
+		uint64_t arms{};       //!< Timers armed or re-armed.
+		uint64_t cancels{};    //!< Timers disarmed before expiring, including by a re-arm.
+		uint64_t expirations{};
+		uint64_t events{};     //!< Simulator events scheduled for the timers, or for the ticks of the wheel.
+	};
+
+	/**
+	 * @brief Counters of the simulator events scheduled by all the wheels (see `Stats::events`).
+	 * An event is counted until removed from the scheduler, cancelled or not.
+	 */
+	struct SchedulerStats
+	{
+		uint64_t pending{};
+		uint64_t maxPending{};
+	};
+
+	RdmaTimerWheel() = default;
+	RdmaTimerWheel(const RdmaTimerWheel&) = delete;
+	RdmaTimerWheel& operator=(const RdmaTimerWheel&) = delete;
+	~RdmaTimerWheel();
+
+	/**
+	 * @param tick Resolution of the wheel. Zero to disable the wheel.
+	 */
+	void Configure(Time tick);
+
+	bool IsEnabled() const { return !m_tick.IsZero(); }
+
+	/**
+	 * @brief Arm the timer to call `fn` after `delay`.
+	 * The timer is re-armed if already armed, and `fn` replaces the previous callback.
+	 */
+	void Schedule(RdmaTimer& timer, Time delay, std::function<void()> fn);
+
+	/**
+	 * @brief Disarm all the timers.
+	 */
+	void Clear();
+
+	const Stats& GetStats() const { return m_stats; }
+	static const SchedulerStats& GetSchedulerStats() { return s_sched; }
+
+private:
+	friend class RdmaTimer;
+	class Event;
+
+	void Cancel(RdmaTimer& timer);
+	void Expire(RdmaTimer& timer);
+
+	void Link(RdmaTimer& timer); //!< Link to the slot of its tick.
+	void Unlink(RdmaTimer& timer);
+	static void Link(RdmaTimer& timer, RdmaTimer*& head);
+	static void Unlink(RdmaTimer& timer, RdmaTimer*& head);
+	RdmaTimer* Detach(uint32_t level, uint32_t slot); //!< Empty the slot, and return its list.
+	void Cascade(uint32_t level);
+
+	/**
+	 * @brief Schedule the simulator event of the next tick having timers, if before the scheduled one.
+	 */
+	void ScheduleTick();
+	void OnTick();
+	uint64_t NextTick() const;
+
+	EventId ScheduleEvent(Time at, RdmaTimer* timer);
+
+	Time m_tick{};
+	uint64_t m_now{0}; //!< Last tick processed.
+	uint64_t m_count{0}; //!< Timers linked.
+	std::array<std::array<RdmaTimer*, slots>, levels> m_slots{};
+	std::array<std::array<uint64_t, slots / 64>, levels> m_occupied{}; //!< Bitmap of the non-empty slots.
+
+	uint64_t m_seq{0};
+	RdmaTimer* m_eventTimers{nullptr}; //!< Timers scheduled as simulator events, if the wheel is disabled.
+	std::vector<RdmaTimer*> m_expiring; //!< Timers of the current tick, null once fired or cancelled.
+
+	EventId m_event; //!< Event of the next tick, null if none.
+	uint64_t m_eventTick{0};
+
+	Stats m_stats{};
+	static SchedulerStats s_sched;
+};
+
+} // namespace ns3
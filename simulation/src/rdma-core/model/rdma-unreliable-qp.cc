@@ -2,6 +2,7 @@
 #include "ns3/rdma-helper.h"
 #include "ns3/qbb-net-device.h"
 #include "ns3/rdma-bth.h"
+#include "ns3/packet-meta-tag.h"
 #include "ns3/rdma-seq-header.h"
 #include "ns3/cn-header.h"
 #include "ns3/ppp-header.h"
@@ -15,12 +16,11 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE("RdmaUnreliableQP");
 
-void RdmaUnreliableSQ::PostSend(RdmaTxQueuePair::SendRequest sr)
+void RdmaUnreliableSQ::PushSendRequest(SendRequest&& sr)
 {
   	NS_LOG_FUNCTION(this);
 
-	m_to_send.push(std::move(sr));	
-	TriggerDevTransmit();
+	m_to_send.push_back(std::move(sr));
 }
 
 bool RdmaUnreliableSQ::HasDataToSend() const
@@ -45,73 +45,55 @@ Ptr<Packet> RdmaUnreliableSQ::GetNextPacket()
   	NS_LOG_FUNCTION(this);
 	NS_ABORT_IF(m_to_send.empty());
 	
-	SendRequest sr = m_to_send.front();
+	// The request is not copied: only the fields needed for this packet are read
+	SendRequest& sr = m_to_send.front();
+	const Ipv4Address dip = sr.dip;
+	const uint16_t dport = sr.dport;
+	uint32_t payload_size = sr.payload_size;
 
 	RdmaBTH bth;
 	bth.SetReliable(false);
 	bth.SetAckReq(false);
 	bth.SetMulticast(sr.multicast);
-	bth.SetDestQpKey(sr.dport);
+	bth.SetDestQpn(sr.dqpn);
+	bth.SetSrcQpn(m_qpn);
+	bth.SetFlowKey(MakeEcmpFlowKey(m_sip.Get(), dip.Get(), m_sport, dport));
 	bth.SetNotif(true);
 	bth.SetImm(sr.imm);
 
 	// Split big RDMA Write in MTU-Sized packets.
-	if(sr.payload_size > m_mtu) {
-		sr.payload_size = m_mtu;
-		m_to_send.front().payload_size -= m_mtu;
+	if(payload_size > m_mtu) {
+		payload_size = m_mtu;
+		sr.payload_size -= m_mtu;
 
 		// Do not notify, RDMA Write is fragmented in multiple packets.
 		bth.SetNotif(false);
 	}
 	else {
 		// RDMA Write is complete.
-		m_to_send.pop();
+		OnSendCallback on_send = std::move(sr.on_send);
+		m_to_send.pop_front();
 
 		// There is no ACK with unreliable QPs.
 		// The notification on the sender side is when the packet is sent, and we don't care if the RX receives it.
 		// In fact, the packet still neds to be transmited, but maybe it is enough to call it here.
-		if(sr.on_send) {
-			sr.on_send();
+		if(on_send) {
+			on_send();
 		}
 	}
 	
-	Ptr<Packet> p = Create<Packet>(sr.payload_size);
-	
-	// Add RdmaSeqHeader
-	RdmaSeqHeader seqTs;
-	seqTs.SetSeq(m_snd_nxt);
-	seqTs.SetPG(m_pg);
-	p->AddHeader(seqTs);
-	
-	// Add UDP header
-	UdpHeader udpHeader;
-	udpHeader.SetDestinationPort(sr.dport);
-	udpHeader.SetSourcePort(m_sport);
-	p->AddHeader(udpHeader);
-
-	// Add IPv4 header
-	Ipv4Header ipHeader;
-	ipHeader.SetSource(m_sip);
-	ipHeader.SetDestination(sr.dip);
-	ipHeader.SetProtocol(0x11);
-	ipHeader.SetPayloadSize(p->GetSize());
-	ipHeader.SetTtl(64);
-	ipHeader.SetTos(0);
-	ipHeader.SetIdentification(m_ipid);
-	p->AddHeader(ipHeader);
-
-	// Add PPP header
-	PppHeader ppp;
-	ppp.SetProtocol(0x0021); // EtherToPpp(0x800), see point-to-point-net-device.cc
-	p->AddHeader(ppp);
+	Ptr<Packet> p = GetPacketTemplate().MakeData(dip, dport, m_snd_nxt, m_ipid, payload_size);
 
 	// Add BTH header
 	p->AddPacketTag(bth);
 
+	PacketMetaTag meta(0x11, m_sip.Get(), dip.Get(), m_sport, dport, m_pg);
+	p->AddPacketTag(meta);
+
 	NS_LOG_LOGIC("Send (psn, ipid) =(" << m_snd_nxt << ", " << m_ipid << ")	");
 
 	// Update state
-	m_snd_nxt += sr.payload_size;
+	m_snd_nxt += payload_size;
 
 	// Wraps around
 	m_ipid = wrapped_increment(m_ipid);
@@ -150,12 +132,12 @@ void RdmaUnreliableRQ::ReceiveUdp(Ptr<Packet> p, const CustomHeader &ch)
 #if 0
 	if(ecnbits == Ipv4Header::ECN_CE && Simulator::Now() >= m_ecn_next_avail) {
 		m_ecn_next_avail = Simulator::Now() + m_ecn_delay;
-		SendEcn(ch);
+		SendEcn(ch, bth.GetSrcQpn());
 	}
 #endif
 }
 
-void RdmaUnreliableRQ::SendEcn(const CustomHeader& recv)
+void RdmaUnreliableRQ::SendEcn(const CustomHeader& recv, uint32_t dqpn)
 {
 	NS_LOG_FUNCTION(this);
 
@@ -191,7 +173,8 @@ void RdmaUnreliableRQ::SendEcn(const CustomHeader& recv)
 	newp->AddHeader (ppp);
 
 	RdmaBTH bth;
-	bth.SetDestQpKey(recv.udp.sport);
+	bth.SetDestQpn(dqpn);
+	bth.SetSrcQpn(m_tx->GetQpn());
 	newp->AddPacketTag(bth);
 
 	// send
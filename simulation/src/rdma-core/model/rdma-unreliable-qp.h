@@ -1,7 +1,7 @@
 #pragma once
 
 #include <ns3/rdma-queue-pair.h>
-#include <queue>
+#include <deque>
 
 namespace ns3 {
 
@@ -10,10 +10,13 @@ class RdmaUnreliableSQ : public RdmaTxQueuePair
 public:
 	using RdmaTxQueuePair::RdmaTxQueuePair;
 
-	void PostSend(SendRequest sr) override;
 	bool IsReadyToSend() const override;
 	bool HasDataToSend() const override;
 	Ptr<Packet> GetNextPacket() override;
+	uint64_t GetNextPsn() const override { return m_snd_nxt; }
+
+protected:
+	void PushSendRequest(SendRequest&& sr) override;
 	
 private:
  	//!< IP packet header number, incremented by one on each packet.
@@ -22,7 +25,7 @@ private:
 	//!< RDMA packet header byte offset, incremented by the size of the payload on each packet.
 	uint64_t m_snd_nxt{0};
 	//!< Pending send requests.
-	std::queue<SendRequest> m_to_send;
+	std::deque<SendRequest> m_to_send;
 	
 	struct AckCallback
 	{
@@ -42,7 +45,7 @@ public:
 	void ReceiveUdp(Ptr<Packet> p, const CustomHeader &ch) override;
 
 private:
-	void SendEcn(const CustomHeader& recv);
+	void SendEcn(const CustomHeader& recv, uint32_t dqpn);
 
 private:
 	Time m_ecn_next_avail{Time(0)};
@@ -0,0 +1,48 @@
+#include "switch-ingress-tag.h"
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED(SwitchIngressTag);
+
+SwitchIngressTag::SwitchIngressTag(uint32_t inDev, uint32_t replica)
+	: m_inDev{inDev}, m_replica{replica}
+{
+}
+
+TypeId SwitchIngressTag::GetTypeId()
+{
+	static TypeId tid = TypeId("ns3::SwitchIngressTag")
+		.SetParent<Tag>()
+		.AddConstructor<SwitchIngressTag>()
+		;
+	return tid;
+}
+
+TypeId SwitchIngressTag::GetInstanceTypeId() const
+{
+	return GetTypeId();
+}
+
+void SwitchIngressTag::Print(std::ostream &os) const
+{
+	os << "inDev=" << m_inDev << " replica=" << m_replica;
+}
+
+uint32_t SwitchIngressTag::GetSerializedSize() const
+{
+	return 8;
+}
+
+void SwitchIngressTag::Serialize(TagBuffer start) const
+{
+	start.WriteU32(m_inDev);
+	start.WriteU32(m_replica);
+}
+
+void SwitchIngressTag::Deserialize(TagBuffer start)
+{
+	m_inDev = start.ReadU32();
+	m_replica = start.ReadU32();
+}
+
+}
@@ -0,0 +1,44 @@
+#ifndef SWITCH_INGRESS_TAG_H
+#define SWITCH_INGRESS_TAG_H
+
+#include <ns3/object.h>
+#include <ns3/tag.h>
+
+namespace ns3 {
+
+/**
+ * @brief Switch-local state of a packet between its reception and its transmission.
+ * 
+ * Added by the ingress port and removed by the egress port.
+ * Replaces the `FlowIdTag` so that the release of the ingress memory is carried with the packet,
+ * instead of being looked up in a map on each dequeue.
+ */
+class SwitchIngressTag : public Tag
+{
+public:
+	//! Replica reference of a packet that has a single copy in the switch.
+	static constexpr uint32_t NO_REPLICA{0};
+
+	SwitchIngressTag() = default;
+	explicit SwitchIngressTag(uint32_t inDev, uint32_t replica = NO_REPLICA);
+
+	static TypeId GetTypeId();
+	TypeId GetInstanceTypeId() const override;
+	void Print(std::ostream &os) const override;
+	uint32_t GetSerializedSize() const override;
+	void Serialize(TagBuffer start) const override;
+	void Deserialize(TagBuffer start) override;
+
+	uint32_t GetInDev() const { return m_inDev; }
+	void SetInDev(uint32_t inDev) { m_inDev = inDev; }
+	uint32_t GetReplica() const { return m_replica; }
+	void SetReplica(uint32_t replica) { m_replica = replica; }
+
+private:
+	uint32_t m_inDev{0}; //!< Ingress interface index.
+	uint32_t m_replica{NO_REPLICA}; //!< Reference count slot shared by the copies of a multicast packet.
+};
+
+}
+
+#endif /* SWITCH_INGRESS_TAG_H */
@@ -39,20 +39,24 @@ SwitchMmu::SwitchMmu()
 
 	// headroom
 	shared_used_bytes = 0;
-	memset(hdrm_bytes, 0, sizeof(hdrm_bytes));
-	memset(ingress_bytes, 0, sizeof(ingress_bytes));
-	memset(paused, 0, sizeof(paused));
-	memset(egress_bytes, 0, sizeof(egress_bytes));
+	total_hdrm = 0;
+	total_rsrv = 0;
+}
+
+uint32_t SwitchMmu::GetQueueIndex(uint32_t port, uint32_t qIndex) const
+{
+	NS_ASSERT(port < m_headroom.size() && qIndex < qCnt);
+	return port * qCnt + qIndex;
 }
 
 bool SwitchMmu::CheckIngressAdmission(uint32_t port, uint32_t qIndex, uint32_t psize)
 {
 	NS_LOG_FUNCTION(this << port << qIndex << psize);
 
-	if (psize + hdrm_bytes[port][qIndex] > headroom[port] && psize + GetSharedUsed(port, qIndex) > GetPfcThreshold(port)){
+	if (psize + m_hdrm_bytes[GetQueueIndex(port, qIndex)] > m_headroom[port] && psize + GetSharedUsed(port, qIndex) > GetPfcThreshold(port)){
 		printf("%lu %u Drop: queue:%u,%u: Headroom full\n", Simulator::Now().GetTimeStep(), node_id, port, qIndex);
-		for (uint32_t i = 1; i < 64; i++)
-			printf("(%u,%u)", hdrm_bytes[i][3], ingress_bytes[i][3]);
+		for (uint32_t i = 1; i < std::min<uint32_t>(64, GetNPorts()); i++)
+			printf("(%u,%u)", m_hdrm_bytes[GetQueueIndex(i, 3)], m_ingress_bytes[GetQueueIndex(i, 3)]);
 		printf("\n");
 		return false;
 	}
@@ -63,15 +67,17 @@ void SwitchMmu::UpdateIngressAdmission(uint32_t port, uint32_t qIndex, uint32_t
 {
 	NS_LOG_FUNCTION(this << port << qIndex << psize);
 
-	uint32_t new_bytes = ingress_bytes[port][qIndex] + psize;
+	const uint32_t q = GetQueueIndex(port, qIndex);
+
+	uint32_t new_bytes = m_ingress_bytes[q] + psize;
 	if (new_bytes <= reserve){
-		ingress_bytes[port][qIndex] += psize;
+		m_ingress_bytes[q] += psize;
 	}else {
 		uint32_t thresh = GetPfcThreshold(port);
 		if (new_bytes - reserve > thresh){
-			hdrm_bytes[port][qIndex] += psize;
+			m_hdrm_bytes[q] += psize;
 		}else {
-			ingress_bytes[port][qIndex] += psize;
+			m_ingress_bytes[q] += psize;
 			shared_used_bytes += std::min(psize, new_bytes - reserve);
 		}
 	}
@@ -80,46 +86,52 @@ void SwitchMmu::UpdateEgressAdmission(uint32_t port, uint32_t qIndex, uint32_t p
 {
 	NS_LOG_FUNCTION(this << port << qIndex << psize);
 
-	egress_bytes[port][qIndex] += psize;
+	m_egress_bytes[GetQueueIndex(port, qIndex)] += psize;
 }
 
 void SwitchMmu::RemoveFromIngressAdmission(uint32_t port, uint32_t qIndex, uint32_t psize)
 {
 	NS_LOG_FUNCTION(this << port << qIndex << psize);
 
-	uint32_t from_hdrm = std::min(hdrm_bytes[port][qIndex], psize);
+	const uint32_t q = GetQueueIndex(port, qIndex);
+	uint32_t& hdrm_bytes = m_hdrm_bytes[q];
+	uint32_t& ingress_bytes = m_ingress_bytes[q];
+
+	uint32_t from_hdrm = std::min(hdrm_bytes, psize);
 
 	NS_ABORT_IF(psize < from_hdrm);
 
-	uint32_t from_shared = std::min(psize - from_hdrm, ingress_bytes[port][qIndex] > reserve ? ingress_bytes[port][qIndex] - reserve : 0);
+	uint32_t from_shared = std::min(psize - from_hdrm, ingress_bytes > reserve ? ingress_bytes - reserve : 0);
 	
-	NS_ABORT_IF(hdrm_bytes[port][qIndex] < from_hdrm);
-	NS_ABORT_IF(ingress_bytes[port][qIndex] < psize - from_hdrm);
+	NS_ABORT_IF(hdrm_bytes < from_hdrm);
+	NS_ABORT_IF(ingress_bytes < psize - from_hdrm);
 	NS_ABORT_IF(shared_used_bytes < from_shared);
 
-	hdrm_bytes[port][qIndex] -= from_hdrm;
-	ingress_bytes[port][qIndex] -= psize - from_hdrm;
+	hdrm_bytes -= from_hdrm;
+	ingress_bytes -= psize - from_hdrm;
 	shared_used_bytes -= from_shared;
 }
 
 void SwitchMmu::RemoveFromEgressAdmission(uint32_t port, uint32_t qIndex, uint32_t psize)
 {
 	NS_LOG_FUNCTION(this << port << qIndex << psize);
-	egress_bytes[port][qIndex] -= psize;
+	m_egress_bytes[GetQueueIndex(port, qIndex)] -= psize;
 }
 
 bool SwitchMmu::CheckShouldPause(uint32_t port, uint32_t qIndex)
 {
 	NS_LOG_FUNCTION(this << port << qIndex);
 
-	if(paused[port][qIndex]) {
+	const uint32_t q = GetQueueIndex(port, qIndex);
+
+	if(m_paused[q]) {
 		return false;
 	}
 	
 	NS_LOG_DEBUG("usage: " << GetSharedUsed(port, qIndex)
 													<< "/" << GetPfcThreshold(port));
 
-	if(hdrm_bytes[port][qIndex] > 0) {
+	if(m_hdrm_bytes[q] > 0) {
 		NS_LOG_LOGIC("PFC headroom not empty");
 		return true;
 	}
@@ -133,19 +145,21 @@ bool SwitchMmu::CheckShouldPause(uint32_t port, uint32_t qIndex)
 }
 bool SwitchMmu::CheckShouldResume(uint32_t port, uint32_t qIndex)
 {
+	const uint32_t q = GetQueueIndex(port, qIndex);
+
 	NS_LOG_DEBUG("usage: " << GetSharedUsed(port, qIndex)
 													<< "/" << GetPfcThreshold(port));
 
-	if (!paused[port][qIndex])
+	if (!m_paused[q])
 		return false;
 	uint32_t shared_used = GetSharedUsed(port, qIndex);
-	return hdrm_bytes[port][qIndex] == 0 && (shared_used == 0 || shared_used + resume_offset <= GetPfcThreshold(port));
+	return m_hdrm_bytes[q] == 0 && (shared_used == 0 || shared_used + resume_offset <= GetPfcThreshold(port));
 }
 void SwitchMmu::SetPause(uint32_t port, uint32_t qIndex){
-	paused[port][qIndex] = true;
+	m_paused[GetQueueIndex(port, qIndex)] = true;
 }
 void SwitchMmu::SetResume(uint32_t port, uint32_t qIndex){
-	paused[port][qIndex] = false;
+	m_paused[GetQueueIndex(port, qIndex)] = false;
 }
 
 uint32_t SwitchMmu::GetPfcThreshold(uint32_t port) {
@@ -155,47 +169,78 @@ uint32_t SwitchMmu::GetPfcThreshold(uint32_t port) {
 		return 0;
 	}
 
-	return (m_buffer_size.GetValue() - total_hdrm - total_rsrv - shared_used_bytes) >> pfc_a_shift[port];
+	return (m_buffer_size.GetValue() - total_hdrm - total_rsrv - shared_used_bytes) >> m_pfc_a_shift[port];
 }
 uint32_t SwitchMmu::GetSharedUsed(uint32_t port, uint32_t qIndex){
-	uint32_t used = ingress_bytes[port][qIndex];
+	uint32_t used = m_ingress_bytes[GetQueueIndex(port, qIndex)];
 	return used > reserve ? used - reserve : 0;
 }
 bool SwitchMmu::ShouldSendCN(uint32_t ifindex, uint32_t qIndex)
 {
 	NS_LOG_FUNCTION(this);
 
+	const uint32_t egress_bytes = m_egress_bytes[GetQueueIndex(ifindex, qIndex)];
+	const uint32_t kmin = m_kmin[ifindex];
+	const uint32_t kmax = m_kmax[ifindex];
 	if (qIndex == 0) {
 		return false;
 	}
-	if (egress_bytes[ifindex][qIndex] > kmax[ifindex]) {
-		NS_LOG_LOGIC("ECN should send: " << egress_bytes[ifindex][qIndex] << "/" << kmin[ifindex]);
+	if (egress_bytes > kmax) {
+		NS_LOG_LOGIC("ECN should send: " << egress_bytes << "/" << kmin);
 		return true;
 	}
-	if (egress_bytes[ifindex][qIndex] > kmin[ifindex]) {
-		double p = pmax[ifindex] * double(egress_bytes[ifindex][qIndex] - kmin[ifindex]) / (kmax[ifindex] - kmin[ifindex]);
+	if (egress_bytes > kmin) {
+		double p = m_pmax[ifindex] * double(egress_bytes - kmin) / (kmax - kmin);
 		if (GenRandomDouble(0, 1) < p) {
-			NS_LOG_LOGIC("ECN should send: " << egress_bytes[ifindex][qIndex] << "/" << kmin[ifindex] << ", p=" << p);
+			NS_LOG_LOGIC("ECN should send: " << egress_bytes << "/" << kmin << ", p=" << p);
 			return true;
 		}
 	}
 	return false;
 }
-void SwitchMmu::ConfigEcn(uint32_t port, uint32_t _kmin, uint32_t _kmax, double _pmax){
-	kmin[port] = _kmin * 1000;
-	kmax[port] = _kmax * 1000;
-	pmax[port] = _pmax;
-}
-void SwitchMmu::ConfigHdrm(uint32_t port, uint32_t size){
-	headroom[port] = size;
-}
 void SwitchMmu::ConfigNPort(uint32_t n_port){
+	m_headroom.resize(n_port + 1);
+	m_pfc_a_shift.resize(n_port + 1);
+	m_kmin.resize(n_port + 1);
+	m_kmax.resize(n_port + 1);
+	m_pmax.resize(n_port + 1);
+	m_hdrm_bytes.resize((n_port + 1) * qCnt);
+	m_ingress_bytes.resize((n_port + 1) * qCnt);
+	m_egress_bytes.resize((n_port + 1) * qCnt);
+	m_paused.resize((n_port + 1) * qCnt);
 	total_hdrm = 0;
 	total_rsrv = 0;
 	for (uint32_t i = 1; i <= n_port; i++){
-		total_hdrm += headroom[i];
+		total_hdrm += m_headroom[i];
 		total_rsrv += reserve;
 	}
 }
+void SwitchMmu::ConfigEcn(uint32_t port, uint32_t _kmin, uint32_t _kmax, double _pmax){
+	NS_ASSERT(port < m_headroom.size());
+	m_kmin[port] = _kmin * 1000;
+	m_kmax[port] = _kmax * 1000;
+	m_pmax[port] = _pmax;
+}
+void SwitchMmu::ConfigHdrm(uint32_t port, uint32_t size){
+	NS_ASSERT(port < m_headroom.size());
+	if (port > 0) {
+		total_hdrm = total_hdrm - m_headroom[port] + size;
+	}
+	m_headroom[port] = size;
+}
+void SwitchMmu::ConfigPfcAlphaShift(uint32_t port, uint32_t shift){
+	NS_ASSERT(port < m_headroom.size());
+	m_pfc_a_shift[port] = shift;
+}
+
+uint32_t SwitchMmu::GetNPorts() const {
+	return m_headroom.size();
+}
+uint32_t SwitchMmu::GetIngressBytes(uint32_t port, uint32_t qIndex) const {
+	return m_ingress_bytes[GetQueueIndex(port, qIndex)];
+}
+uint32_t SwitchMmu::GetEgressBytes(uint32_t port, uint32_t qIndex) const {
+	return m_egress_bytes[GetQueueIndex(port, qIndex)];
+}
 
 }
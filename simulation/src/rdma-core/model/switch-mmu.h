@@ -2,6 +2,7 @@
 #define SWITCH_MMU_H
 
 #include <unordered_map>
+#include <vector>
 #include <ns3/node.h>
 #include <ns3/queue-size.h>
 
@@ -11,7 +12,6 @@ class Packet;
 
 class SwitchMmu: public Object{
 public:
-	static const uint32_t pCnt = 257;	// Number of ports used
 	static const uint32_t qCnt = 8;	// Number of queues/priorities used
 
 	static TypeId GetTypeId (void);
@@ -42,34 +42,61 @@ public:
 
 	bool ShouldSendCN(uint32_t ifindex, uint32_t qIndex);
 
+	/**
+	 * @brief Allocate the state for ports `[0, n_port]`.
+	 * 
+	 * Should be called before the other `Config*()` functions.
+	 * Port zero is the loopback device and is not counted in the totals.
+	 */
+	void ConfigNPort(uint32_t n_port);
 	void ConfigEcn(uint32_t port, uint32_t _kmin, uint32_t _kmax, double _pmax);
 	void ConfigHdrm(uint32_t port, uint32_t size);
-	void ConfigNPort(uint32_t n_port);
+	void ConfigPfcAlphaShift(uint32_t port, uint32_t shift);
+
+	uint32_t GetNPorts() const;
+	uint32_t GetIngressBytes(uint32_t port, uint32_t qIndex) const;
+	uint32_t GetEgressBytes(uint32_t port, uint32_t qIndex) const;
 
 	// config
 	uint32_t node_id;
-	uint32_t pfc_a_shift[pCnt];
 
 private:
+	/**
+	 * @return The index of the queue in the per-queue arrays.
+	 */
+	uint32_t GetQueueIndex(uint32_t port, uint32_t qIndex) const;
+
 	QueueSize m_buffer_size;
 
+	// One array per field, sized by `ConfigNPort()`.
+	// The queues of a port are contiguous, so one field of all the queues of a port is within one cache line.
+	/// @{
+	/// Per-port configuration, indexed by port.
+	std::vector<uint32_t> m_headroom;
+	std::vector<uint32_t> m_pfc_a_shift;
+	std::vector<uint32_t> m_kmin;
+	std::vector<uint32_t> m_kmax;
+	std::vector<double> m_pmax;
+	/// @}
+
+	/// @{
+	/// Runtime counters, indexed by `GetQueueIndex()`.
+	std::vector<uint32_t> m_hdrm_bytes;
+	std::vector<uint32_t> m_ingress_bytes;
+	std::vector<uint32_t> m_egress_bytes;
+	std::vector<uint8_t> m_paused;
+	/// @}
+
 public:
 
-	//! Bytes reserved in each `ingress_bytes[port][qIndex]`
+	//! Bytes reserved in each ingress queue.
 	uint32_t reserve;
-	uint32_t headroom[pCnt];
 	uint32_t resume_offset;
-	uint32_t kmin[pCnt], kmax[pCnt];
-	double pmax[pCnt];
 	uint32_t total_hdrm;
 	uint32_t total_rsrv;
 
 	// runtime
 	uint32_t shared_used_bytes;
-	uint32_t hdrm_bytes[pCnt][qCnt];
-	uint32_t ingress_bytes[pCnt][qCnt];
-	uint32_t paused[pCnt][qCnt];
-	uint32_t egress_bytes[pCnt][qCnt];
 };
 
 } /* namespace ns3 */
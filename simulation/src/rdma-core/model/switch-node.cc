@@ -2,13 +2,15 @@
 #include "ns3/packet.h"
 #include "ns3/ipv4-header.h"
 #include "ns3/pause-header.h"
-#include "ns3/flow-id-tag.h"
 #include "ns3/boolean.h"
 #include "ns3/uinteger.h"
 #include "ns3/double.h"
 #include "switch-node.h"
 #include "qbb-net-device.h"
 #include "rdma-bth.h"
+#include "switch-ingress-tag.h"
+#include "packet-meta-tag.h"
+#include "int-tag.h"
 #include "ns3/rdma-random.h"
 #include "ns3/ppp-header.h"
 #include "ns3/int-header.h"
@@ -47,55 +49,139 @@ TypeId SwitchNode::GetTypeId (void)
 	.AddAttribute("MaxRtt",
 			"Max Rtt of the network",
 			UintegerValue(9000),
-			MakeUintegerAccessor(&SwitchNode::m_maxRtt),
+			MakeUintegerAccessor(&SwitchNode::SetMaxRtt, &SwitchNode::GetMaxRtt),
 			MakeUintegerChecker<uint32_t>())
   ;
   return tid;
 }
 
-SwitchNode::SwitchNode(){
+SwitchNode::SwitchNode()
+	: SwitchNode(0)
+{
+}
+
+SwitchNode::SwitchNode(uint32_t systemId)
+	: Node(systemId)
+{
 	static std::atomic<uint32_t> nextEcmpSeed(1);
 	m_ecmpSeed = nextEcmpSeed++;
 	m_mmu = CreateObject<SwitchMmu>();
-	for (uint32_t i = 0; i < pCnt; i++)
-		for (uint32_t j = 0; j < pCnt; j++)
-			for (uint32_t k = 0; k < qCnt; k++)
-				m_bytes[i][j][k] = 0;
-	for (uint32_t i = 0; i < pCnt; i++)
-		m_txBytes[i] = 0;
-	for (uint32_t i = 0; i < pCnt; i++)
-		m_lastPktSize[i] = m_lastPktTs[i] = 0;
-	for (uint32_t i = 0; i < pCnt; i++)
-		m_u[i] = 0;
 }
 
-int SwitchNode::GetOutDev(Ptr<const Packet> p, CustomHeader &ch){
-	// look up entries
-	auto entry = m_rtTable.find(ch.dip);
+void SwitchNode::ResizePorts()
+{
+	const uint32_t n{GetNDevices()};
+	m_ports.assign(n, nullptr);
+	for (uint32_t i = 0; i < n; i++){
+		m_ports[i] = PeekPointer(DynamicCast<QbbNetDevice>(GetDevice(i)));
+	}
+	m_txBytes.resize(n);
+	m_lastPktSize.resize(n);
+	m_lastPktTs.resize(n);
+	m_u.resize(n);
+	UpdatePintTerms();
+}
+
+void SwitchNode::SetMaxRtt(uint64_t maxRtt)
+{
+	m_maxRtt = maxRtt;
+	UpdatePintTerms();
+}
+
+uint64_t SwitchNode::GetMaxRtt() const
+{
+	return m_maxRtt;
+}
+
+void SwitchNode::UpdatePintTerms()
+{
+	const uint32_t n = m_ports.size();
+	m_pint.assign(n, PintPort{});
+	for (uint32_t i = 0; i < n; i++){
+		QbbNetDevice* dev = m_ports[i];
+		if (!dev || m_maxRtt == 0)
+			continue;
+		const double fct = 1 << Pint::lut_shift;
+		const double log_T = log2(m_maxRtt) * fct;
+		const double log_B = log2(dev->GetDataRate().GetBitRate() / 8) * fct; // Bps
+		const double log_1e9 = log2(1e9) * fct;
+		m_pint[i].qterm = round(log_1e9 - log_B - 2*log_T);
+		m_pint[i].byteTerm = round(log_1e9 - log_B - log_T);
+		m_pint[i].uTerm = round(-log_T);
+	}
+}
 
-	// no matching entry
-	if (entry == m_rtTable.end())
-		return -1;
+EcmpFlowKey SwitchNode::GetFlowKey(const CustomHeader& ch){
+	uint16_t sport = 0, dport = 0;
+	if (ch.l3Prot == 0x6) {
+		sport = ch.tcp.sport;
+		dport = ch.tcp.dport;
+	}
+	else if (ch.l3Prot == 0x11) {
+		sport = ch.udp.sport;
+		dport = ch.udp.dport;
+	}
+	else if (ch.l3Prot == 0xFC || ch.l3Prot == 0xFD) {
+		sport = ch.ack.sport;
+		dport = ch.ack.dport;
+	}
+	return MakeEcmpFlowKey(ch.sip, ch.dip, sport, dport);
+}
 
-	// entry found
-	auto &nexthops = entry->second;
+int SwitchNode::GetOutDev(CustomHeader &ch, const EcmpFlowKey& key){
+	if (m_fibDirty) {
+		CompileFib();
+	}
+
+	// look up entries
+	const std::vector<int>* nexthops;
+	node_id_t dst;
+	if (IpToNodeId(ch.dip, dst)) {
+		if (dst >= m_fib.size() || m_fib[dst] == NO_ROUTE)
+			return -1;
+		nexthops = &m_ecmpGroups[m_fib[dst]];
+	}
+	else {
+		auto entry = m_rtTable.find(ch.dip);
+		if (entry == m_rtTable.end())
+			return -1;
+		nexthops = &entry->second;
+	}
 
 	// pick one next hop based on hash
-	union {
-		uint8_t u8[4+4+2+2];
-		uint32_t u32[3];
-	} buf;
-	buf.u32[0] = ch.sip;
-	buf.u32[1] = ch.dip;
-	if (ch.l3Prot == 0x6)
-		buf.u32[2] = ch.tcp.sport | ((uint32_t)ch.tcp.dport << 16);
-	else if (ch.l3Prot == 0x11)
-		buf.u32[2] = ch.udp.sport | ((uint32_t)ch.udp.dport << 16);
-	else if (ch.l3Prot == 0xFC || ch.l3Prot == 0xFD)
-		buf.u32[2] = ch.ack.sport | ((uint32_t)ch.ack.dport << 16);
-
-	uint32_t idx = EcmpHash(buf.u8, 12, m_ecmpSeed) % nexthops.size();
-	return nexthops[idx];
+	if (nexthops->size() == 1)
+		return (*nexthops)[0];
+	uint32_t idx = EcmpHashFinish(key, m_ecmpSeed) % nexthops->size();
+	return (*nexthops)[idx];
+}
+
+void SwitchNode::CompileFib(){
+	m_fib.clear();
+	m_ecmpGroups.clear();
+
+	std::map<std::vector<int>, uint32_t> groups;
+
+	for (const auto& [dip, nexthops] : m_rtTable) {
+		node_id_t dst;
+		if (!IpToNodeId(dip, dst)) {
+			continue;
+		}
+
+		auto [it, inserted] = groups.emplace(nexthops, m_ecmpGroups.size());
+		if (inserted) {
+			m_ecmpGroups.push_back(nexthops);
+		}
+
+		if (m_fib.size() <= dst) {
+			m_fib.resize(dst + 1, NO_ROUTE);
+		}
+		m_fib[dst] = it->second;
+	}
+
+	m_fibDirty = false;
+
+	NS_LOG_LOGIC("Switch " << GetId() << " compiled " << m_rtTable.size()
+		<< " routes into " << m_ecmpGroups.size() << " ECMP groups");
 }
 
 void SwitchNode::OnPeerJoinGroup(uint32_t ifIndex, uint32_t group)
@@ -119,25 +205,25 @@ void SwitchNode::OnPeerJoinGroup(uint32_t ifIndex, uint32_t group)
 }
 
 void SwitchNode::CheckAndSendPfc(uint32_t inDev, uint32_t qIndex){
-	Ptr<QbbNetDevice> device = DynamicCast<QbbNetDevice>(GetDevice(inDev));
+	QbbNetDevice* device = m_ports[inDev];
 	if (m_mmu->CheckShouldPause(inDev, qIndex)){
 		device->SendPfc(qIndex, 0);
 		m_mmu->SetPause(inDev, qIndex);
 	}
 }
 void SwitchNode::CheckAndSendResume(uint32_t inDev, uint32_t qIndex){
-	Ptr<QbbNetDevice> device = DynamicCast<QbbNetDevice>(GetDevice(inDev));
+	QbbNetDevice* device = m_ports[inDev];
 	if (m_mmu->CheckShouldResume(inDev, qIndex)){
 		device->SendPfc(qIndex, 1);
 		m_mmu->SetResume(inDev, qIndex);
 	}
 }
 
-void SwitchNode::SendMultiToDevs(Ptr<Packet> packet, CustomHeader& ch, int in_iface) {
+void SwitchNode::SendMultiToDevs(Ptr<Packet> packet, CustomHeader& ch, int in_iface, const EcmpFlowKey& key) {
 	
-	FlowIdTag t;
+	SwitchIngressTag t;
 	packet->PeekPacketTag(t);
-	const uint32_t inDev{t.GetFlowId()};
+	const uint32_t inDev{t.GetInDev()};
 	const uint32_t psize{packet->GetSize()};
 
 	// Determine the qIndex
@@ -177,26 +263,11 @@ void SwitchNode::SendMultiToDevs(Ptr<Packet> packet, CustomHeader& ch, int in_if
 	iface_id_t uplink_elected{};
 	if(!uplink_candidates.empty()) {
 		// pick one next hop based on hash
-		union {
-			uint8_t u8[4+4+2+2];
-			uint32_t u32[3];
-		} buf;
-		buf.u32[0] = ch.sip;
-		buf.u32[1] = ch.dip;
-		if (ch.l3Prot == 0x6)
-			buf.u32[2] = ch.tcp.sport | ((uint32_t)ch.tcp.dport << 16);
-		else if (ch.l3Prot == 0x11)
-			buf.u32[2] = ch.udp.sport | ((uint32_t)ch.udp.dport << 16);
-		else if (ch.l3Prot == 0xFC || ch.l3Prot == 0xFD)
-			buf.u32[2] = ch.ack.sport | ((uint32_t)ch.ack.dport << 16);
-
-		uint32_t hash = EcmpHash(buf.u8, 12, m_ecmpSeed);
+		uint32_t hash = EcmpHashFinish(key, m_ecmpSeed);
 		uplink_elected = uplink_candidates[hash % uplink_candidates.size()];
 	}
 
-	std::vector<std::pair<int, Ptr<Packet>>> tosend;
-	
-	auto x = std::make_shared<int>(0);
+	std::vector<int> odevs;
 
 	for(int idx : iface_it->second) {
 
@@ -208,16 +279,29 @@ void SwitchNode::SendMultiToDevs(Ptr<Packet> packet, CustomHeader& ch, int in_if
 			continue;
 		}
 
-		NS_ASSERT_MSG(GetDevice(idx)->IsLinkUp(), "The routing table look up should return link that is up");
+		NS_ASSERT_MSG(m_ports[idx]->IsLinkUp(), "The routing table look up should return link that is up");
+		odevs.push_back(idx);
+	}
 
-		Ptr<Packet> p = packet->Copy();
+	if(odevs.empty()) {
+		m_mmu->RemoveFromIngressAdmission(inDev, qIndex, psize);
+		NS_LOG_LOGIC("Drop: no output port for multicast group " << ch.dip);
+		return;
+	}
+
+	// The copies are not duplicated: each egress queue references the same packet,
+	// and the queue itself is the per-copy state. The tag is shared by all copies,
+	// so it holds the common reference count. A copy is only duplicated when it is modified (see `SwitchNotifyDequeue()`).
+	if (qIndex != 0 && odevs.size() > 1) {
+		t.SetReplica(AllocReplica(odevs.size()));
+		packet->ReplacePacketTag(t);
+	}
+
+	for(int idx : odevs) {
 
 		// Admission control
 		if (qIndex != 0) {
-			++(*x);
-			m_egress_lasts[p] = x;
 			m_mmu->UpdateEgressAdmission(idx, qIndex, psize);
-			m_bytes[inDev][idx][qIndex] += psize;
 		}
 
 		// TODO: now we increase the input interface buffer usage for each output device in the routing table of the multicast destination
@@ -225,24 +309,21 @@ void SwitchNode::SendMultiToDevs(Ptr<Packet> packet, CustomHeader& ch, int in_if
 		// This is easy to do like here, but maybe it changes behaviour when the buffer is almost at full capacity, because the buffer full capacity is triggered earlier than what it should.
 		// See `SwitchNotifyDequeue::RemoveFromIngressAdmission()`
 		// We need to keep trace of the output packet because increasing only once would do an integer underflow resulting in buffer usage of 4 billion....
-		
-
-		tosend.emplace_back(idx, p);
 	}
 	
 	if(qIndex != 0) {
 		CheckAndSendPfc(inDev, qIndex);
 	}
 
-	for(const auto& [idx, p] : tosend) {
-		SwitchSend(GetDevice(idx), qIndex, p);
+	for(int idx : odevs) {
+		m_ports[idx]->SwitchSend(qIndex, packet);
 	}
 }
 
-void SwitchNode::SendToDev(Ptr<Packet>p, CustomHeader &ch){
-	int idx = GetOutDev(p, ch);
+void SwitchNode::SendToDev(Ptr<Packet>p, CustomHeader &ch, const EcmpFlowKey& key){
+	int idx = GetOutDev(ch, key);
 	if (idx >= 0){
-		NS_ASSERT_MSG(GetDevice(idx)->IsLinkUp(), "The routing table look up should return link that is up");
+		NS_ASSERT_MSG(m_ports[idx]->IsLinkUp(), "The routing table look up should return link that is up");
 
 		// determine the qIndex
 		uint32_t qIndex;
@@ -253,16 +334,12 @@ void SwitchNode::SendToDev(Ptr<Packet>p, CustomHeader &ch){
 		}
 
 		// admission control
-		FlowIdTag t;
+		SwitchIngressTag t;
 		p->PeekPacketTag(t);
-		uint32_t inDev = t.GetFlowId();
+		uint32_t inDev = t.GetInDev();
 		if (qIndex != 0) { //not highest priority
 			if (m_mmu->CheckIngressAdmission(inDev, qIndex, p->GetSize())){			// Admission control
 				m_mmu->UpdateIngressAdmission(inDev, qIndex, p->GetSize());
-				
-				auto x = std::make_shared<int>(1);
-				m_egress_lasts[p] = x;
-
 				m_mmu->UpdateEgressAdmission(idx, qIndex, p->GetSize());
 			}else{
 				NS_LOG_LOGIC("Drop: unicast packet not admitted");
@@ -271,50 +348,45 @@ void SwitchNode::SendToDev(Ptr<Packet>p, CustomHeader &ch){
 			CheckAndSendPfc(inDev, qIndex);
 		}
 
-		m_bytes[inDev][idx][qIndex] += p->GetSize();
-		SwitchSend(GetDevice(idx), qIndex, p);
+		m_ports[idx]->SwitchSend(qIndex, p);
 	}else {
 		NS_LOG_LOGIC("Drop: cannot find output device for packet");
 		return;
 	}
 }
 
-uint32_t SwitchNode::EcmpHash(const uint8_t* key, size_t len, uint32_t seed) {
-  uint32_t h = seed;
-  if (len > 3) {
-    const uint32_t* key_x4 = (const uint32_t*) key;
-    size_t i = len >> 2;
-    do {
-      uint32_t k = *key_x4++;
-      k *= 0xcc9e2d51;
-      k = (k << 15) | (k >> 17);
-      k *= 0x1b873593;
-      h ^= k;
-      h = (h << 13) | (h >> 19);
-      h += (h << 2) + 0xe6546b64;
-    } while (--i);
-    key = (const uint8_t*) key_x4;
-  }
-  if (len & 3) {
-    size_t i = len & 3;
-    uint32_t k = 0;
-    key = &key[i - 1];
-    do {
-      k <<= 8;
-      k |= *key--;
-    } while (--i);
-    k *= 0xcc9e2d51;
-    k = (k << 15) | (k >> 17);
-    k *= 0x1b873593;
-    h ^= k;
-  }
-  h ^= len;
-  h ^= h >> 16;
-  h *= 0x85ebca6b;
-  h ^= h >> 13;
-  h *= 0xc2b2ae35;
-  h ^= h >> 16;
-  return h;
+uint32_t SwitchNode::AllocReplica(uint32_t count)
+{
+	NS_ASSERT(count > 0);
+
+	uint32_t replica;
+	if (m_replicaFree.empty()) {
+		replica = m_replicaRefs.size();
+		m_replicaRefs.push_back(count);
+	}
+	else {
+		replica = m_replicaFree.back();
+		m_replicaFree.pop_back();
+		m_replicaRefs[replica] = count;
+	}
+	return replica;
+}
+
+/**
+ * @return `true` when `replica` was the last copy of its packet.
+ */
+bool SwitchNode::ReleaseReplica(uint32_t replica)
+{
+	if (replica == SwitchIngressTag::NO_REPLICA) {
+		return true;
+	}
+
+	NS_ASSERT(m_replicaRefs.at(replica) > 0);
+	if (--m_replicaRefs[replica] > 0) {
+		return false;
+	}
+	m_replicaFree.push_back(replica);
+	return true;
 }
 
 void SwitchNode::SetEcmpSeed(uint32_t seed){
@@ -328,183 +400,133 @@ void SwitchNode::AddTableEntry(Ipv4Address &dstAddr, uint32_t intf_idx){
 	
 	uint32_t dip = dstAddr.Get();
 	m_rtTable[dip].push_back(intf_idx);
+	m_fibDirty = true;
 }
 
 void SwitchNode::ClearTable(){
 	m_rtTable.clear();
+	m_fibDirty = true;
 }
 
 // This function can only be called in switch mode
 bool SwitchNode::SwitchReceiveFromDevice(Ptr<NetDevice> device, Ptr<Packet> packet, CustomHeader &ch){
 	bool multicast = false;
+	EcmpFlowKey key;
 	{
 		RdmaBTH bth;
-		if(packet->PeekPacketTag(bth)) {
+		const bool has_bth = packet->PeekPacketTag(bth);
+		if(has_bth) {
 			multicast = bth.GetMulticast();
 		}
+		// The sender caches the flow key, so transit switches do not rebuild it
+		key = (has_bth && bth.HasFlowKey()) ? bth.GetFlowKey() : GetFlowKey(ch);
 	}
 
 	if(multicast) {
-		SendMultiToDevs(packet, ch, device->GetIfIndex());
+		SendMultiToDevs(packet, ch, device->GetIfIndex(), key);
 	}
 	else {
-		SendToDev(packet, ch);
+		SendToDev(packet, ch, key);
 	}
 
 	return true;
 }
 
-void SwitchNode::SwitchNotifyDequeue(uint32_t ifIndex, uint32_t qIndex, Ptr<Packet> p){
-	FlowIdTag t;
+void SwitchNode::SwitchNotifyDequeue(uint32_t ifIndex, uint32_t qIndex, Ptr<Packet>& p){
+	SwitchIngressTag t;
 	p->PeekPacketTag(t);
 	if (qIndex != 0){
-		uint32_t inDev = t.GetFlowId();
-
-		{
-			// Last packet of the mcast (or unicast), remove from ingress port
-			auto x = m_egress_lasts.at(p);
-			--(*x);
-			if(*x == 0) {
-				m_mmu->RemoveFromIngressAdmission(inDev, qIndex, p->GetSize());
-			}
-			m_egress_lasts.erase(p);
+		uint32_t inDev = t.GetInDev();
+		bool shared = (t.GetReplica() != SwitchIngressTag::NO_REPLICA);
+
+		// Last packet of the mcast (or unicast), remove from ingress port
+		if (ReleaseReplica(t.GetReplica())) {
+			m_mmu->RemoveFromIngressAdmission(inDev, qIndex, p->GetSize());
 		}
 
-		// std::cout << m_egress_lasts.size()<< "/" << m_bytes[inDev][ifIndex][qIndex] << std::endl;
 		m_mmu->RemoveFromEgressAdmission(ifIndex, qIndex, p->GetSize());
-		m_bytes[inDev][ifIndex][qIndex] -= p->GetSize();
 		if (m_ecnEnabled){
 			bool egressCongested = m_mmu->ShouldSendCN(ifIndex, qIndex);
 			if (egressCongested) {
 				NS_LOG_DEBUG("Switch marks CE");
-				PppHeader ppp;
-				Ipv4Header h;
-				p->RemoveHeader(ppp);
-				p->RemoveHeader(h);
-				h.SetEcn((Ipv4Header::EcnType)0x03);
-				p->AddHeader(h);
-				p->AddHeader(ppp);
+				if (shared) { // copy-on-write
+					p = p->Copy();
+					shared = false;
+				}
+				PacketMetaTag::MarkCe(p);
 			}
 		}
+		if ((m_ccMode == 3 || m_ccMode == 10) && IsUdp(p)){
+			if (shared) { // copy-on-write
+				p = p->Copy();
+			}
+			PushInt(ifIndex, p);
+		}
 		//CheckAndSendPfc(inDev, qIndex);
 		CheckAndSendResume(inDev, qIndex);
 	}
 
-	NS_ABORT_IF(m_ccMode == 3 || m_ccMode == 10);
-	#if 0 // A lot of invalid code in ns3.19
-	      // Simpler to remove: it does only concern only HPCC and HPCC-PINT congestion control.
-	if (1){
-		uint8_t* buf = p->GetBuffer();
-		if (buf[PppHeader::GetStaticSize() + 9] == 0x11){ // udp packet
-			IntHeader *ih = (IntHeader*)&buf[PppHeader::GetStaticSize() + 20 + 8 + 6]; // ppp, ip, udp, SeqTs, INT
-			Ptr<QbbNetDevice> dev = DynamicCast<QbbNetDevice>(GetDevice(ifIndex));
-			if (m_ccMode == 3){ // HPCC
-				ih->PushHop(Simulator::Now().GetTimeStep(), m_txBytes[ifIndex], dev->GetQueue()->GetNBytesTotal(), dev->GetDataRate().GetBitRate());
-			}else if (m_ccMode == 10){ // HPCC-PINT
-				uint64_t t = Simulator::Now().GetTimeStep();
-				uint64_t dt = t - m_lastPktTs[ifIndex];
-				if (dt > m_maxRtt)
-					dt = m_maxRtt;
-				uint64_t B = dev->GetDataRate().GetBitRate() / 8; //Bps
-				uint64_t qlen = dev->GetQueue()->GetNBytesTotal();
-				double newU;
-
-				/**************************
-				 * approximate calc
-				 *************************/
-				int b = 20, m = 16, l = 20; // see log2apprx's paremeters
-				int sft = logres_shift(b,l);
-				double fct = 1<<sft; // (multiplication factor corresponding to sft)
-				double log_T = log2(m_maxRtt)*fct; // log2(T)*fct
-				double log_B = log2(B)*fct; // log2(B)*fct
-				double log_1e9 = log2(1e9)*fct; // log2(1e9)*fct
-				double qterm = 0;
-				double byteTerm = 0;
-				double uTerm = 0;
-				if ((qlen >> 8) > 0){
-					int log_dt = log2apprx(dt, b, m, l); // ~log2(dt)*fct
-					int log_qlen = log2apprx(qlen >> 8, b, m, l); // ~log2(qlen / 256)*fct
-					qterm = pow(2, (
-								log_dt + log_qlen + log_1e9 - log_B - 2*log_T
-								)/fct
-							) * 256;
-					// 2^((log2(dt)*fct+log2(qlen/256)*fct+log2(1e9)*fct-log2(B)*fct-2*log2(T)*fct)/fct)*256 ~= dt*qlen*1e9/(B*T^2)
-				}
-				if (m_lastPktSize[ifIndex] > 0){
-					int byte = m_lastPktSize[ifIndex];
-					int log_byte = log2apprx(byte, b, m, l);
-					byteTerm = pow(2, (
-								log_byte + log_1e9 - log_B - log_T
-								)/fct
-							);
-					// 2^((log2(byte)*fct+log2(1e9)*fct-log2(B)*fct-log2(T)*fct)/fct) ~= byte*1e9 / (B*T)
-				}
-				if (m_maxRtt > dt && m_u[ifIndex] > 0){
-					int log_T_dt = log2apprx(m_maxRtt - dt, b, m, l); // ~log2(T-dt)*fct
-					int log_u = log2apprx(int(round(m_u[ifIndex] * 8192)), b, m, l); // ~log2(u*512)*fct
-					uTerm = pow(2, (
-								log_T_dt + log_u - log_T
-								)/fct
-							) / 8192;
-					// 2^((log2(T-dt)*fct+log2(u*512)*fct-log2(T)*fct)/fct)/512 = (T-dt)*u/T
-				}
-				newU = qterm+byteTerm+uTerm;
-
-				#if 0
-				/**************************
-				 * accurate calc
-				 *************************/
-				double weight_ewma = double(dt) / m_maxRtt;
-				double u;
-				if (m_lastPktSize[ifIndex] == 0)
-					u = 0;
-				else{
-					double txRate = m_lastPktSize[ifIndex] / double(dt); // B/ns
-					u = (qlen / m_maxRtt + txRate) * 1e9 / B;
-				}
-				newU = m_u[ifIndex] * (1 - weight_ewma) + u * weight_ewma;
-				printf(" %lf\n", newU);
-				#endif
-
-				/************************
-				 * update PINT header
-				 ***********************/
-				uint16_t power = Pint::encode_u(newU);
-				if (power > ih->GetPower())
-					ih->SetPower(power);
-
-				m_u[ifIndex] = newU;
-			}
-		}
-	}
-	#endif
 	m_txBytes[ifIndex] += p->GetSize();
 	m_lastPktSize[ifIndex] = p->GetSize();
 	m_lastPktTs[ifIndex] = Simulator::Now().GetTimeStep();
 }
 
-int SwitchNode::logres_shift(int b, int l){
-	static int data[] = {0,0,1,2,2,3,3,3,3,4,4,4,4,4,4,4,4,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5};
-	return l - data[b];
+bool SwitchNode::IsUdp(Ptr<const Packet> p){
+	PacketMetaTag meta;
+	if (p->PeekPacketTag(meta))
+		return meta.GetL3Prot() == 0x11;
+	CustomHeader ch(CustomHeader::L2_Header | CustomHeader::L3_Header);
+	p->PeekHeader(ch);
+	return ch.l3Prot == 0x11;
 }
 
-int SwitchNode::log2apprx(int x, int b, int m, int l)
-{
-	int x0 = x;
-	int msb = int(log2(x)) + 1;
-	if (msb > m){
-		x = (x >> (msb - m) << (msb - m));
-		#if 0
-		x += + (1 << (msb - m - 1));
-		#else
-		int mask = (1 << (msb-m)) - 1;
-		if ((x0 & mask) > (rand() & mask))
-			x += 1<<(msb-m);
-		#endif
-	}
-	return int(log2(x) * (1<<logres_shift(b, l)));
-}
+void SwitchNode::PushInt(uint32_t ifIndex, Ptr<Packet> p){
+	IntTag tag; // no tag yet: the INT is still empty, as written by the sender
+	p->PeekPacketTag(tag);
+	IntHeader& ih = tag.GetInt();
+	QbbNetDevice* dev = m_ports[ifIndex];
+	if (m_ccMode == 3){ // HPCC
+		ih.PushHop(Simulator::Now().GetTimeStep(), m_txBytes[ifIndex], dev->GetQueue()->GetNBytesTotal(), dev->GetDataRate().GetBitRate());
+	}else { // HPCC-PINT
+		uint64_t t = Simulator::Now().GetTimeStep();
+		uint64_t dt = t - m_lastPktTs[ifIndex];
+		if (dt > m_maxRtt)
+			dt = m_maxRtt;
+		uint64_t qlen = dev->GetQueue()->GetNBytesTotal();
+		const PintPort& c = m_pint[ifIndex];
+
+		/**************************
+		 * approximate calc, in the log domain with the lookup tables of `Pint`
+		 *************************/
+		double qterm = 0;
+		double byteTerm = 0;
+		double uTerm = 0;
+		if ((qlen >> 8) > 0 && dt > 0){
+			qterm = Pint::exp2_lut(Pint::log2_lut(dt) + Pint::log2_lut(qlen >> 8) + c.qterm) * 256;
+			// ~= dt*qlen*1e9/(B*T^2)
+		}
+		if (m_lastPktSize[ifIndex] > 0){
+			byteTerm = Pint::exp2_lut(Pint::log2_lut(m_lastPktSize[ifIndex]) + c.byteTerm);
+			// ~= byte*1e9 / (B*T)
+		}
+		const uint64_t u = uint64_t(round(m_u[ifIndex] * 8192));
+		if (m_maxRtt > dt && u > 0){
+			uTerm = Pint::exp2_lut(Pint::log2_lut(m_maxRtt - dt) + Pint::log2_lut(u) + c.uTerm) / 8192;
+			// ~= (T-dt)*u/T
+		}
+		double newU = qterm+byteTerm+uTerm;
 
+		/************************
+		 * update PINT header
+		 ***********************/
+		uint16_t power = Pint::encode_u(newU);
+		if (power > ih.GetPower())
+			ih.SetPower(power);
+
+		m_u[ifIndex] = newU;
+	}
+	p->ReplacePacketTag(tag);
+}
 
 void SwitchNode::Rebuild(NodeContainer nodes)
 {
@@ -515,6 +537,7 @@ void SwitchNode::Rebuild(NodeContainer nodes)
 
 	ForEachSwitch(nodes, [](Ptr<SwitchNode> sw) {
 		sw->m_uplink.clear();
+		sw->ResizePorts();
 	});
 
 	// First compute the inverse of the depth of each node
@@ -616,25 +639,4 @@ NodeType GetNodeType(Ptr<Node> node)
 	return IsSwitchNode(node) ? NT_SWITCH : NT_SERVER;
 }
 
-bool SwitchSend(Ptr<NetDevice> self, uint32_t qIndex, Ptr<Packet> packet)
-{
-	Ptr<QbbNetDevice> qbb = DynamicCast<QbbNetDevice>(self);
-	NS_ASSERT(qbb);
-	return qbb->SwitchSend(qIndex, packet);
-}
-
-void SwitchNotifyDequeue(Ptr<Node> self, uint32_t ifIndex, uint32_t qIndex, Ptr<Packet> p)
-{
-	Ptr<SwitchNode> sw = DynamicCast<SwitchNode>(self);
-	NS_ASSERT(sw);
-	sw->SwitchNotifyDequeue(ifIndex, qIndex, p);
-}
-
-bool SwitchReceiveFromDevice(Ptr<Node> self, Ptr<NetDevice> device, Ptr<Packet> packet, CustomHeader &ch)
-{
-	Ptr<SwitchNode> sw = DynamicCast<SwitchNode>(self);
-	NS_ASSERT(sw);
-	return sw->SwitchReceiveFromDevice(device, packet, ch);
-}
-
 } /* namespace ns3 */
@@ -7,6 +7,7 @@
 #include "ns3/qbb-net-device.h"
 #include "ns3/switch-mmu.h"
 #include "ns3/pint.h"
+#include "ns3/ecmp-hash.h"
 #include <unordered_map>
 #include <memory>
 #include <vector>
@@ -18,11 +19,6 @@ class Packet;
 class SwitchNode : public Node
 {
 private:
-	/**
-	 *  @brief Number of ports on the switch.
-	 */
-	static const uint32_t pCnt = 257;
-
 	/**
 	 * @brief Number of priority queues (per port).
 	 */
@@ -46,6 +42,27 @@ private:
 	 */
 	std::unordered_map<uint32_t, std::vector<int> > m_rtTable;
 
+	//! Entry of `m_fib` of a destination without route.
+	static constexpr uint32_t NO_ROUTE = UINT32_MAX;
+
+	/**
+	 * @brief Compiled forwarding table, built from `m_rtTable` by `CompileFib()`.
+	 * 
+	 * Node IPs are a function of the node ID (see `IpToNodeId()`), so the table is indexed by the destination node ID.
+	 * `m_fib[id]` is the index in `m_ecmpGroups` of the next hops towards `id`, or `NO_ROUTE`.
+	 * Destinations that are not a node IP are still looked up in `m_rtTable`.
+	 */
+	std::vector<uint32_t> m_fib;
+
+	/**
+	 * @brief Next hops of the compiled forwarding table.
+	 * Destinations reachable by the same next hops, in the same order, share the same group.
+	 */
+	std::vector<std::vector<int>> m_ecmpGroups;
+
+	//! Whether `m_rtTable` changed since the last `CompileFib()`.
+	bool m_fibDirty{true};
+
 	/**
 	 * For each interface, stores whether the link points towards an uplink switch in the topology.
 	 * Used for ECMP.
@@ -63,52 +80,101 @@ private:
 	 */
 	std::unordered_map<uint32_t, std::set<int>> m_ogroups;
 
-	// monitor of PFC
-	uint32_t m_bytes[pCnt][pCnt][qCnt]; // m_bytes[inDev][outDev][qidx] is the bytes from inDev enqueued for outDev at qidx
-	
-	uint64_t m_txBytes[pCnt]; // counter of tx bytes
+	/**
+	 * @brief Devices of the ports, already cast, so the per-packet paths do not need RTTI.
+	 * Null if the device is not a `QbbNetDevice`. Owned by the node.
+	 */
+	std::vector<QbbNetDevice*> m_ports;
+
+	// Per-port counters, sized from `GetNDevices()` in `Rebuild()`.
+	std::vector<uint64_t> m_txBytes; // counter of tx bytes
+	std::vector<uint32_t> m_lastPktSize;
+	std::vector<uint64_t> m_lastPktTs; // ns
+	std::vector<double> m_u;
 
-	uint32_t m_lastPktSize[pCnt];
-	uint64_t m_lastPktTs[pCnt]; // ns
-	double m_u[pCnt];
+	/**
+	 * @brief Constant terms of the PINT utilization of a port, in the fixed-point log domain of `Pint::log2_lut()`.
+	 */
+	struct PintPort {
+		int64_t qterm{}; //!< log2(1e9 / (B * T^2))
+		int64_t byteTerm{}; //!< log2(1e9 / (B * T))
+		int64_t uTerm{}; //!< log2(1 / T)
+	};
+	std::vector<PintPort> m_pint;
 
 protected:
 	/// When true: when congestion is experienced, the switch marks the ECN bit before forwarding the packets to their destination.
 	bool m_ecnEnabled;
 	uint32_t m_ccMode;
-	uint64_t m_maxRtt;
+	uint64_t m_maxRtt{};
 
 	uint32_t m_ackHighPrio; // set high priority for ACK/NACK
 
 private:
-	//! Packets of a multicast, or every packets of a unicast to dequeue.
-	//! Permits to know when to release ingress memory.
-	std::unordered_map<Ptr<Packet>, std::shared_ptr<int>> m_egress_lasts;
+	/**
+	 * @brief Pool of reference counts shared by the copies of a multicast packet.
+	 * 
+	 * Permits to know when the last copy is dequeued, to release ingress memory.
+	 * A slot is referenced by the `SwitchIngressTag` of each copy.
+	 * Slot zero is never used: a packet with a single copy (e.g. unicast) has no reference count.
+	 */
+	std::vector<uint32_t> m_replicaRefs{0};
+	std::vector<uint32_t> m_replicaFree; //!< Free slots of `m_replicaRefs`.
+
+	uint32_t AllocReplica(uint32_t count);
+	bool ReleaseReplica(uint32_t replica);
 
 private:
-	int GetOutDev(Ptr<const Packet>, CustomHeader &ch);
-	void SendToDev(Ptr<Packet>p, CustomHeader &ch);
-	void SendMultiToDevs(Ptr<Packet> p, CustomHeader& ch, int in_inface);
-	static uint32_t EcmpHash(const uint8_t* key, size_t len, uint32_t seed);
+	int GetOutDev(CustomHeader &ch, const EcmpFlowKey& key);
+	void SendToDev(Ptr<Packet>p, CustomHeader &ch, const EcmpFlowKey& key);
+	void SendMultiToDevs(Ptr<Packet> p, CustomHeader& ch, int in_inface, const EcmpFlowKey& key);
+	static EcmpFlowKey GetFlowKey(const CustomHeader& ch);
 	void CheckAndSendPfc(uint32_t inDev, uint32_t qIndex);
 	void CheckAndSendResume(uint32_t inDev, uint32_t qIndex);
+	static bool IsUdp(Ptr<const Packet> p);
+
+	/**
+	 * @brief Write the INT of the egress port in the `IntTag` of a data packet (HPCC and HPCC-PINT).
+	 * @param p Should not be shared with other copies of a multicast packet.
+	 */
+	void PushInt(uint32_t ifIndex, Ptr<Packet> p);
+	void ResizePorts();
+
+	/**
+	 * @brief Computes `m_pint` from the ports and `m_maxRtt`.
+	 * Called again when the "MaxRtt" attribute is set, which happens after `Rebuild()` once the RTTs are known.
+	 */
+	void UpdatePintTerms();
+	void SetMaxRtt(uint64_t maxRtt);
+	uint64_t GetMaxRtt() const;
 
 public:
 	Ptr<SwitchMmu> m_mmu;
 
 	static TypeId GetTypeId (void);
 	SwitchNode();
+	/**
+	 * @param systemId MPI system ID of the process that simulates the switch (see `Node::Node(uint32_t)`).
+	 */
+	explicit SwitchNode(uint32_t systemId);
 	void SetEcmpSeed(uint32_t seed);
 	void AddTableEntry(Ipv4Address &dstAddr, uint32_t intf_idx);
 	void ClearTable();
+
+	/**
+	 * @brief Build the compiled forwarding table from the entries added by `AddTableEntry()`.
+	 * Done lazily on the first lookup if the table changed, but can be called once all entries are added.
+	 */
+	void CompileFib();
 	bool SwitchReceiveFromDevice(Ptr<NetDevice> device, Ptr<Packet> packet, CustomHeader &ch);
-	void SwitchNotifyDequeue(uint32_t ifIndex, uint32_t qIndex, Ptr<Packet> p);
+	/**
+	 * @param p The dequeued packet. The copies of a multicast packet share the same packet,
+	 * so `p` is replaced by a private copy before being modified.
+	 */
+	void SwitchNotifyDequeue(uint32_t ifIndex, uint32_t qIndex, Ptr<Packet>& p);
 
 	void OnPeerJoinGroup(uint32_t ifIndex, uint32_t group);
 
-	// for approximate calc in PINT
-	int logres_shift(int b, int l);
-	int log2apprx(int x, int b, int m, int l); // given x of at most b bits, use most significant m bits of x, calc the result in l bits
 
 	/**
 	 * Rebuild some information in the nodes.
@@ -130,9 +196,6 @@ enum NodeType {
 
 bool IsSwitchNode(Ptr<Node> self);
 NodeType GetNodeType(Ptr<Node> self);
-bool SwitchSend(Ptr<NetDevice> self, uint32_t qIndex, Ptr<Packet> packet);
-void SwitchNotifyDequeue(Ptr<Node> self, uint32_t ifIndex, uint32_t qIndex, Ptr<Packet> p);
-bool SwitchReceiveFromDevice(Ptr<Node> self, Ptr<NetDevice> device, Ptr<Packet> packet, CustomHeader &ch);
 
 
 /**
@@ -0,0 +1,176 @@
+#include "ns3/test.h"
+#include "ns3/map-scheduler.h"
+#include "ns3/rdma-ladder-scheduler.h"
+#include <cstdint>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * @brief The ladder pops the events in the same order as the `MapScheduler`,
+ * for a random sequence of insertions, cancellations and removals.
+ *
+ * The delays mimic the fabric: dense clusters within a few microseconds, some timers, rare far events,
+ * and bursts of events at the same time, ordered by their UID.
+ */
+class RdmaLadderSchedulerOrderTestCase : public TestCase
+{
+public:
+	/**
+	 * @param seed Seed of the sequence of operations.
+	 * @param ops Count of operations.
+	 */
+	RdmaLadderSchedulerOrderTestCase(uint32_t seed, uint32_t ops);
+
+private:
+	void DoRun() override;
+
+	//! Inserts a new event in both schedulers.
+	void Insert();
+
+	//! Removes the next event of both schedulers, and checks they are the same.
+	void RemoveNext();
+
+	//! Cancels a random pending event in both schedulers.
+	void Remove();
+
+	//! Delay of the next event after now, in time steps.
+	uint64_t NextDelay();
+
+	uint32_t m_ops;
+	std::mt19937_64 m_rng;
+	Ptr<Scheduler> m_ladder;
+	Ptr<Scheduler> m_map;
+	uint64_t m_now{0};
+	uint32_t m_uid{0};
+	std::vector<Scheduler::Event> m_pending;                //!< Events in both schedulers.
+	std::unordered_map<uint32_t, size_t> m_pending_index;   //!< Index in `m_pending` of each UID.
+};
+
+RdmaLadderSchedulerOrderTestCase::RdmaLadderSchedulerOrderTestCase(uint32_t seed, uint32_t ops)
+	: TestCase("Same order as MapScheduler, seed " + std::to_string(seed)),
+	  m_ops{ops},
+	  m_rng{seed}
+{
+}
+
+uint64_t RdmaLadderSchedulerOrderTestCase::NextDelay()
+{
+	const uint32_t kind = m_rng() % 100;
+	if (kind < 10) {
+		return 0; // Same time as now
+	}
+	if (kind < 70) {
+		return m_rng() % 5'000; // Serialization, propagation
+	}
+	if (kind < 95) {
+		return m_rng() % 1'000'000; // Timers
+	}
+	return m_rng() % 10'000'000'000ULL; // Far events
+}
+
+void RdmaLadderSchedulerOrderTestCase::Insert()
+{
+	// Sometimes a burst of events at the same time
+	const uint64_t ts = m_now + NextDelay();
+	const uint32_t count = m_rng() % 50 == 0 ? 1 + m_rng() % 50 : 1;
+	for (uint32_t n = 0; n < count; n++) {
+		Scheduler::Event ev;
+		ev.impl = nullptr;
+		ev.key.m_ts = ts;
+		ev.key.m_uid = m_uid++;
+		ev.key.m_context = 0;
+		m_ladder->Insert(ev);
+		m_map->Insert(ev);
+		m_pending_index[ev.key.m_uid] = m_pending.size();
+		m_pending.push_back(ev);
+	}
+}
+
+void RdmaLadderSchedulerOrderTestCase::RemoveNext()
+{
+	NS_TEST_ASSERT_MSG_EQ(m_ladder->IsEmpty(), m_map->IsEmpty(), "Both schedulers should be empty or not");
+	if (m_map->IsEmpty()) {
+		return;
+	}
+
+	NS_TEST_ASSERT_MSG_EQ(m_ladder->PeekNext().key.m_uid, m_map->PeekNext().key.m_uid, "Both schedulers should peek the same event");
+	const Scheduler::Event ladder = m_ladder->RemoveNext();
+	const Scheduler::Event map = m_map->RemoveNext();
+	NS_TEST_ASSERT_MSG_EQ(ladder.key.m_uid, map.key.m_uid, "Both schedulers should remove the same event");
+	NS_TEST_ASSERT_MSG_EQ(ladder.key.m_ts, map.key.m_ts, "Both schedulers should remove the same event");
+	m_now = map.key.m_ts;
+
+	// Swap with the last pending event
+	const size_t index = m_pending_index.at(map.key.m_uid);
+	m_pending[index] = m_pending.back();
+	m_pending_index[m_pending[index].key.m_uid] = index;
+	m_pending.pop_back();
+	m_pending_index.erase(map.key.m_uid);
+}
+
+void RdmaLadderSchedulerOrderTestCase::Remove()
+{
+	if (m_pending.empty()) {
+		return;
+	}
+
+	const size_t index = m_rng() % m_pending.size();
+	const Scheduler::Event ev = m_pending[index];
+	m_ladder->Remove(ev);
+	m_map->Remove(ev);
+
+	m_pending[index] = m_pending.back();
+	m_pending_index[m_pending[index].key.m_uid] = index;
+	m_pending.pop_back();
+	m_pending_index.erase(ev.key.m_uid);
+}
+
+void RdmaLadderSchedulerOrderTestCase::DoRun()
+{
+	m_ladder = CreateObject<RdmaLadderScheduler>();
+	m_map = CreateObject<MapScheduler>();
+
+	// Enough events to spread the top list into rungs
+	while (m_pending.size() < 10'000) {
+		Insert();
+	}
+
+	for (uint32_t op = 0; op < m_ops; op++) {
+		// About as many insertions as removals, around the initial population
+		const uint32_t kind = m_rng() % 100;
+		if (kind < 40) {
+			Insert();
+		}
+		else if (kind < 85) {
+			RemoveNext();
+		}
+		else {
+			Remove();
+		}
+	}
+
+	// Drain
+	while (!m_map->IsEmpty()) {
+		RemoveNext();
+	}
+	NS_TEST_ASSERT_MSG_EQ(m_ladder->IsEmpty(), true, "The ladder should be empty");
+	NS_TEST_ASSERT_MSG_EQ(m_pending.empty(), true, "All the events should be removed");
+}
+
+class RdmaLadderSchedulerTestSuite : public TestSuite
+{
+public:
+	RdmaLadderSchedulerTestSuite()
+		: TestSuite("rdma-ladder-scheduler", UNIT)
+	{
+		for (uint32_t seed = 1; seed <= 4; seed++) {
+			AddTestCase(new RdmaLadderSchedulerOrderTestCase(seed, 200'000), TestCase::QUICK);
+		}
+	}
+};
+
+static RdmaLadderSchedulerTestSuite g_rdmaLadderSchedulerTestSuite;
@@ -0,0 +1,119 @@
+#include "ns3/test.h"
+#include "ns3/packet-meta-tag.h"
+#include "ns3/rdma-packet-template.h"
+#include "ns3/custom-header.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/ppp-header.h"
+
+using namespace ns3;
+
+/**
+ * @brief `PacketMetaTag::MarkCe()` marks CE in the IPv4 header of the buffer, with a valid checksum,
+ * and in the tag.
+ */
+class PacketMetaTagMarkCeTestCase : public TestCase
+{
+public:
+	PacketMetaTagMarkCeTestCase();
+
+private:
+	void DoRun() override;
+
+	/**
+	 * @brief Check the PPP and IPv4 headers of `p` after the marking.
+	 */
+	void CheckHeaders(Ptr<const Packet> p, const Ipv4Header& sent, uint32_t size);
+};
+
+PacketMetaTagMarkCeTestCase::PacketMetaTagMarkCeTestCase()
+	: TestCase("Mark CE in the IPv4 header and in the tag")
+{
+}
+
+void PacketMetaTagMarkCeTestCase::CheckHeaders(Ptr<const Packet> p, const Ipv4Header& sent, uint32_t size)
+{
+	NS_TEST_EXPECT_MSG_EQ(p->GetSize(), size, "The size should not change");
+
+	Ptr<Packet> copy = p->Copy();
+	PppHeader ppp;
+	copy->RemoveHeader(ppp);
+	NS_TEST_EXPECT_MSG_EQ(ppp.GetProtocol(), 0x0021, "The PPP header should not change");
+
+	Ipv4Header ip;
+	ip.EnableChecksum();
+	copy->RemoveHeader(ip);
+	NS_TEST_EXPECT_MSG_EQ(ip.GetEcn(), Ipv4Header::ECN_CE, "The packet should be marked");
+	NS_TEST_EXPECT_MSG_EQ(ip.GetDscp(), sent.GetDscp(), "The DSCP should not change");
+	NS_TEST_EXPECT_MSG_EQ(ip.IsChecksumOk(), true, "The checksum should be updated");
+	NS_TEST_EXPECT_MSG_EQ(ip.GetSource(), sent.GetSource(), "The other fields should not change");
+	NS_TEST_EXPECT_MSG_EQ(ip.GetDestination(), sent.GetDestination(), "The other fields should not change");
+	NS_TEST_EXPECT_MSG_EQ(ip.GetTtl(), sent.GetTtl(), "The other fields should not change");
+}
+
+void PacketMetaTagMarkCeTestCase::DoRun()
+{
+	// Headers with a checksum, and a tag
+	Ipv4Header ip;
+	ip.EnableChecksum();
+	ip.SetSource(Ipv4Address("11.0.0.1"));
+	ip.SetDestination(Ipv4Address("11.0.1.1"));
+	ip.SetProtocol(0x11);
+	ip.SetTtl(64);
+	ip.SetDscp(Ipv4Header::DSCP_AF21);
+	ip.SetEcn(Ipv4Header::ECN_ECT0);
+	ip.SetPayloadSize(1000);
+	PppHeader ppp;
+	ppp.SetProtocol(0x0021);
+
+	Ptr<Packet> p = Create<Packet>(1000);
+	p->AddHeader(ip);
+	p->AddHeader(ppp);
+	p->AddPacketTag(PacketMetaTag(0x11, ip.GetSource().Get(), ip.GetDestination().Get(), 1000, 2000, 3));
+	const uint32_t size = p->GetSize();
+
+	// A replica sharing the buffer is not marked
+	Ptr<Packet> replica = p->Copy();
+	PacketMetaTag::MarkCe(p);
+	CheckHeaders(p, ip, size);
+
+	PacketMetaTag meta;
+	NS_TEST_ASSERT_MSG_EQ(p->PeekPacketTag(meta), true, "The tag should be kept");
+	NS_TEST_EXPECT_MSG_EQ((meta.GetTos() & 0x3), CustomHeader::ECN_CE, "The tag should be marked");
+	NS_TEST_EXPECT_MSG_EQ(replica->PeekPacketTag(meta), true, "The tag of the replica should be kept");
+	NS_TEST_EXPECT_MSG_EQ((meta.GetTos() & 0x3), 0, "The tag of the replica should not be marked");
+
+	CustomHeader ch(CustomHeader::L2_Header | CustomHeader::L3_Header);
+	replica->PeekHeader(ch);
+	NS_TEST_EXPECT_MSG_EQ(ch.GetIpv4EcnBits(), Ipv4Header::ECN_ECT0, "The replica should not be marked");
+
+	// Marking twice is the same as once
+	PacketMetaTag::MarkCe(p);
+	CheckHeaders(p, ip, size);
+
+	// Template packets have no checksum, nor tag
+	RdmaPacketTemplate tmpl;
+	tmpl.InitData(Ipv4Address("11.0.0.1"), 1000, 3);
+	Ptr<Packet> data = tmpl.MakeData(Ipv4Address("11.0.1.1"), 2000, 0, 0, 1000);
+	const uint32_t dataSize = data->GetSize();
+	PacketMetaTag::MarkCe(data);
+	NS_TEST_EXPECT_MSG_EQ(data->GetSize(), dataSize, "The size should not change");
+
+	CustomHeader dataCh(CustomHeader::L2_Header | CustomHeader::L3_Header | CustomHeader::L4_Header);
+	data->PeekHeader(dataCh);
+	NS_TEST_EXPECT_MSG_EQ(dataCh.GetIpv4EcnBits(), Ipv4Header::ECN_CE, "The template packet should be marked");
+	NS_TEST_EXPECT_MSG_EQ(dataCh.m_checksum, 0, "No checksum should be written if none was computed");
+	NS_TEST_EXPECT_MSG_EQ(dataCh.dip, Ipv4Address("11.0.1.1").Get(), "The other fields should not change");
+	NS_TEST_EXPECT_MSG_EQ(dataCh.udp.dport, 2000, "The other fields should not change");
+}
+
+class PacketMetaTagTestSuite : public TestSuite
+{
+public:
+	PacketMetaTagTestSuite()
+		: TestSuite("rdma-packet-meta-tag", UNIT)
+	{
+		AddTestCase(new PacketMetaTagMarkCeTestCase, TestCase::QUICK);
+	}
+};
+
+static PacketMetaTagTestSuite g_packetMetaTagTestSuite;
@@ -0,0 +1,111 @@
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/rdma-packet-template.h"
+#include "ns3/custom-header.h"
+#include "ns3/qbb-header.h"
+#include "ns3/int-header.h"
+#include <utility>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * @brief In `IntHeader::TS` mode, each data packet carries its own send time, and the ACK echoes it (TIMELY, Swift),
+ * although the headers of the template are serialized once, when the QP is set up.
+ */
+class RdmaPacketTemplateTsTestCase : public TestCase
+{
+public:
+	RdmaPacketTemplateTsTestCase();
+
+private:
+	void DoRun() override;
+
+	void Init();
+	void Send();
+	void Ack();
+
+	/**
+	 * @return The INT timestamp of a data packet (`l3Prot` 0x11) or of an ACK.
+	 */
+	static Time GetTs(Ptr<const Packet> p);
+
+	RdmaPacketTemplate m_data;
+	RdmaPacketTemplate m_ack;
+	std::vector<std::pair<Time, Ptr<Packet>>> m_sent; //!< Data packets, with their send time.
+};
+
+RdmaPacketTemplateTsTestCase::RdmaPacketTemplateTsTestCase()
+	: TestCase("Data packets carry their send time, echoed by the ACKs")
+{
+}
+
+Time RdmaPacketTemplateTsTestCase::GetTs(Ptr<const Packet> p)
+{
+	CustomHeader ch(CustomHeader::L2_Header | CustomHeader::L3_Header | CustomHeader::L4_Header);
+	p->PeekHeader(ch);
+	return TimeStep(ch.l3Prot == 0x11 ? ch.udp.ih.ts : ch.ack.ih.ts);
+}
+
+void RdmaPacketTemplateTsTestCase::Init()
+{
+	m_data.InitData(Ipv4Address("11.0.0.1"), 1000, 3);
+	m_ack.InitAck(Ipv4Address("11.0.1.1"), Ipv4Address("11.0.0.1"));
+}
+
+void RdmaPacketTemplateTsTestCase::Send()
+{
+	const uint32_t psn = m_sent.size() * 1000;
+	Ptr<Packet> p = m_data.MakeData(Ipv4Address("11.0.1.1"), 2000, psn, m_sent.size(), 1000);
+	NS_TEST_EXPECT_MSG_EQ(GetTs(p), Simulator::Now(), "The data packet should carry its send time");
+	m_sent.emplace_back(Simulator::Now(), p);
+}
+
+void RdmaPacketTemplateTsTestCase::Ack()
+{
+	uint16_t ipid = 0;
+	for (const auto& [sent, p] : m_sent) {
+		// As `RdmaReliableRQ::Receive()`
+		CustomHeader ch(CustomHeader::L2_Header | CustomHeader::L3_Header | CustomHeader::L4_Header);
+		p->PeekHeader(ch);
+
+		qbbHeader seqh;
+		seqh.SetSeq(ch.udp.seq);
+		seqh.SetPG(ch.udp.pg);
+		seqh.SetSport(ch.udp.dport);
+		seqh.SetDport(ch.udp.sport);
+		seqh.SetIntHeader(ch.udp.ih);
+
+		Ptr<Packet> ack = m_ack.MakeAck(0xFC, ipid++, seqh);
+		NS_TEST_EXPECT_MSG_EQ(GetTs(ack), sent, "The ACK should echo the send time of its data packet");
+	}
+}
+
+void RdmaPacketTemplateTsTestCase::DoRun()
+{
+	const IntHeader::Mode mode = IntHeader::mode;
+	IntHeader::mode = IntHeader::TS;
+
+	Simulator::Schedule(MicroSeconds(1), &RdmaPacketTemplateTsTestCase::Init, this);
+	Simulator::Schedule(MicroSeconds(3), &RdmaPacketTemplateTsTestCase::Send, this);
+	Simulator::Schedule(MicroSeconds(8), &RdmaPacketTemplateTsTestCase::Send, this);
+	Simulator::Schedule(MicroSeconds(20), &RdmaPacketTemplateTsTestCase::Send, this);
+	Simulator::Schedule(MicroSeconds(25), &RdmaPacketTemplateTsTestCase::Ack, this);
+	Simulator::Run();
+	Simulator::Destroy();
+
+	NS_TEST_EXPECT_MSG_EQ(m_sent.size(), 3, "All the data packets should be sent");
+	IntHeader::mode = mode;
+}
+
+class RdmaPacketTemplateTestSuite : public TestSuite
+{
+public:
+	RdmaPacketTemplateTestSuite()
+		: TestSuite("rdma-packet-template", UNIT)
+	{
+		AddTestCase(new RdmaPacketTemplateTsTestCase, TestCase::QUICK);
+	}
+};
+
+static RdmaPacketTemplateTestSuite g_rdmaPacketTemplateTestSuite;
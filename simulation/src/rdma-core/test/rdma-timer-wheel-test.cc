@@ -0,0 +1,259 @@
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/rdma-timer-wheel.h"
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace ns3;
+
+namespace {
+
+/**
+ * @return The time a timer armed at `armed` and expiring at `expiry` fires:
+ * the end of its tick, and at least the next tick after `armed`.
+ */
+Time FireTime(Time armed, Time expiry, Time tick)
+{
+	if (tick.IsZero()) {
+		return expiry;
+	}
+	const int64_t step = tick.GetTimeStep();
+	const int64_t fire = std::max((expiry.GetTimeStep() + step - 1) / step, armed.GetTimeStep() / step + 1);
+	return TimeStep(fire * step);
+}
+
+} // namespace
+
+/**
+ * @brief The timers fire once, at the end of the tick of their expiration, from all the levels of the wheel.
+ *
+ * The delays cross the boundaries of the levels, so the timers of the upper levels cascade
+ * down to the first level, and the farthest one is beyond the range of the wheel.
+ */
+class RdmaTimerWheelCascadeTestCase : public TestCase
+{
+public:
+	/**
+	 * @param tickNs Resolution of the wheel in nanoseconds, zero to disable it.
+	 */
+	explicit RdmaTimerWheelCascadeTestCase(uint32_t tickNs);
+
+private:
+	void DoRun() override;
+
+	uint32_t m_tickNs; //!< The time resolution is not set yet when the suite is built.
+	Time m_tick;
+};
+
+RdmaTimerWheelCascadeTestCase::RdmaTimerWheelCascadeTestCase(uint32_t tickNs)
+	: TestCase("Cascade across the levels, tick of " + std::to_string(tickNs) + " ns"),
+	  m_tickNs{tickNs}
+{
+}
+
+void RdmaTimerWheelCascadeTestCase::DoRun()
+{
+	m_tick = NanoSeconds(m_tickNs);
+	const Time start = NanoSeconds(3);
+	const uint64_t slots = RdmaTimerWheel::slots;
+	const std::vector<uint64_t> ticks{
+		0, 1, 2, slots - 1, slots, slots + 1, 3 * slots + 7,
+		slots * slots - 1, slots * slots, slots * slots + slots + 1,
+		slots * slots * slots + 5, slots * slots * slots * slots + 11 // Beyond the range
+	};
+
+	RdmaTimerWheel wheel;
+	wheel.Configure(m_tick);
+	std::deque<RdmaTimer> timers(ticks.size());
+	std::vector<Time> expiry(ticks.size());
+	std::vector<Time> fired(ticks.size(), Time::Max());
+	std::vector<uint32_t> count(ticks.size(), 0);
+
+	Simulator::Schedule(start, [&] {
+		// Not aligned on the ticks, and armed from the farthest
+		const int64_t step = m_tick.IsZero() ? 1 : m_tick.GetTimeStep();
+		for (size_t i = ticks.size(); i-- > 0;) {
+			const Time delay = TimeStep(ticks[i] * step + i % 3);
+			expiry[i] = Simulator::Now() + delay;
+			wheel.Schedule(timers[i], delay, [&, i] {
+				fired[i] = Simulator::Now();
+				count[i]++;
+			});
+		}
+	});
+	Simulator::Run();
+
+	for (size_t i = 0; i < ticks.size(); i++) {
+		NS_TEST_EXPECT_MSG_EQ(count[i], 1, "Timer " << i << " should fire once");
+		NS_TEST_EXPECT_MSG_EQ(fired[i], FireTime(start, expiry[i], m_tick), "Timer " << i << " should fire at the end of its tick");
+		NS_TEST_EXPECT_MSG_EQ(timers[i].IsRunning(), false, "Timer " << i << " should be disarmed");
+	}
+	NS_TEST_EXPECT_MSG_EQ(wheel.GetStats().arms, ticks.size(), "Each timer is armed once");
+	NS_TEST_EXPECT_MSG_EQ(wheel.GetStats().expirations, ticks.size(), "Each timer expires once");
+	NS_TEST_EXPECT_MSG_EQ(wheel.GetStats().cancels, 0, "No timer is cancelled");
+
+	Simulator::Destroy();
+}
+
+/**
+ * @brief The cancelled timers never fire: cancelled directly, by their destruction,
+ * by a timer firing in the same tick, or by clearing the wheel.
+ */
+class RdmaTimerWheelCancelTestCase : public TestCase
+{
+public:
+	explicit RdmaTimerWheelCancelTestCase(uint32_t tickNs);
+
+private:
+	void DoRun() override;
+
+	uint32_t m_tickNs;
+	Time m_tick;
+};
+
+RdmaTimerWheelCancelTestCase::RdmaTimerWheelCancelTestCase(uint32_t tickNs)
+	: TestCase("Cancel, tick of " + std::to_string(tickNs) + " ns"),
+	  m_tickNs{tickNs}
+{
+}
+
+void RdmaTimerWheelCancelTestCase::DoRun()
+{
+	m_tick = NanoSeconds(m_tickNs);
+	RdmaTimerWheel wheel;
+	wheel.Configure(m_tick);
+	std::vector<std::string> fired;
+
+	RdmaTimer kept, cancelled, far, sameTickFirst, sameTickSecond;
+	auto destroyed = std::make_unique<RdmaTimer>();
+
+	wheel.Schedule(kept, MicroSeconds(5), [&] { fired.push_back("kept"); });
+	wheel.Schedule(cancelled, MicroSeconds(3), [&] { fired.push_back("cancelled"); });
+	wheel.Schedule(*destroyed, MicroSeconds(4), [&] { fired.push_back("destroyed"); });
+	wheel.Schedule(far, Seconds(1), [&] { fired.push_back("far"); });
+	// Same expiration: the first armed fires first, and cancels the second
+	wheel.Schedule(sameTickFirst, MicroSeconds(7), [&] {
+		fired.push_back("sameTickFirst");
+		sameTickSecond.Cancel();
+	});
+	wheel.Schedule(sameTickSecond, MicroSeconds(7), [&] { fired.push_back("sameTickSecond"); });
+
+	Simulator::Schedule(MicroSeconds(1), [&] {
+		cancelled.Cancel();
+		destroyed.reset();
+	});
+	Simulator::Schedule(MicroSeconds(10), [&] { far.Cancel(); });
+	Simulator::Run();
+
+	NS_TEST_ASSERT_MSG_EQ(fired.size(), 2, "Only two timers should fire");
+	NS_TEST_EXPECT_MSG_EQ(fired[0], "kept", "The kept timer should fire first");
+	NS_TEST_EXPECT_MSG_EQ(fired[1], "sameTickFirst", "The first timer of the tick should fire");
+	NS_TEST_EXPECT_MSG_EQ(wheel.GetStats().cancels, 4, "Four timers are cancelled");
+
+	// Clearing the wheel disarms the timers
+	wheel.Schedule(kept, MicroSeconds(1), [&] { fired.push_back("cleared"); });
+	wheel.Clear();
+	NS_TEST_EXPECT_MSG_EQ(kept.IsRunning(), false, "Clear should disarm the timers");
+	Simulator::Run();
+	NS_TEST_EXPECT_MSG_EQ(fired.size(), 2, "A cleared timer should not fire");
+
+	Simulator::Destroy();
+}
+
+/**
+ * @brief Re-arming an armed timer moves it, earlier or later, and it fires once at its last expiration.
+ * A timer re-armed by its own callback fires periodically.
+ */
+class RdmaTimerWheelRescheduleTestCase : public TestCase
+{
+public:
+	explicit RdmaTimerWheelRescheduleTestCase(uint32_t tickNs);
+
+private:
+	void DoRun() override;
+
+	uint32_t m_tickNs;
+	Time m_tick;
+};
+
+RdmaTimerWheelRescheduleTestCase::RdmaTimerWheelRescheduleTestCase(uint32_t tickNs)
+	: TestCase("Reschedule, tick of " + std::to_string(tickNs) + " ns"),
+	  m_tickNs{tickNs}
+{
+}
+
+void RdmaTimerWheelRescheduleTestCase::DoRun()
+{
+	m_tick = NanoSeconds(m_tickNs);
+	RdmaTimerWheel wheel;
+	wheel.Configure(m_tick);
+
+	RdmaTimer earlier, later, pushed, periodic;
+	std::vector<Time> earlierFired, laterFired, pushedFired, periodicFired;
+
+	// Re-armed earlier, from an upper level to the first one
+	wheel.Schedule(earlier, MilliSeconds(50), [&] { earlierFired.push_back(Time::Max()); });
+	wheel.Schedule(earlier, MicroSeconds(2), [&] { earlierFired.push_back(Simulator::Now()); });
+
+	// Re-armed later, from the first level to an upper one
+	wheel.Schedule(later, MicroSeconds(2), [&] { laterFired.push_back(Time::Max()); });
+	wheel.Schedule(later, MilliSeconds(3), [&] { laterFired.push_back(Simulator::Now()); });
+
+	// Pushed back before each expiration, as the retransmission timeout by the ACKs
+	for (int i = 0; i < 100; i++) {
+		Simulator::Schedule(MicroSeconds(i), [&] {
+			wheel.Schedule(pushed, MicroSeconds(20), [&] { pushedFired.push_back(Simulator::Now()); });
+		});
+	}
+
+	// Re-armed by its own callback
+	std::function<void()> tick = [&] {
+		periodicFired.push_back(Simulator::Now());
+		if (periodicFired.size() < 5) {
+			wheel.Schedule(periodic, MicroSeconds(55), tick);
+		}
+	};
+	wheel.Schedule(periodic, MicroSeconds(55), tick);
+
+	Simulator::Run();
+
+	NS_TEST_ASSERT_MSG_EQ(earlierFired.size(), 1, "The timer re-armed earlier should fire once");
+	NS_TEST_EXPECT_MSG_EQ(earlierFired[0], FireTime(Time{}, MicroSeconds(2), m_tick), "The timer re-armed earlier should fire at its new time");
+	NS_TEST_ASSERT_MSG_EQ(laterFired.size(), 1, "The timer re-armed later should fire once");
+	NS_TEST_EXPECT_MSG_EQ(laterFired[0], FireTime(Time{}, MilliSeconds(3), m_tick), "The timer re-armed later should fire at its new time");
+	NS_TEST_ASSERT_MSG_EQ(pushedFired.size(), 1, "The pushed back timer should fire once");
+	NS_TEST_EXPECT_MSG_EQ(pushedFired[0], FireTime(MicroSeconds(99), MicroSeconds(99 + 20), m_tick), "The pushed back timer should fire after the last re-arm");
+
+	NS_TEST_ASSERT_MSG_EQ(periodicFired.size(), 5, "The periodic timer should fire five times");
+	Time expiry{};
+	for (const Time& t : periodicFired) {
+		// Re-armed when it fires, so the rounding to the tick accumulates
+		expiry = FireTime(expiry, expiry + MicroSeconds(55), m_tick);
+		NS_TEST_EXPECT_MSG_EQ(t, expiry, "The periodic timer should fire one period after its last firing");
+	}
+	NS_TEST_EXPECT_MSG_EQ(periodic.IsRunning(), false, "The periodic timer should be disarmed");
+
+	Simulator::Destroy();
+}
+
+class RdmaTimerWheelTestSuite : public TestSuite
+{
+public:
+	RdmaTimerWheelTestSuite()
+		: TestSuite("rdma-timer-wheel", UNIT)
+	{
+		// Disabled, 1 ns, and a tick that does not divide the delays
+		for (uint32_t tick : {0, 1, 7}) {
+			AddTestCase(new RdmaTimerWheelCascadeTestCase(tick), TestCase::QUICK);
+			AddTestCase(new RdmaTimerWheelCancelTestCase(tick), TestCase::QUICK);
+			AddTestCase(new RdmaTimerWheelRescheduleTestCase(tick), TestCase::QUICK);
+		}
+	}
+};
+
+static RdmaTimerWheelTestSuite g_rdmaTimerWheelTestSuite;